@@ -0,0 +1,198 @@
+// replay a recorded IMU log through the kiss_ahrs filters, on a computer, and compare them with the
+// reference orientation recorded in the log (for example from Adafruit_NXPSensorFusion):
+//
+//   g++ -O2 -std=c++11 -I../src ahrs_log_replay.cpp ../src/kiss_clang_3d.cpp ../src/kiss_ahrs.cpp -o ahrs_log_replay
+//   ./ahrs_log_replay 100 [kp] [ki] [beta] [convergence_s] < log.csv
+//
+// the arguments are the (fixed) filter update rate in Hz, and optionally the gains of the filters
+// (the defaults of mahony_init and madgwick_init otherwise) and the convergence window in s, not
+// counted in the errors (30 s by default; with the default gains, the filters take about 2 minutes to
+// converge from a large error). The log lines to use start with "IMU,", the other lines are ignored,
+// so that the raw serial output of recipe_artemis_LIS3MDL_ISM330DHCX (with log_imu_samples set) can
+// be used directly:
+//
+//   IMU,micros,gyr_x,gyr_y,gyr_z,acc_x,acc_y,acc_z,mag_x,mag_y,mag_z,q_r,q_i,q_j,q_k
+//
+// with the gyro in rad/s, the accel and mag in any unit, and the reference quaternion.
+//
+// the filters and the reference may not use the same axes conventions, so that their outputs differ
+// by a fixed rotation, either of the sensor axes (q_filter = q_ref * q_off) or of the earth axes
+// (q_filter = q_off * q_ref, for example NED vs z up). After the convergence window, both offsets of
+// each filter are averaged over an offset window, the errors are then computed to the reference
+// corrected by each, and the side that fits best is reported. An offset on both sides at once is not
+// estimated.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+
+#include "kiss_ahrs.h"
+
+using namespace kiss3d;
+
+// rotation angle between 2 unit quaternions, well conditioned also for close quaternions
+static double angle_between(quat_t<float> const * q_1, quat_t<float> const * q_2){
+    double const sign = (quat_dot(q_1, q_2) < 0.0f) ? -1.0 : 1.0;
+    double const dr = q_1->r - sign * q_2->r;
+    double const di = q_1->i - sign * q_2->i;
+    double const dj = q_1->j - sign * q_2->j;
+    double const dk = q_1->k - sign * q_2->k;
+    return 4.0 * asin(fmin(1.0, 0.5 * sqrt(dr * dr + di * di + dj * dj + dk * dk)));
+}
+
+// the errors with the offset on one side
+struct SideErrors{
+    // sum of the offsets to the reference, sign aligned on the first one, then their mean
+    quat_t<float> offset {0.0f, 0.0f, 0.0f, 0.0f};
+    double sum {0.0};
+    double max {0.0};
+};
+
+struct ErrorStats{
+    double update_us {0.0};
+    SideErrors sensor_side;
+    SideErrors earth_side;
+};
+
+// the offset of q_filter to q_ref, q_ref^-1 * q_filter on the sensor side or q_filter * q_ref^-1 on
+// the earth side
+static void offset_to_reference(quat_t<float> const * q_ref, quat_t<float> const * q_filter, bool const earth_side, quat_t<float> * q_off){
+    quat_t<float> q_ref_inv;
+    quat_copy(q_ref, &q_ref_inv);
+    unit_quat_inv(&q_ref_inv);
+    if (earth_side){
+        quat_prod(q_filter, &q_ref_inv, q_off);
+    }
+    else{
+        quat_prod(&q_ref_inv, q_filter, q_off);
+    }
+}
+
+static void accumulate_offset(quat_t<float> const * q_ref, quat_t<float> const * q_filter, bool const earth_side, SideErrors * side){
+    quat_t<float> q_off;
+    offset_to_reference(q_ref, q_filter, earth_side, &q_off);
+
+    // q and -q are the same rotation: add them all on the same side
+    float const sign = (quat_dot(&q_off, &side->offset) < 0.0f) ? -1.0f : 1.0f;
+    side->offset.r += sign * q_off.r;
+    side->offset.i += sign * q_off.i;
+    side->offset.j += sign * q_off.j;
+    side->offset.k += sign * q_off.k;
+}
+
+// the error of q_filter to q_ref corrected by the offset
+static void accumulate_error(quat_t<float> const * q_ref, quat_t<float> const * q_filter, bool const earth_side, SideErrors * side){
+    quat_t<float> q_expected;
+    if (earth_side){
+        quat_prod(&side->offset, q_ref, &q_expected);
+    }
+    else{
+        quat_prod(q_ref, &side->offset, &q_expected);
+    }
+    double const error = angle_between(q_filter, &q_expected);
+    side->sum += error;
+    side->max = fmax(side->max, error);
+}
+
+static void normalize(quat_t<float> * q){
+    float const norm = quat_norm(q);
+    q->r /= norm;
+    q->i /= norm;
+    q->j /= norm;
+    q->k /= norm;
+}
+
+static double rotation_angle(quat_t<float> const * q){
+    return 2.0 * acos(fmin(1.0, fabs(static_cast<double>(q->r))));
+}
+
+static void print_stats(char const * name, ErrorStats const & stats, unsigned long const nbr_samples, unsigned long const nbr_compared){
+    bool const earth_side = stats.earth_side.sum < stats.sensor_side.sum;
+    SideErrors const & side = earth_side ? stats.earth_side : stats.sensor_side;
+    printf("%s %.3f us / update, offset to reference on the %s side [deg] %.3f, error to reference [deg] mean %.3f max %.3f\n",
+           name, stats.update_us / nbr_samples, earth_side ? "earth" : "sensor", rotation_angle(&side.offset) * 180.0 / M_PI,
+           side.sum / nbr_compared * 180.0 / M_PI, side.max * 180.0 / M_PI);
+}
+
+int main(int argc, char ** argv){
+    float const sample_rate_hz = (argc > 1) ? static_cast<float>(atof(argv[1])) : 100.0f;
+    // the seconds after the convergence window are used to estimate the offsets to the reference
+    float const convergence_s = (argc > 5) ? static_cast<float>(atof(argv[5])) : 30.0f;
+    float const offset_s = 10.0f;
+
+    mahony_t<float> mahony_filter;
+    madgwick_t<float> madgwick_filter;
+    float const kp = (argc > 2) ? static_cast<float>(atof(argv[2])) : 0.5f;
+    float const ki = (argc > 3) ? static_cast<float>(atof(argv[3])) : 0.0f;
+    float const beta = (argc > 4) ? static_cast<float>(atof(argv[4])) : 0.1f;
+    mahony_init(&mahony_filter, sample_rate_hz, kp, ki);
+    madgwick_init(&madgwick_filter, sample_rate_hz, beta);
+
+    ErrorStats mahony_stats;
+    ErrorStats madgwick_stats;
+    unsigned long nbr_samples {0};
+    unsigned long nbr_compared {0};
+    bool offsets_ready {false};
+
+    char line[512];
+    while (fgets(line, sizeof(line), stdin) != nullptr){
+        unsigned long micros_sample;
+        vec3_t<float> gyr, acc, mag;
+        quat_t<float> q_ref;
+
+        int const nbr_fields = sscanf(line, "IMU,%lu,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f",
+                                      &micros_sample, &gyr.i, &gyr.j, &gyr.k, &acc.i, &acc.j, &acc.k,
+                                      &mag.i, &mag.j, &mag.k, &q_ref.r, &q_ref.i, &q_ref.j, &q_ref.k);
+        if (nbr_fields != 14){
+            continue;
+        }
+
+        auto const time_0 = std::chrono::steady_clock::now();
+        mahony_update(&mahony_filter, &gyr, &acc, &mag);
+        auto const time_1 = std::chrono::steady_clock::now();
+        madgwick_update(&madgwick_filter, &gyr, &acc, &mag);
+        auto const time_2 = std::chrono::steady_clock::now();
+
+        mahony_stats.update_us += std::chrono::duration<double, std::micro>(time_1 - time_0).count();
+        madgwick_stats.update_us += std::chrono::duration<double, std::micro>(time_2 - time_1).count();
+        nbr_samples++;
+
+        if (nbr_samples <= convergence_s * sample_rate_hz){
+            continue;
+        }
+
+        if (nbr_samples <= (convergence_s + offset_s) * sample_rate_hz){
+            accumulate_offset(&q_ref, &mahony_filter.q, false, &mahony_stats.sensor_side);
+            accumulate_offset(&q_ref, &mahony_filter.q, true, &mahony_stats.earth_side);
+            accumulate_offset(&q_ref, &madgwick_filter.q, false, &madgwick_stats.sensor_side);
+            accumulate_offset(&q_ref, &madgwick_filter.q, true, &madgwick_stats.earth_side);
+            continue;
+        }
+
+        if (!offsets_ready){
+            normalize(&mahony_stats.sensor_side.offset);
+            normalize(&mahony_stats.earth_side.offset);
+            normalize(&madgwick_stats.sensor_side.offset);
+            normalize(&madgwick_stats.earth_side.offset);
+            offsets_ready = true;
+        }
+
+        accumulate_error(&q_ref, &mahony_filter.q, false, &mahony_stats.sensor_side);
+        accumulate_error(&q_ref, &mahony_filter.q, true, &mahony_stats.earth_side);
+        accumulate_error(&q_ref, &madgwick_filter.q, false, &madgwick_stats.sensor_side);
+        accumulate_error(&q_ref, &madgwick_filter.q, true, &madgwick_stats.earth_side);
+        nbr_compared++;
+    }
+
+    if (nbr_compared == 0){
+        printf("not enough IMU lines in the log\n");
+        return 1;
+    }
+
+    printf("samples: %lu, compared to the reference: %lu\n", nbr_samples, nbr_compared);
+    print_stats("mahony:  ", mahony_stats, nbr_samples, nbr_compared);
+    print_stats("madgwick:", madgwick_stats, nbr_samples, nbr_compared);
+
+    return 0;
+}
@@ -0,0 +1,223 @@
+// accuracy check of the quaternion interpolation functions of kiss_clang_3d, on a computer: slerp is
+// compared against the exact rotation by a fraction of the angle, nlerp against its known error bound,
+// and the batch versions against the single ones; then both batch versions are timed. Returns non
+// zero if any check fails:
+//
+//   g++ -O2 -std=c++11 -I../src interpolation_check.cpp ../src/kiss_clang_3d.cpp -o interpolation_check
+//   ./interpolation_check
+
+#include <cstdio>
+#include <cstdint>
+#include <cmath>
+#include <chrono>
+
+#include "kiss_clang_3d.h"
+
+using namespace kiss3d;
+
+static constexpr size_t block_size {64};
+static constexpr unsigned long nbr_of_blocks {20000};
+
+// slerp against the exact rotation, and the batch versions against the single ones, in float
+static constexpr double max_err_slerp_rad {2.0e-6};
+static constexpr double max_err_batch_rad {1.0e-6};
+static constexpr double max_err_fraction {1.0e-6};
+
+static int nbr_failures {0};
+
+// rotation angle between 2 unit quaternions, well conditioned also for close quaternions
+static double angle_between(quat_t<float> const * q_1, quat_t<float> const * q_2){
+    double const sign = (quat_dot(q_1, q_2) < 0.0f) ? -1.0 : 1.0;
+    double const dr = q_1->r - sign * q_2->r;
+    double const di = q_1->i - sign * q_2->i;
+    double const dj = q_1->j - sign * q_2->j;
+    double const dk = q_1->k - sign * q_2->k;
+    return 4.0 * asin(fmin(1.0, 0.5 * sqrt(dr * dr + di * di + dj * dj + dk * dk)));
+}
+
+static void check(bool const condition, char const * what, double const value, double const limit){
+    if (!condition){
+        printf("FAIL %s: %.3e over %.3e\n", what, value, limit);
+        nbr_failures++;
+    }
+}
+
+static void check_accuracy(void){
+    vec3_t<float> axis_0;
+    vec3_t<float> axis_delta;
+    vec3_setter(&axis_0, 1.0f, 2.0f, 3.0f);
+    vec3_normalize(&axis_0);
+    vec3_setter(&axis_delta, -2.0f, 1.0f, 0.5f);
+    vec3_normalize(&axis_delta);
+
+    quat_t<float> q_0;
+    unit_quat_from_rotation(&q_0, &axis_0, 0.7f);
+
+    // from very close (nlerp fallback) to half a turn
+    float const list_angles[] {1.0e-4f, 1.0e-2f, 0.1745f, 1.0f, 3.0f};
+
+    for (float angle : list_angles){
+        quat_t<float> q_delta;
+        quat_t<float> q_1;
+        unit_quat_from_rotation(&q_delta, &axis_delta, angle);
+        quat_prod(&q_0, &q_delta, &q_1);
+
+        double max_err_slerp {0.0};
+        double max_err_nlerp {0.0};
+
+        for (int step=0; step<=10; step++){
+            float const t = step / 10.0f;
+
+            quat_t<float> q_ref;
+            unit_quat_from_rotation(&q_delta, &axis_delta, t * angle);
+            quat_prod(&q_0, &q_delta, &q_ref);
+
+            quat_t<float> q_slerp;
+            quat_t<float> q_nlerp;
+            quat_slerp(&q_0, &q_1, t, &q_slerp);
+            quat_nlerp(&q_0, &q_1, t, &q_nlerp);
+
+            max_err_slerp = fmax(max_err_slerp, angle_between(&q_slerp, &q_ref));
+            max_err_nlerp = fmax(max_err_nlerp, angle_between(&q_nlerp, &q_ref));
+        }
+
+        // nlerp follows the same path as slerp at a varying speed: at most about angle^3 / 250 away
+        // along it (near t = 0.21 and 0.79), plus the float rounding
+        double const max_err_nlerp_rad = angle * angle * angle / 200.0 + max_err_slerp_rad;
+
+        printf("angle [rad] %.4f max err slerp [rad] %.3e nlerp [rad] %.3e\n", angle, max_err_slerp, max_err_nlerp);
+        check(max_err_slerp <= max_err_slerp_rad, "slerp to exact", max_err_slerp, max_err_slerp_rad);
+        check(max_err_nlerp <= max_err_nlerp_rad, "nlerp to exact", max_err_nlerp, max_err_nlerp_rad);
+    }
+}
+
+static void check_batch(void){
+    // a filter output every 10 ms across the wrap around of micros(), and sensor samples in between
+    // and slightly outside
+    uint32_t const t_0 {0xFFFFF000u};
+    uint32_t const t_1 {t_0 + 10000u};
+    uint32_t timestamps[block_size];
+    for (size_t ind=0; ind<block_size; ind++){
+        timestamps[ind] = t_0 - 500u + static_cast<uint32_t>(ind * 11000u / block_size);
+    }
+
+    float fractions[block_size];
+    interpolation_fractions_batch(t_0, t_1, timestamps, block_size, fractions);
+
+    double max_err_fractions {0.0};
+    for (size_t ind=0; ind<block_size; ind++){
+        float const single = interpolation_fraction<float>(t_0, t_1, timestamps[ind]);
+        double const exact = (static_cast<double>(ind * 11000u / block_size) - 500.0) / 10000.0;
+        max_err_fractions = fmax(max_err_fractions, fmax(fabs(fractions[ind] - single), fabs(fractions[ind] - exact)));
+    }
+    printf("fractions batch: max err %.3e\n", max_err_fractions);
+    check(max_err_fractions <= max_err_fraction, "fractions batch", max_err_fractions, max_err_fraction);
+
+    vec3_t<float> axis;
+    vec3_setter(&axis, 0.3f, -0.5f, 1.0f);
+    vec3_normalize(&axis);
+    quat_t<float> q_0;
+    quat_t<float> q_1;
+    quat_t<float> q_delta;
+    unit_quat_from_rotation(&q_0, &axis, 2.0f);
+
+    float q_r[block_size];
+    float q_i[block_size];
+    float q_j[block_size];
+    float q_k[block_size];
+
+    // below and above the nlerp fallback of slerp
+    float const list_angles[] {1.0e-3f, 0.05f, 1.0f};
+    vec3_t<float> axis_delta;
+    vec3_setter(&axis_delta, 1.0f, 1.0f, 0.0f);
+    vec3_normalize(&axis_delta);
+
+    for (float angle : list_angles){
+        unit_quat_from_rotation(&q_delta, &axis_delta, angle);
+        quat_prod(&q_0, &q_delta, &q_1);
+
+        double max_err_slerp {0.0};
+        double max_err_nlerp {0.0};
+
+        quat_slerp_batch(&q_0, &q_1, fractions, block_size, q_r, q_i, q_j, q_k);
+        for (size_t ind=0; ind<block_size; ind++){
+            quat_t<float> q_batch {q_r[ind], q_i[ind], q_j[ind], q_k[ind]};
+            quat_t<float> q_single;
+            quat_slerp(&q_0, &q_1, fractions[ind], &q_single);
+            max_err_slerp = fmax(max_err_slerp, angle_between(&q_batch, &q_single));
+        }
+
+        quat_nlerp_batch(&q_0, &q_1, fractions, block_size, q_r, q_i, q_j, q_k);
+        for (size_t ind=0; ind<block_size; ind++){
+            quat_t<float> q_batch {q_r[ind], q_i[ind], q_j[ind], q_k[ind]};
+            quat_t<float> q_single;
+            quat_nlerp(&q_0, &q_1, fractions[ind], &q_single);
+            max_err_nlerp = fmax(max_err_nlerp, angle_between(&q_batch, &q_single));
+        }
+
+        printf("angle [rad] %.4f batch to single, max err slerp [rad] %.3e nlerp [rad] %.3e\n", angle, max_err_slerp, max_err_nlerp);
+        check(max_err_slerp <= max_err_batch_rad, "slerp batch to single", max_err_slerp, max_err_batch_rad);
+        check(max_err_nlerp <= max_err_batch_rad, "nlerp batch to single", max_err_nlerp, max_err_batch_rad);
+    }
+}
+
+static void check_throughput(void){
+    uint32_t const t_0 {1000000};
+    uint32_t const t_1 {t_0 + 10000};
+    uint32_t timestamps[block_size];
+    for (size_t ind=0; ind<block_size; ind++){
+        timestamps[ind] = t_0 + static_cast<uint32_t>(ind * 10000 / block_size);
+    }
+
+    vec3_t<float> axis;
+    vec3_setter(&axis, 0.0f, 0.0f, 1.0f);
+    quat_t<float> q_0;
+    quat_t<float> q_1;
+    quat_setter(&q_0, 1.0f, 0.0f, 0.0f, 0.0f);
+
+    float fractions[block_size];
+    float q_r[block_size];
+    float q_i[block_size];
+    float q_j[block_size];
+    float q_k[block_size];
+    // accumulated and printed, and the angle changes at each block, so that the loops cannot be dropped
+    double sink {0.0};
+
+    auto time_start = std::chrono::steady_clock::now();
+    for (unsigned long ind=0; ind<nbr_of_blocks; ind++){
+        unit_quat_from_rotation(&q_1, &axis, 0.05f + 1.0e-6f * ind);
+        interpolation_fractions_batch(t_0, t_1, timestamps, block_size, fractions);
+        quat_slerp_batch(&q_0, &q_1, fractions, block_size, q_r, q_i, q_j, q_k);
+        sink += q_r[block_size - 1] + q_k[block_size / 2];
+    }
+    double const slerp_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - time_start).count();
+
+    time_start = std::chrono::steady_clock::now();
+    for (unsigned long ind=0; ind<nbr_of_blocks; ind++){
+        unit_quat_from_rotation(&q_1, &axis, 0.05f + 1.0e-6f * ind);
+        interpolation_fractions_batch(t_0, t_1, timestamps, block_size, fractions);
+        quat_nlerp_batch(&q_0, &q_1, fractions, block_size, q_r, q_i, q_j, q_k);
+        sink += q_r[block_size - 1] + q_k[block_size / 2];
+    }
+    double const nlerp_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - time_start).count();
+
+    printf("slerp batch, ns per sample: %.2f\n", slerp_ns / (nbr_of_blocks * block_size));
+    printf("nlerp batch, ns per sample: %.2f\n", nlerp_ns / (nbr_of_blocks * block_size));
+    printf("(sink %.6f)\n", sink);
+}
+
+int main(void){
+    printf("----- accuracy -----\n");
+    check_accuracy();
+    printf("----- batch -----\n");
+    check_batch();
+    printf("----- throughput -----\n");
+    check_throughput();
+
+    if (nbr_failures != 0){
+        printf("%d checks failed\n", nbr_failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
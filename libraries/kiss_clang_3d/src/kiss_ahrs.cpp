@@ -0,0 +1,193 @@
+#include "kiss_ahrs.h"
+
+namespace kiss3d {
+
+// normalize in place, return false (and leave as is) if null
+template <typename T>
+static inline bool normalize_if_not_null(vec3_t<T> * v){
+    T const norm_square = vec3_norm_square(v);
+    if (norm_square <= scalar_traits<T>::zero()){
+        return false;
+    }
+    vec3_scale(v, scalar_traits<T>::one() / scalar_traits<T>::sqrt(norm_square));
+    return true;
+}
+
+template <typename T>
+static inline void normalize_quat(quat_t<T> * q){
+    T const inv_norm = scalar_traits<T>::one() / quat_norm(q);
+    q->r *= inv_norm;
+    q->i *= inv_norm;
+    q->j *= inv_norm;
+    q->k *= inv_norm;
+}
+
+template <typename T>
+void mahony_init(mahony_t<T> * filter, T const sample_rate_hz, T const kp, T const ki){
+    T const dt = scalar_traits<T>::one() / sample_rate_hz;
+
+    quat_setter(&filter->q, scalar_traits<T>::one(), scalar_traits<T>::zero(), scalar_traits<T>::zero(), scalar_traits<T>::zero());
+    vec3_setter(&filter->integral_feedback, scalar_traits<T>::zero(), scalar_traits<T>::zero(), scalar_traits<T>::zero());
+    filter->two_kp = scalar_traits<T>::two() * kp;
+    filter->two_ki_dt = scalar_traits<T>::two() * ki * dt;
+    filter->half_dt = scalar_traits<T>::half() * dt;
+}
+
+template <typename T>
+void mahony_update(mahony_t<T> * filter, vec3_t<T> const * gyr_rads, vec3_t<T> const * acc, vec3_t<T> const * mag){
+    T const half = scalar_traits<T>::half();
+    T const q0 = filter->q.r, q1 = filter->q.i, q2 = filter->q.j, q3 = filter->q.k;
+
+    T gx = gyr_rads->i;
+    T gy = gyr_rads->j;
+    T gz = gyr_rads->k;
+
+    vec3_t<T> a;
+    vec3_t<T> m;
+    vec3_copy(acc, &a);
+    vec3_copy(mag, &m);
+
+    if (normalize_if_not_null(&a) && normalize_if_not_null(&m)){
+        T const q0q0 = q0 * q0, q0q1 = q0 * q1, q0q2 = q0 * q2, q0q3 = q0 * q3;
+        T const q1q1 = q1 * q1, q1q2 = q1 * q2, q1q3 = q1 * q3;
+        T const q2q2 = q2 * q2, q2q3 = q2 * q3;
+        T const q3q3 = q3 * q3;
+
+        // reference direction of the magnetic field, in the earth frame
+        T const hx = scalar_traits<T>::two() * (m.i * (half - q2q2 - q3q3) + m.j * (q1q2 - q0q3) + m.k * (q1q3 + q0q2));
+        T const hy = scalar_traits<T>::two() * (m.i * (q1q2 + q0q3) + m.j * (half - q1q1 - q3q3) + m.k * (q2q3 - q0q1));
+        T const bx = scalar_traits<T>::sqrt(hx * hx + hy * hy);
+        T const bz = scalar_traits<T>::two() * (m.i * (q1q3 - q0q2) + m.j * (q2q3 + q0q1) + m.k * (half - q1q1 - q2q2));
+
+        // estimated directions of gravity and of the magnetic field, in the sensor frame (halved)
+        T const half_vx = q1q3 - q0q2;
+        T const half_vy = q0q1 + q2q3;
+        T const half_vz = q0q0 - half + q3q3;
+        T const half_wx = bx * (half - q2q2 - q3q3) + bz * (q1q3 - q0q2);
+        T const half_wy = bx * (q1q2 - q0q3) + bz * (q0q1 + q2q3);
+        T const half_wz = bx * (q0q2 + q1q3) + bz * (half - q1q1 - q2q2);
+
+        // error between the estimated and measured directions, cross product
+        T const half_ex = (a.j * half_vz - a.k * half_vy) + (m.j * half_wz - m.k * half_wy);
+        T const half_ey = (a.k * half_vx - a.i * half_vz) + (m.k * half_wx - m.i * half_wz);
+        T const half_ez = (a.i * half_vy - a.j * half_vx) + (m.i * half_wy - m.j * half_wx);
+
+        if (filter->two_ki_dt > scalar_traits<T>::zero()){
+            filter->integral_feedback.i += filter->two_ki_dt * half_ex;
+            filter->integral_feedback.j += filter->two_ki_dt * half_ey;
+            filter->integral_feedback.k += filter->two_ki_dt * half_ez;
+            gx += filter->integral_feedback.i;
+            gy += filter->integral_feedback.j;
+            gz += filter->integral_feedback.k;
+        }
+
+        gx += filter->two_kp * half_ex;
+        gy += filter->two_kp * half_ey;
+        gz += filter->two_kp * half_ez;
+    }
+
+    // integrate the rate of change of the quaternion
+    gx *= filter->half_dt;
+    gy *= filter->half_dt;
+    gz *= filter->half_dt;
+
+    filter->q.r = q0 + (-q1 * gx - q2 * gy - q3 * gz);
+    filter->q.i = q1 + (q0 * gx + q2 * gz - q3 * gy);
+    filter->q.j = q2 + (q0 * gy - q1 * gz + q3 * gx);
+    filter->q.k = q3 + (q0 * gz + q1 * gy - q2 * gx);
+
+    normalize_quat(&filter->q);
+}
+
+template <typename T>
+void madgwick_init(madgwick_t<T> * filter, T const sample_rate_hz, T const beta){
+    quat_setter(&filter->q, scalar_traits<T>::one(), scalar_traits<T>::zero(), scalar_traits<T>::zero(), scalar_traits<T>::zero());
+    filter->beta = beta;
+    filter->dt = scalar_traits<T>::one() / sample_rate_hz;
+}
+
+template <typename T>
+void madgwick_update(madgwick_t<T> * filter, vec3_t<T> const * gyr_rads, vec3_t<T> const * acc, vec3_t<T> const * mag){
+    T const half = scalar_traits<T>::half();
+    T const two = scalar_traits<T>::two();
+    T const q0 = filter->q.r, q1 = filter->q.i, q2 = filter->q.j, q3 = filter->q.k;
+    T const gx = gyr_rads->i, gy = gyr_rads->j, gz = gyr_rads->k;
+
+    // rate of change of the quaternion, from the gyro
+    T q_dot_0 = half * (-q1 * gx - q2 * gy - q3 * gz);
+    T q_dot_1 = half * (q0 * gx + q2 * gz - q3 * gy);
+    T q_dot_2 = half * (q0 * gy - q1 * gz + q3 * gx);
+    T q_dot_3 = half * (q0 * gz + q1 * gy - q2 * gx);
+
+    vec3_t<T> a;
+    vec3_t<T> m;
+    vec3_copy(acc, &a);
+    vec3_copy(mag, &m);
+
+    if (normalize_if_not_null(&a) && normalize_if_not_null(&m)){
+        T const two_q0_mx = two * q0 * m.i;
+        T const two_q0_my = two * q0 * m.j;
+        T const two_q0_mz = two * q0 * m.k;
+        T const two_q1_mx = two * q1 * m.i;
+        T const two_q0 = two * q0;
+        T const two_q1 = two * q1;
+        T const two_q2 = two * q2;
+        T const two_q3 = two * q3;
+        T const two_q0q2 = two * q0 * q2;
+        T const two_q2q3 = two * q2 * q3;
+        T const q0q0 = q0 * q0, q0q1 = q0 * q1, q0q2 = q0 * q2, q0q3 = q0 * q3;
+        T const q1q1 = q1 * q1, q1q2 = q1 * q2, q1q3 = q1 * q3;
+        T const q2q2 = q2 * q2, q2q3 = q2 * q3;
+        T const q3q3 = q3 * q3;
+
+        // reference direction of the magnetic field, in the earth frame
+        T const hx = m.i * q0q0 - two_q0_my * q3 + two_q0_mz * q2 + m.i * q1q1 + two_q1 * m.j * q2 + two_q1 * m.k * q3 - m.i * q2q2 - m.i * q3q3;
+        T const hy = two_q0_mx * q3 + m.j * q0q0 - two_q0_mz * q1 + two_q1_mx * q2 - m.j * q1q1 + m.j * q2q2 + two_q2 * m.k * q3 - m.j * q3q3;
+        T const two_bx = scalar_traits<T>::sqrt(hx * hx + hy * hy);
+        T const two_bz = -two_q0_mx * q2 + two_q0_my * q1 + m.k * q0q0 + two_q1_mx * q3 - m.k * q1q1 + two_q2 * m.j * q3 - m.k * q2q2 + m.k * q3q3;
+        T const four_bx = two * two_bx;
+        T const four_bz = two * two_bz;
+
+        // the objective function, common terms
+        T const f_ax = two * q1q3 - two_q0q2 - a.i;
+        T const f_ay = two * q0q1 + two_q2q3 - a.j;
+        T const f_az = scalar_traits<T>::one() - two * q1q1 - two * q2q2 - a.k;
+        T const f_mx = two_bx * (half - q2q2 - q3q3) + two_bz * (q1q3 - q0q2) - m.i;
+        T const f_my = two_bx * (q1q2 - q0q3) + two_bz * (q0q1 + q2q3) - m.j;
+        T const f_mz = two_bx * (q0q2 + q1q3) + two_bz * (half - q1q1 - q2q2) - m.k;
+
+        // gradient descent step, jacobian transposed times objective function
+        T s0 = -two_q2 * f_ax + two_q1 * f_ay - two_bz * q2 * f_mx + (-two_bx * q3 + two_bz * q1) * f_my + two_bx * q2 * f_mz;
+        T s1 = two_q3 * f_ax + two_q0 * f_ay - two * two_q1 * f_az + two_bz * q3 * f_mx + (two_bx * q2 + two_bz * q0) * f_my + (two_bx * q3 - four_bz * q1) * f_mz;
+        T s2 = -two_q0 * f_ax + two_q3 * f_ay - two * two_q2 * f_az + (-four_bx * q2 - two_bz * q0) * f_mx + (two_bx * q1 + two_bz * q3) * f_my + (two_bx * q0 - four_bz * q2) * f_mz;
+        T s3 = two_q1 * f_ax + two_q2 * f_ay + (-four_bx * q3 + two_bz * q1) * f_mx + (-two_bx * q0 + two_bz * q2) * f_my + two_bx * q1 * f_mz;
+
+        T const s_norm_square = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+        if (s_norm_square > scalar_traits<T>::zero()){
+            T const beta_inv_norm = filter->beta / scalar_traits<T>::sqrt(s_norm_square);
+            q_dot_0 -= beta_inv_norm * s0;
+            q_dot_1 -= beta_inv_norm * s1;
+            q_dot_2 -= beta_inv_norm * s2;
+            q_dot_3 -= beta_inv_norm * s3;
+        }
+    }
+
+    filter->q.r = q0 + q_dot_0 * filter->dt;
+    filter->q.i = q1 + q_dot_1 * filter->dt;
+    filter->q.j = q2 + q_dot_2 * filter->dt;
+    filter->q.k = q3 + q_dot_3 * filter->dt;
+
+    normalize_quat(&filter->q);
+}
+
+// explicit instantiations, for float and for double
+template void mahony_init<float>(mahony_t<float> * filter, float const sample_rate_hz, float const kp, float const ki);
+template void mahony_init<double>(mahony_t<double> * filter, double const sample_rate_hz, double const kp, double const ki);
+template void mahony_update<float>(mahony_t<float> * filter, vec3_t<float> const * gyr_rads, vec3_t<float> const * acc, vec3_t<float> const * mag);
+template void mahony_update<double>(mahony_t<double> * filter, vec3_t<double> const * gyr_rads, vec3_t<double> const * acc, vec3_t<double> const * mag);
+template void madgwick_init<float>(madgwick_t<float> * filter, float const sample_rate_hz, float const beta);
+template void madgwick_init<double>(madgwick_t<double> * filter, double const sample_rate_hz, double const beta);
+template void madgwick_update<float>(madgwick_t<float> * filter, vec3_t<float> const * gyr_rads, vec3_t<float> const * acc, vec3_t<float> const * mag);
+template void madgwick_update<double>(madgwick_t<double> * filter, vec3_t<double> const * gyr_rads, vec3_t<double> const * acc, vec3_t<double> const * mag);
+
+}  // namespace kiss3d
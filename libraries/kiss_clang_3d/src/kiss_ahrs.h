@@ -0,0 +1,100 @@
+#ifndef KISS_AHRS_H
+#define KISS_AHRS_H
+
+#include "kiss_clang_3d.h"
+
+// Lightweight AHRS (attitude and heading reference system) filters on the kiss_clang_3d types:
+// Mahony (complementary filter with a PI feedback on the direction errors) and Madgwick (gradient
+// descent on the direction errors), after S. Madgwick's reference implementations.
+//
+// These are much cheaper than the Kalman filter of Adafruit_NXPSensorFusion: the timestep is fixed,
+// so that all the gains are multiplied by the timestep once at init, the state is only a unit quaternion
+// (plus the integral feedback for Mahony), and nothing is allocated.
+//
+// conventions:
+// - gyro in rad/s; accel and mag in any unit, they are normalized;
+// - q rotates vectors from the sensor frame to the earth frame (z up along gravity, x along the horizontal
+//   component of the magnetic field), i.e. rotate_by_quat_R(v_sensor, q, v_earth);
+// - if the accel or the mag is null (invalid sample), that update only integrates the gyro.
+
+namespace kiss3d {
+
+// ------------------------------------------------------------
+// MAHONY
+// ------------------------------------------------------------
+
+template <typename T>
+struct mahony_t {
+    quat_t<T> q;
+    vec3_t<T> integral_feedback;
+    // precomputed from the gains and the timestep
+    T two_kp;
+    T two_ki_dt;
+    T half_dt;
+};
+
+/*
+Init a Mahony filter to the identity, for a fixed sample rate; kp is the proportional gain (how fast
+the gyro drift is corrected by the accel and mag), ki the integral gain (gyro bias estimation, 0 to
+disable).
+*/
+template <typename T>
+void mahony_init(mahony_t<T> * filter, T const sample_rate_hz, T const kp=T(0.5), T const ki=T(0));
+
+/*
+One update of a Mahony filter, with one sample of each sensor
+*/
+template <typename T>
+void mahony_update(mahony_t<T> * filter, vec3_t<T> const * gyr_rads, vec3_t<T> const * acc, vec3_t<T> const * mag);
+
+// ------------------------------------------------------------
+// MADGWICK
+// ------------------------------------------------------------
+
+template <typename T>
+struct madgwick_t {
+    quat_t<T> q;
+    // precomputed from the gain and the timestep
+    T beta;
+    T dt;
+};
+
+/*
+Init a Madgwick filter to the identity, for a fixed sample rate; beta is the gain of the gradient
+descent step (how fast the gyro drift is corrected by the accel and mag).
+*/
+template <typename T>
+void madgwick_init(madgwick_t<T> * filter, T const sample_rate_hz, T const beta=T(0.1));
+
+/*
+One update of a Madgwick filter, with one sample of each sensor
+*/
+template <typename T>
+void madgwick_update(madgwick_t<T> * filter, vec3_t<T> const * gyr_rads, vec3_t<T> const * acc, vec3_t<T> const * mag);
+
+}  // namespace kiss3d
+
+// ------------------------------------------------------------
+// C-STYLE API
+// ------------------------------------------------------------
+
+typedef kiss3d::mahony_t<F_TYPE> mahony;
+typedef kiss3d::madgwick_t<F_TYPE> madgwick;
+
+static inline void mahony_init(mahony * filter, F_TYPE const sample_rate_hz, F_TYPE const kp=F_TYPE(0.5), F_TYPE const ki=F_TYPE(0)){
+    kiss3d::mahony_init(filter, sample_rate_hz, kp, ki);
+}
+
+static inline void mahony_update(mahony * filter, vec3 const * gyr_rads, vec3 const * acc, vec3 const * mag){
+    kiss3d::mahony_update(filter, gyr_rads, acc, mag);
+}
+
+static inline void madgwick_init(madgwick * filter, F_TYPE const sample_rate_hz, F_TYPE const beta=F_TYPE(0.1)){
+    kiss3d::madgwick_init(filter, sample_rate_hz, beta);
+}
+
+static inline void madgwick_update(madgwick * filter, vec3 const * gyr_rads, vec3 const * acc, vec3 const * mag){
+    kiss3d::madgwick_update(filter, gyr_rads, acc, mag);
+}
+
+#endif
@@ -0,0 +1,415 @@
+#include "kiss_clang_3d.h"
+
+namespace kiss3d {
+
+template <typename T>
+bool vec3_normalize(vec3_t<T> * v){
+    if (vec3_is_null(v)){
+        return false;
+    }
+    else{
+        T norm = vec3_norm(v);
+        vec3_scale(v, scalar_traits<T>::one() / norm);
+        return true;
+    }
+}
+
+template <typename T>
+bool vec3_colinear(vec3_t<T> const * v, vec3_t<T> const * w, T tolerance){
+    vec3_t<T> result_cross_product;
+    vec3_cross(v, w, &result_cross_product);
+    return vec3_is_null(&result_cross_product, tolerance);
+}
+
+template <typename T>
+bool quat_inv(quat_t<T> * q, T tolerance){
+    T norm_square = quat_norm_square(q);
+
+    if (norm_square < tolerance){
+        return false;
+    }
+    else{
+        q->r /= norm_square;
+        q->i = -q->i / norm_square;
+        q->j = -q->j / norm_square;
+        q->k = -q->k / norm_square;
+
+        return true;
+    }
+}
+
+template <typename T>
+bool rotation_to_quat(quat_t<T> * q, vec3_t<T> const * rotation_axis, T const rotation_angle_rad, T tolerance){
+    if (vec3_is_null(rotation_axis)){
+        if (scalar_traits<T>::abs(rotation_angle_rad) <= tolerance){
+            q->r = scalar_traits<T>::one();
+            q->i = scalar_traits<T>::zero();
+            q->j = scalar_traits<T>::zero();
+            q->k = scalar_traits<T>::zero();
+
+            return true;
+        }
+        else{
+            return false;
+        }
+    }
+
+    T half_rotation_angle = rotation_angle_rad / scalar_traits<T>::two();
+    T cos_of_half = scalar_traits<T>::cos(half_rotation_angle);
+    T sin_of_half = scalar_traits<T>::sin(half_rotation_angle);
+    T norm_of_axis = vec3_norm(rotation_axis);
+
+    q->r = cos_of_half;
+    q->i = rotation_axis->i / norm_of_axis * sin_of_half;
+    q->j = rotation_axis->j / norm_of_axis * sin_of_half;
+    q->k = rotation_axis->k / norm_of_axis * sin_of_half;
+
+    return true;
+}
+
+template <typename T>
+bool quat_to_rotation(vec3_t<T> * rotation_axis, T * rotation_angle_rad, quat_t<T> const * q_rotation, T tolerance){
+    if (!quat_is_unitary(q_rotation, tolerance)){
+        return false;
+    }
+    else{
+        *rotation_angle_rad = scalar_traits<T>::two() * scalar_traits<T>::acos(q_rotation->r);
+        T sin_half_angle = scalar_traits<T>::sqrt(scalar_traits<T>::one() - q_rotation->r * q_rotation->r);
+        rotation_axis->i = q_rotation->i / sin_half_angle;
+        rotation_axis->j = q_rotation->j / sin_half_angle;
+        rotation_axis->k = q_rotation->k / sin_half_angle;
+
+        return true;
+    }
+}
+
+// the naive way, applying the definition; this is quite inefficient though
+template <typename T>
+bool rotate_by_quat(vec3_t<T> * v, quat_t<T> const * q, T tolerance){
+    if (!quat_is_unitary(q)){
+        return false;
+    }
+
+    quat_t<T> q_1;
+    quat_t<T> q_2;
+    quat_t<T> q_3;
+
+    // q_1 is the quat_t<T> out of v
+    vec3_to_quat(v, &q_1);
+
+    // q_2 is the rotation quat_t<T> conjugate
+    quat_copy(q, &q_2);
+    quat_conj(&q_2);
+
+    // q_3 contains the right part of the product
+    quat_prod(&q_1, &q_2, &q_3);
+
+    // q_2 is the rotation quat_t<T>
+    quat_conj(&q_2);
+
+    // q_1 contains the full quaternion
+    quat_prod(&q_2, &q_3, &q_1);
+
+    // make the result available
+    quat_to_vec3(&q_1, v);
+
+    return true;
+}
+
+template <typename T>
+void unit_quat_from_rotation(quat_t<T> * q, vec3_t<T> const * unit_rotation_axis, T const rotation_angle_rad){
+    KISS_ASSERT_UNIT_VEC3(unit_rotation_axis);
+
+    T half_rotation_angle = rotation_angle_rad * scalar_traits<T>::half();
+    T sin_of_half = scalar_traits<T>::sin(half_rotation_angle);
+
+    q->r = scalar_traits<T>::cos(half_rotation_angle);
+    q->i = unit_rotation_axis->i * sin_of_half;
+    q->j = unit_rotation_axis->j * sin_of_half;
+    q->k = unit_rotation_axis->k * sin_of_half;
+}
+
+template <typename T>
+void unit_quat_to_rotation(vec3_t<T> * rotation_axis, T * rotation_angle_rad, quat_t<T> const * q_rotation){
+    KISS_ASSERT_UNIT_QUAT(q_rotation);
+
+    *rotation_angle_rad = scalar_traits<T>::two() * scalar_traits<T>::acos(q_rotation->r);
+
+    T sin_half_angle_square = scalar_traits<T>::one() - q_rotation->r * q_rotation->r;
+    if (sin_half_angle_square <= scalar_traits<T>::zero()){
+        vec3_setter(rotation_axis, scalar_traits<T>::zero(), scalar_traits<T>::zero(), scalar_traits<T>::zero());
+        return;
+    }
+
+    T inv_sin_half_angle = scalar_traits<T>::one() / scalar_traits<T>::sqrt(sin_half_angle_square);
+    rotation_axis->i = q_rotation->i * inv_sin_half_angle;
+    rotation_axis->j = q_rotation->j * inv_sin_half_angle;
+    rotation_axis->k = q_rotation->k * inv_sin_half_angle;
+}
+
+template <typename T>
+void quat_to_rotation_matrix(quat_t<T> const * q, T matrix[9]){
+    T const ii = q->i * q->i;
+    T const jj = q->j * q->j;
+    T const kk = q->k * q->k;
+    T const ij = q->i * q->j;
+    T const ik = q->i * q->k;
+    T const jk = q->j * q->k;
+    T const ri = q->r * q->i;
+    T const rj = q->r * q->j;
+    T const rk = q->r * q->k;
+
+    matrix[0] = scalar_traits<T>::one() - scalar_traits<T>::two() * (jj + kk);
+    matrix[1] = scalar_traits<T>::two() * (ij - rk);
+    matrix[2] = scalar_traits<T>::two() * (ik + rj);
+
+    matrix[3] = scalar_traits<T>::two() * (ij + rk);
+    matrix[4] = scalar_traits<T>::one() - scalar_traits<T>::two() * (ii + kk);
+    matrix[5] = scalar_traits<T>::two() * (jk - ri);
+
+    matrix[6] = scalar_traits<T>::two() * (ik - rj);
+    matrix[7] = scalar_traits<T>::two() * (jk + ri);
+    matrix[8] = scalar_traits<T>::one() - scalar_traits<T>::two() * (ii + jj);
+}
+
+template <typename T>
+void rotate_by_quat_R_batch(T const * in_i, T const * in_j, T const * in_k,
+                            quat_t<T> const * q, size_t nbr_of_vectors,
+                            T * out_i, T * out_j, T * out_k){
+    T matrix[9];
+    quat_to_rotation_matrix(q, matrix);
+
+    // local copies, so that the compiler knows these are not modified through the output pointers
+    T const m0 = matrix[0], m1 = matrix[1], m2 = matrix[2];
+    T const m3 = matrix[3], m4 = matrix[4], m5 = matrix[5];
+    T const m6 = matrix[6], m7 = matrix[7], m8 = matrix[8];
+
+    for (size_t ind=0; ind<nbr_of_vectors; ind++){
+        T const vi = in_i[ind];
+        T const vj = in_j[ind];
+        T const vk = in_k[ind];
+        out_i[ind] = m0 * vi + m1 * vj + m2 * vk;
+        out_j[ind] = m3 * vi + m4 * vj + m5 * vk;
+        out_k[ind] = m6 * vi + m7 * vj + m8 * vk;
+    }
+}
+
+template <typename T>
+void rotate_by_quats_R_batch(T const * in_i, T const * in_j, T const * in_k,
+                             T const * q_r, T const * q_i, T const * q_j, T const * q_k,
+                             size_t nbr_of_vectors,
+                             T * out_i, T * out_j, T * out_k){
+    for (size_t ind=0; ind<nbr_of_vectors; ind++){
+        T const vi = in_i[ind];
+        T const vj = in_j[ind];
+        T const vk = in_k[ind];
+        T const s  = q_r[ind];
+        T const ui = q_i[ind];
+        T const uj = q_j[ind];
+        T const uk = q_k[ind];
+
+        T const u_dot_v = ui * vi + uj * vj + uk * vk;
+        T const s2m05 = s * s - scalar_traits<T>::half();
+
+        out_i[ind] = scalar_traits<T>::two() * ( u_dot_v * ui + s2m05 * vi + s * ( uj * vk - uk * vj ) );
+        out_j[ind] = scalar_traits<T>::two() * ( u_dot_v * uj + s2m05 * vj + s * ( uk * vi - ui * vk ) );
+        out_k[ind] = scalar_traits<T>::two() * ( u_dot_v * uk + s2m05 * vk + s * ( ui * vj - uj * vi ) );
+    }
+}
+
+template <typename T>
+void quat_slerp(quat_t<T> const * q_0, quat_t<T> const * q_1, T t, quat_t<T> * q_out){
+    KISS_ASSERT_UNIT_QUAT(q_0);
+    KISS_ASSERT_UNIT_QUAT(q_1);
+
+    T cos_angle = quat_dot(q_0, q_1);
+    T sign_1 = scalar_traits<T>::one();
+
+    // go the short way
+    if (cos_angle < scalar_traits<T>::zero()){
+        cos_angle = -cos_angle;
+        sign_1 = -sign_1;
+    }
+
+    if (cos_angle > scalar_traits<T>::slerp_threshold()){
+        quat_nlerp(q_0, q_1, t, q_out);
+        return;
+    }
+
+    T const angle = scalar_traits<T>::acos(cos_angle);
+    T const inv_sin_angle = scalar_traits<T>::one() / scalar_traits<T>::sin(angle);
+    T const w_0 = scalar_traits<T>::sin((scalar_traits<T>::one() - t) * angle) * inv_sin_angle;
+    T const w_1 = sign_1 * scalar_traits<T>::sin(t * angle) * inv_sin_angle;
+
+    T const r = w_0 * q_0->r + w_1 * q_1->r;
+    T const i = w_0 * q_0->i + w_1 * q_1->i;
+    T const j = w_0 * q_0->j + w_1 * q_1->j;
+    T const k = w_0 * q_0->k + w_1 * q_1->k;
+
+    q_out->r = r;
+    q_out->i = i;
+    q_out->j = j;
+    q_out->k = k;
+}
+
+template <typename T>
+void interpolation_fractions_batch(uint32_t t_0, uint32_t t_1, uint32_t const * timestamps,
+                                   size_t nbr_of_fractions, T * fractions){
+    T const inv_interval = scalar_traits<T>::one() / static_cast<T>(static_cast<int32_t>(t_1 - t_0));
+
+    for (size_t ind=0; ind<nbr_of_fractions; ind++){
+        fractions[ind] = static_cast<T>(static_cast<int32_t>(timestamps[ind] - t_0)) * inv_interval;
+    }
+}
+
+template <typename T>
+void quat_slerp_batch(quat_t<T> const * q_0, quat_t<T> const * q_1,
+                      T const * fractions, size_t nbr_of_fractions,
+                      T * q_r, T * q_i, T * q_j, T * q_k){
+    KISS_ASSERT_UNIT_QUAT(q_0);
+    KISS_ASSERT_UNIT_QUAT(q_1);
+
+    T cos_angle = quat_dot(q_0, q_1);
+    T sign_1 = scalar_traits<T>::one();
+
+    if (cos_angle < scalar_traits<T>::zero()){
+        cos_angle = -cos_angle;
+        sign_1 = -sign_1;
+    }
+
+    if (cos_angle > scalar_traits<T>::slerp_threshold()){
+        quat_nlerp_batch(q_0, q_1, fractions, nbr_of_fractions, q_r, q_i, q_j, q_k);
+        return;
+    }
+
+    // everything that does not depend on the fraction, once for the block
+    T const angle = scalar_traits<T>::acos(cos_angle);
+    T const inv_sin_angle = scalar_traits<T>::one() / scalar_traits<T>::sin(angle);
+    T const signed_inv_sin_angle = sign_1 * inv_sin_angle;
+    T const r_0 = q_0->r, i_0 = q_0->i, j_0 = q_0->j, k_0 = q_0->k;
+    T const r_1 = q_1->r, i_1 = q_1->i, j_1 = q_1->j, k_1 = q_1->k;
+
+    for (size_t ind=0; ind<nbr_of_fractions; ind++){
+        T const t = fractions[ind];
+        T const w_0 = scalar_traits<T>::sin((scalar_traits<T>::one() - t) * angle) * inv_sin_angle;
+        T const w_1 = scalar_traits<T>::sin(t * angle) * signed_inv_sin_angle;
+
+        q_r[ind] = w_0 * r_0 + w_1 * r_1;
+        q_i[ind] = w_0 * i_0 + w_1 * i_1;
+        q_j[ind] = w_0 * j_0 + w_1 * j_1;
+        q_k[ind] = w_0 * k_0 + w_1 * k_1;
+    }
+}
+
+template <typename T>
+void quat_nlerp_batch(quat_t<T> const * q_0, quat_t<T> const * q_1,
+                      T const * fractions, size_t nbr_of_fractions,
+                      T * q_r, T * q_i, T * q_j, T * q_k){
+    KISS_ASSERT_UNIT_QUAT(q_0);
+    KISS_ASSERT_UNIT_QUAT(q_1);
+
+    // flip q_1 once for the block if needed, rather than once per sample
+    T const sign_1 = (quat_dot(q_0, q_1) < scalar_traits<T>::zero()) ? -scalar_traits<T>::one() : scalar_traits<T>::one();
+    T const r_0 = q_0->r, i_0 = q_0->i, j_0 = q_0->j, k_0 = q_0->k;
+    T const r_1 = sign_1 * q_1->r, i_1 = sign_1 * q_1->i, j_1 = sign_1 * q_1->j, k_1 = sign_1 * q_1->k;
+
+    for (size_t ind=0; ind<nbr_of_fractions; ind++){
+        T const t = fractions[ind];
+        T const t_0 = scalar_traits<T>::one() - t;
+
+        T const r = t_0 * r_0 + t * r_1;
+        T const i = t_0 * i_0 + t * i_1;
+        T const j = t_0 * j_0 + t * j_1;
+        T const k = t_0 * k_0 + t * k_1;
+
+        T const inv_norm = scalar_traits<T>::one() / scalar_traits<T>::sqrt(r * r + i * i + j * j + k * k);
+        q_r[ind] = r * inv_norm;
+        q_i[ind] = i * inv_norm;
+        q_j[ind] = j * inv_norm;
+        q_k[ind] = k * inv_norm;
+    }
+}
+
+template <typename T>
+void euler_zyx_to_rotation_matrix(T const yaw_rad, T const pitch_rad, T const roll_rad, T matrix[9]){
+    T sy, cy, sp, cp, sr, cr;
+    scalar_traits<T>::sincos(yaw_rad, &sy, &cy);
+    scalar_traits<T>::sincos(pitch_rad, &sp, &cp);
+    scalar_traits<T>::sincos(roll_rad, &sr, &cr);
+
+    // common products, computed once
+    T const sp_sr = sp * sr;
+    T const sp_cr = sp * cr;
+
+    matrix[0] = cy * cp;
+    matrix[1] = cy * sp_sr - sy * cr;
+    matrix[2] = cy * sp_cr + sy * sr;
+
+    matrix[3] = sy * cp;
+    matrix[4] = sy * sp_sr + cy * cr;
+    matrix[5] = sy * sp_cr - cy * sr;
+
+    matrix[6] = -sp;
+    matrix[7] = cp * sr;
+    matrix[8] = cp * cr;
+}
+
+// TODO: implement the other way to do, and test which is faster :)
+
+// explicit instantiations: the larger functions are compiled once, for float and for double
+template bool vec3_normalize<float>(vec3_t<float> * v);
+template bool vec3_normalize<double>(vec3_t<double> * v);
+template bool vec3_colinear<float>(vec3_t<float> const * v, vec3_t<float> const * w, float tolerance);
+template bool vec3_colinear<double>(vec3_t<double> const * v, vec3_t<double> const * w, double tolerance);
+template bool quat_inv<float>(quat_t<float> * q, float tolerance);
+template bool quat_inv<double>(quat_t<double> * q, double tolerance);
+template bool rotation_to_quat<float>(quat_t<float> * q, vec3_t<float> const * rotation_axis, float const rotation_angle_rad, float tolerance);
+template bool rotation_to_quat<double>(quat_t<double> * q, vec3_t<double> const * rotation_axis, double const rotation_angle_rad, double tolerance);
+template bool quat_to_rotation<float>(vec3_t<float> * rotation_axis, float * rotation_angle_rad, quat_t<float> const * q_rotation, float tolerance);
+template bool quat_to_rotation<double>(vec3_t<double> * rotation_axis, double * rotation_angle_rad, quat_t<double> const * q_rotation, double tolerance);
+template bool rotate_by_quat<float>(vec3_t<float> * v, quat_t<float> const * q, float tolerance);
+template bool rotate_by_quat<double>(vec3_t<double> * v, quat_t<double> const * q, double tolerance);
+template void unit_quat_from_rotation<float>(quat_t<float> * q, vec3_t<float> const * unit_rotation_axis, float const rotation_angle_rad);
+template void unit_quat_from_rotation<double>(quat_t<double> * q, vec3_t<double> const * unit_rotation_axis, double const rotation_angle_rad);
+template void unit_quat_to_rotation<float>(vec3_t<float> * rotation_axis, float * rotation_angle_rad, quat_t<float> const * q_rotation);
+template void unit_quat_to_rotation<double>(vec3_t<double> * rotation_axis, double * rotation_angle_rad, quat_t<double> const * q_rotation);
+template void quat_to_rotation_matrix<float>(quat_t<float> const * q, float matrix[9]);
+template void quat_to_rotation_matrix<double>(quat_t<double> const * q, double matrix[9]);
+template void rotate_by_quat_R_batch<float>(float const * in_i, float const * in_j, float const * in_k,
+                            quat_t<float> const * q, size_t nbr_of_vectors,
+                            float * out_i, float * out_j, float * out_k);
+template void rotate_by_quat_R_batch<double>(double const * in_i, double const * in_j, double const * in_k,
+                            quat_t<double> const * q, size_t nbr_of_vectors,
+                            double * out_i, double * out_j, double * out_k);
+template void rotate_by_quats_R_batch<float>(float const * in_i, float const * in_j, float const * in_k,
+                             float const * q_r, float const * q_i, float const * q_j, float const * q_k,
+                             size_t nbr_of_vectors,
+                             float * out_i, float * out_j, float * out_k);
+template void rotate_by_quats_R_batch<double>(double const * in_i, double const * in_j, double const * in_k,
+                             double const * q_r, double const * q_i, double const * q_j, double const * q_k,
+                             size_t nbr_of_vectors,
+                             double * out_i, double * out_j, double * out_k);
+
+template void quat_slerp<float>(quat_t<float> const * q_0, quat_t<float> const * q_1, float t, quat_t<float> * q_out);
+template void quat_slerp<double>(quat_t<double> const * q_0, quat_t<double> const * q_1, double t, quat_t<double> * q_out);
+template void interpolation_fractions_batch<float>(uint32_t t_0, uint32_t t_1, uint32_t const * timestamps,
+                                   size_t nbr_of_fractions, float * fractions);
+template void interpolation_fractions_batch<double>(uint32_t t_0, uint32_t t_1, uint32_t const * timestamps,
+                                   size_t nbr_of_fractions, double * fractions);
+template void quat_slerp_batch<float>(quat_t<float> const * q_0, quat_t<float> const * q_1,
+                      float const * fractions, size_t nbr_of_fractions,
+                      float * q_r, float * q_i, float * q_j, float * q_k);
+template void quat_slerp_batch<double>(quat_t<double> const * q_0, quat_t<double> const * q_1,
+                      double const * fractions, size_t nbr_of_fractions,
+                      double * q_r, double * q_i, double * q_j, double * q_k);
+template void quat_nlerp_batch<float>(quat_t<float> const * q_0, quat_t<float> const * q_1,
+                      float const * fractions, size_t nbr_of_fractions,
+                      float * q_r, float * q_i, float * q_j, float * q_k);
+template void quat_nlerp_batch<double>(quat_t<double> const * q_0, quat_t<double> const * q_1,
+                      double const * fractions, size_t nbr_of_fractions,
+                      double * q_r, double * q_i, double * q_j, double * q_k);
+
+template void euler_zyx_to_rotation_matrix<float>(float const yaw_rad, float const pitch_rad, float const roll_rad, float matrix[9]);
+template void euler_zyx_to_rotation_matrix<double>(double const yaw_rad, double const pitch_rad, double const roll_rad, double matrix[9]);
+
+}  // namespace kiss3d
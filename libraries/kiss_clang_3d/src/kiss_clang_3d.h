@@ -0,0 +1,1103 @@
+#ifndef KISS_CLANG_3D_UTILS_H
+#define KISS_CLANG_3D_UTILS_H
+
+#include <cmath>
+#include <cstddef>
+#include <stdint.h>
+
+// TODO
+// 1
+// rather than having an annoying (axis, angle) format for rotations,
+// define a custom struct for rotation definition
+// 2
+// add a function to determine if 2 rotations are identical but written
+// in different ways
+// 3 
+// add a function to reduce a rotation to a canonical form
+// 4
+// check for more optimal ways to compute quaternion product, rotation by
+// quaternion, and both of these using specifically unit quaternions; for this,
+// write funcs to work with specifically unit quaternions
+// 5
+// add function variations without the boolean checks
+// (4 and 5 are partly done: see the unit_quat_ functions)
+
+// TODO
+// think if should remove some of the checks if things are unitary or not etc
+
+// ------------------------------------------------------------
+// MACROS
+// ------------------------------------------------------------
+
+#define XSTR(x) STR(x)
+#define STR(x) #x
+
+// what fundamental type do we want to use?
+// if the F_TYPE_SWITCH is set (by defining the macro earlier, either before #includ-ing, or
+// by defining the compilation flag -DF_TYPE_SWITCH="'X'" where X is the type flag wanted),
+// use it, otherwise, use the value set under.
+// since the library is compiled once (kiss_clang_3d.cpp) and linked into the sketch, the switch must be
+// the same in all translation units: prefer the compilation flag to a #define before #include-ing.
+#ifndef F_TYPE_SWITCH
+  // double is 'D', float is 'F'
+  #define F_TYPE_SWITCH 'F'
+#endif
+
+// this is the scalar type of the C-style API (vec3, quat, and the functions working on these); the templated
+// API in the kiss3d namespace (vec3_t<T>, quat_t<T>) can be used with float and double side by side, whatever
+// this switch.
+#if (F_TYPE_SWITCH == 'F')
+    #define F_TYPE float
+    #define F_CAST (float)
+
+    #define F_SFX f
+
+    #define F_TYPE_2 (2.0f)
+    #define F_TYPE_1 (1.0f)
+    #define F_TYPE_0 (0.0f)
+    #define F_TYPE_05 (0.5f)
+    #define F_TYPE_PI (3.14159265358979323846f)
+    // TODO: is there a way to write a float in scientific notation?
+    #define DEFAULT_TOL (0.0001f)
+
+    #define F_TYPE_ABS(x) fabsf(x)
+    #define F_TYPE_SQRT(x) sqrtf(x)
+    #define F_TYPE_COS(x) cosf(x)
+    #define F_TYPE_SIN(x) sinf(x)
+    #define F_TYPE_ACOS(x) acosf(x)
+
+#elif (F_TYPE_SWITCH == 'D')
+    #define F_TYPE double
+    #define F_CAST (double)
+
+    #define F_SFX
+
+    #define F_TYPE_2 (2.0)
+    #define F_TYPE_1 (1.0)
+    #define F_TYPE_0 (0.0)
+    #define F_TYPE_05 (0.5)
+    #define F_TYPE_PI (3.14159265358979323846)
+    #define DEFAULT_TOL (1.0e-6)
+
+    #define F_TYPE_ABS(x) fabs(x)
+    #define F_TYPE_SQRT(x) sqrt(x)
+    #define F_TYPE_COS(x) cos(x)
+    #define F_TYPE_SIN(x) sin(x)
+    #define F_TYPE_ACOS(x) acos(x)
+#else
+    #pragma message "The value of F_TYPE_SWITCH: " XSTR(F_TYPE_SWITCH)
+    #error "invalid F_TYPE_SWITCH admissible switches are F (float) and D (double)"
+#endif
+
+// the unit_quat_ functions do not check their input, for speed; to check in a debug build that they are
+// indeed given unit quaternions and unit axis, define KISS_CLANG_3D_DEBUG before #include-ing (or with
+// the compilation flag -DKISS_CLANG_3D_DEBUG)
+#ifdef KISS_CLANG_3D_DEBUG
+    #include <cassert>
+    #define KISS_ASSERT_UNIT_QUAT(q) assert(quat_is_unitary(q))
+    #define KISS_ASSERT_UNIT_VEC3(v) assert(scalar_traits<T>::abs(vec3_norm_square(v) - scalar_traits<T>::one()) < scalar_traits<T>::default_tol())
+#else
+    #define KISS_ASSERT_UNIT_QUAT(q)
+    #define KISS_ASSERT_UNIT_VEC3(v)
+#endif
+
+namespace kiss3d {
+
+// ------------------------------------------------------------
+// SCALAR TRAITS
+// ------------------------------------------------------------
+
+// the constants, tolerances and math functions for each scalar type; all constexpr or inline, so
+// there is no runtime cost compared to the literals and the fabsf / fabs etc calls
+template <typename T>
+struct scalar_traits;
+
+template <>
+struct scalar_traits<float> {
+    static constexpr float zero(void){return 0.0f;}
+    static constexpr float one(void){return 1.0f;}
+    static constexpr float two(void){return 2.0f;}
+    static constexpr float half(void){return 0.5f;}
+    static constexpr float pi(void){return 3.14159265358979323846f;}
+    static constexpr float default_tol(void){return 1.0e-4f;}
+    // above this cos(angle), slerp falls back to nlerp: the angle is then below ~1.8 deg,
+    // and 1/sin(angle) starts losing too many digits in single precision
+    static constexpr float slerp_threshold(void){return 0.9995f;}
+
+    static inline float abs(float x){return fabsf(x);}
+    static inline float sqrt(float x){return sqrtf(x);}
+    static inline float cos(float x){return cosf(x);}
+    static inline float sin(float x){return sinf(x);}
+    static inline float acos(float x){return acosf(x);}
+    // sin and cos of the same angle in one call, sharing the range reduction
+    static inline void sincos(float x, float * s, float * c){
+#ifdef __GNUC__
+        __builtin_sincosf(x, s, c);
+#else
+        *s = sinf(x);
+        *c = cosf(x);
+#endif
+    }
+};
+
+template <>
+struct scalar_traits<double> {
+    static constexpr double zero(void){return 0.0;}
+    static constexpr double one(void){return 1.0;}
+    static constexpr double two(void){return 2.0;}
+    static constexpr double half(void){return 0.5;}
+    static constexpr double pi(void){return 3.14159265358979323846;}
+    static constexpr double default_tol(void){return 1.0e-6;}
+    static constexpr double slerp_threshold(void){return 0.9999995;}
+
+    static inline double abs(double x){return ::fabs(x);}
+    static inline double sqrt(double x){return ::sqrt(x);}
+    static inline double cos(double x){return ::cos(x);}
+    static inline double sin(double x){return ::sin(x);}
+    static inline double acos(double x){return ::acos(x);}
+    static inline void sincos(double x, double * s, double * c){
+#ifdef __GNUC__
+        __builtin_sincos(x, s, c);
+#else
+        *s = ::sin(x);
+        *c = ::cos(x);
+#endif
+    }
+};
+
+// ------------------------------------------------------------
+// STRUCTS
+// ------------------------------------------------------------
+
+// TODO
+// change struct names to Maj first
+
+// --------------------------------------------------
+// 3D vector, components i, j, k
+template <typename T>
+struct vec3_t {
+    T i;
+    T j;
+    T k;
+};
+
+// --------------------------------------------------
+// quaternion, with real part (r), and components (i, i, k)
+template <typename T>
+struct quat_t {
+    T r;
+    T i;
+    T j;
+    T k;
+};
+
+// --------------------------------------------------
+// rotation, provided as a vector (v_i,j,k) and an angle in rads (a)
+template <typename T>
+struct varot_t {
+    vec3_t<T> v;
+    T a;
+};
+
+// ------------------------------------------------------------
+// FUNCTIONS
+// ------------------------------------------------------------
+
+// the small kernels are inline and defined here, so that they can be fully inlined in the hot
+// loops of any translation unit; the larger functions are only declared here, and compiled once,
+// for float and double, in kiss_clang_3d.cpp
+
+// ---------------------------------------------
+// VEC3 functions
+// ---------------------------------------------
+
+/*
+Setter, in the right order
+*/
+template <typename T>
+inline void vec3_setter(vec3_t<T> * v, T vi, T vj, T vk){
+    v->i = vi;
+    v->j = vj;
+    v->k = vk;
+}
+
+/*
+Copy, 'deep'.
+*/
+template <typename T>
+inline void vec3_copy(vec3_t<T> const * v_in, vec3_t<T> * v_out){
+    v_out->i = v_in->i;
+    v_out->j = v_in->j;
+    v_out->k = v_in->k;
+}
+
+/*
+Check if a vector is the null vector, up to a tolerance
+*/
+template <typename T>
+inline bool vec3_is_null(vec3_t<T> const * v1, T tolerance=scalar_traits<T>::default_tol()){
+    return(
+        scalar_traits<T>::abs(v1->i) <= tolerance &&
+        scalar_traits<T>::abs(v1->j) <= tolerance &&
+        scalar_traits<T>::abs(v1->k) <= tolerance
+    );
+}
+
+/*
+Check if 2 vectors are equal, at a tolerance precision
+*/
+template <typename T>
+inline bool vec3_equal(vec3_t<T> const * v1, vec3_t<T> const * v2, T tolerance=scalar_traits<T>::default_tol()){
+    return(
+        scalar_traits<T>::abs(v1->i - v2->i) <= tolerance &&
+        scalar_traits<T>::abs(v1->j - v2->j) <= tolerance &&
+        scalar_traits<T>::abs(v1->k - v2->k) <= tolerance
+    );
+}
+
+/*
+Compute the square norm of a vector
+*/
+template <typename T>
+inline T vec3_norm_square(vec3_t<T> const * v){
+    return (
+            (v->i * v->i) + (v->j * v->j) + (v->k * v->k)
+    );
+}
+
+/*
+Compute the norm of a vector
+*/
+template <typename T>
+inline T vec3_norm(vec3_t<T> const * v){
+    return (
+        scalar_traits<T>::sqrt(
+                (v->i * v->i) + (v->j * v->j) + (v->k * v->k)
+        )
+    );
+}
+
+/*
+Scale a vector in place
+*/
+template <typename T>
+inline void vec3_scale(vec3_t<T> * v, T scale){
+    v->i *= scale;
+    v->j *= scale;
+    v->k *= scale;
+}
+
+/*
+Add a vector v_add to an already existing vector v_acc
+*/
+template <typename T>
+inline void vec3_add(vec3_t<T> * v_acc, vec3_t<T> const * v_add){
+    v_acc->i += v_add->i;
+    v_acc->j += v_add->j;
+    v_acc->k += v_add->k;
+}
+
+/*
+Subtract a vector v_subs to an already existing vector v_acc
+*/
+template <typename T>
+inline void vec3_sub(vec3_t<T> * v_acc, vec3_t<T> const * v_sub){
+    v_acc->i -= v_sub->i;
+    v_acc->j -= v_sub->j;
+    v_acc->k -= v_sub->k;
+}
+
+/*
+Take the scalar product of 2 vectors
+*/
+template <typename T>
+inline T vec3_scalar(vec3_t<T> const * v1, vec3_t<T> const * v2){
+    return(
+        v1->i * v2->i +
+        v1->j * v2->j +
+        v1->k * v2->k
+    );
+}
+
+/*
+Take the cross product of 2 vectors v1 and v2 and put the result in v_res
+*/
+template <typename T>
+inline void vec3_cross(vec3_t<T> const * v1, vec3_t<T> const * v2, vec3_t<T> * v_res){
+    v_res->i =  v1->j * v2->k - v1->k * v2->j;
+    v_res->j = -v1->i * v2->k + v1->k * v2->i;
+    v_res->k =  v1->i * v2->j - v1->j * v2->i;
+}
+
+/*
+Normalize a vector in place; of course this does not work for the null vector, so also
+return a bool if was able to normalize or not
+*/
+template <typename T>
+bool vec3_normalize(vec3_t<T> * v);
+
+/*
+Return wether 2 vectors are colinear
+*/
+template <typename T>
+bool vec3_colinear(vec3_t<T> const * v, vec3_t<T> const * w, T tolerance=scalar_traits<T>::default_tol());
+
+// ---------------------------------------------
+// QUAT functions
+// ---------------------------------------------
+
+/*
+Setter for quaternion
+*/
+template <typename T>
+inline void quat_setter(quat_t<T> * q, T qr, T qi, T qj, T qk){
+    q->r = qr;
+    q->i = qi;
+    q->j = qj;
+    q->k = qk;
+}
+
+/*
+Copy, deep
+*/
+template <typename T>
+inline void quat_copy(quat_t<T> const * q_in, quat_t<T> * q_out){
+    q_out->r = q_in->r;
+    q_out->i = q_in->i;
+    q_out->j = q_in->j;
+    q_out->k = q_in->k;
+}
+
+/*
+Norm of a quaternion
+*/
+template <typename T>
+inline T quat_norm(quat_t<T> const * q){
+    return(
+        scalar_traits<T>::sqrt(
+            q->r * q->r + q->i * q->i + q->j * q->j + q->k * q->k
+        )
+    );
+}
+
+/*
+Square norm of a quaternion
+*/
+
+template <typename T>
+inline T quat_norm_square(quat_t<T> const * q){
+    return(
+        q->r * q->r + q->i * q->i + q->j * q->j + q->k * q->k
+    );
+}
+
+/*
+Whether or not 2 quaternions are equal up to tolerance
+*/
+template <typename T>
+inline bool quat_equal(quat_t<T> const * q_1, quat_t<T> const * q_2, T tolerance=scalar_traits<T>::default_tol()){
+    return(
+        scalar_traits<T>::abs(q_1->r - q_2->r) <= tolerance &&
+        scalar_traits<T>::abs(q_1->i - q_2->i) <= tolerance &&
+        scalar_traits<T>::abs(q_1->j - q_2->j) <= tolerance &&
+        scalar_traits<T>::abs(q_1->k - q_2->k) <= tolerance
+    );
+}
+
+/*
+Conjugate of a quaternion, in-place
+*/
+template <typename T>
+inline void quat_conj(quat_t<T> * q){
+    q->i = -q->i;
+    q->j = -q->j;
+    q->k = -q->k;
+}
+
+/*
+Whether a quaternion is unitary, i.e. has norm 1
+*/
+template <typename T>
+inline bool quat_is_unitary(quat_t<T> const * q, T tolerance=scalar_traits<T>::default_tol()){
+    return(
+        scalar_traits<T>::abs(quat_norm_square(q) - scalar_traits<T>::one()) < tolerance
+    );
+}
+
+/*
+Multiply 2 quaternions, and write the result in a third one
+*/
+// TODO: is there a more computationally efficient way to take quat product? To take quat product for unit quats?
+template <typename T>
+inline void quat_prod(quat_t<T> const * q_left, quat_t<T> const * q_right, quat_t<T> * q_result){
+    q_result->r = q_left->r * q_right->r  -  q_left->i * q_right->i  -  q_left->j * q_right->j  -  q_left->k * q_right->k;
+    q_result->i = q_left->r * q_right->i  +  q_left->i * q_right->r  +  q_left->j * q_right->k  -  q_left->k * q_right->j;
+    q_result->j = q_left->r * q_right->j  -  q_left->i * q_right->k  +  q_left->j * q_right->r  +  q_left->k * q_right->i;
+    q_result->k = q_left->r * q_right->k  +  q_left->i * q_right->j  -  q_left->j * q_right->i  +  q_left->k * q_right->r;
+}
+
+/*
+Add one quaternion to another, in place, inside an accumulator
+*/
+template <typename T>
+inline void quat_add(quat_t<T> * q_acc, quat_t<T> const * q_add){
+    q_acc->r += q_add->r;
+    q_acc->i += q_add->i;
+    q_acc->j += q_add->j;
+    q_acc->k += q_add->k;
+}
+
+/*
+Subtract one quaternion to another, in place, inside an accumulator
+*/
+template <typename T>
+inline void quat_sub(quat_t<T> * q_acc, quat_t<T> const * q_sub){
+    q_acc->r -= q_sub->r;
+    q_acc->i -= q_sub->i;
+    q_acc->j -= q_sub->j;
+    q_acc->k -= q_sub->k;
+}
+
+/*
+Inverse of a quaternion, in place. This works only for non zero quat,
+so return a boolean flag (true if success).
+*/
+template <typename T>
+bool quat_inv(quat_t<T> * q, T tolerance=scalar_traits<T>::default_tol());
+
+// ---------------------------------------------
+// QUAT and VECT functions
+// --------------------------------------------
+
+/*
+Get a vector from a quaternion. This makes sense only if the quaternion is a "pure vector",
+return a bool indicating if this is the case.
+*/
+template <typename T>
+inline bool quat_to_vec3(quat_t<T> const * q, vec3_t<T> * v_out, T tolerance=scalar_traits<T>::default_tol()){
+    v_out->i = q->i;
+    v_out->j = q->j;
+    v_out->k = q->k;
+
+    if (scalar_traits<T>::abs(q->r) > tolerance){
+        return false;
+    }
+    else{
+        return true;
+    }
+}
+
+/*
+Write the vector part into a pure vector quaternion
+*/
+template <typename T>
+inline void vec3_to_quat(vec3_t<T> const * v, quat_t<T> * q_out){
+    q_out->r = scalar_traits<T>::zero();
+    q_out->i = v->i;
+    q_out->j = v->j;
+    q_out->k = v->k;
+}
+
+/*
+Write a "rotation quaternion" given the rotation axis and angle in rad.
+This works only for non null axis vector, except if the transformation is
+the identity.
+*/
+template <typename T>
+bool rotation_to_quat(quat_t<T> * q, vec3_t<T> const * rotation_axis, T const rotation_angle_rad, T tolerance=scalar_traits<T>::default_tol());
+
+/*
+Extract the rotation axis and angle from a unit quaternion; this works
+only for unit quaternions, so return bool if is unit. We are polite and we
+return a rotation axis that has unit norm.
+*/
+template <typename T>
+bool quat_to_rotation(vec3_t<T> * rotation_axis, T * rotation_angle_rad, quat_t<T> const * q_rotation, T tolerance=scalar_traits<T>::default_tol());
+
+/*
+Rotate a vector by a given quaternion, using the direct method:
+[0, R(v)] = q x [0, v] x q*
+This is the simplest method, but quite slow.
+Only unit quaternions are pure rotations; provide a bool flag indicating if this is valid.
+*/
+template <typename T>
+bool rotate_by_quat(vec3_t<T> * v, quat_t<T> const * q, T tolerance=scalar_traits<T>::default_tol()) __attribute__((deprecated("prefer using rotate_by_quat_R with is faster")));
+
+/*
+Rotate a vector by a unit quaternion, using the "Rodriguez" formula:
+https://gamedev.stackexchange.com/questions/28395/rotating-vector3-by-a-quaternion
+q = [s, u], s the scalar part, u the vector part
+R(v) = 2.0 ( (u . v) u + (s * s - 0.5) v + s (u x v) )
+This is quite a bit faster. This assumes that a unit quaternion is provided
+(but not checked, for speed; providing a unit quaternion is the caller's
+responsibility).
+*/
+template <typename T>
+inline void rotate_by_quat_R(vec3_t<T> const * v, quat_t<T> const * q, vec3_t<T> * Rv){
+    // reminder of the formula:
+    // q = [s, u]
+    // R(v) = 2.0 ( (u . v) u + (s * s - 0.5) v + s (u x v) )
+
+    T u_dot_v = q->i * v->i + q->j * v->j + q->k * v->k;
+    T s2m05 = q->r * q->r - scalar_traits<T>::half();
+    Rv->i = scalar_traits<T>::two() * ( u_dot_v * q->i + s2m05 * v->i + q->r * ( q->j * v->k - q->k * v->j ) );
+    Rv->j = scalar_traits<T>::two() * ( u_dot_v * q->j + s2m05 * v->j + q->r * ( q->k * v->i - q->i * v->k ) );
+    Rv->k = scalar_traits<T>::two() * ( u_dot_v * q->k + s2m05 * v->k + q->r * ( q->i * v->j - q->j * v->i ) );
+}
+
+// ---------------------------------------------
+// UNIT QUAT functions
+// ---------------------------------------------
+// fast paths for unit quaternions: no validity checks, no normalization, and the inverse is the
+// conjugate; providing unit quaternions (and unit axis) is the caller's responsibility, this is only
+// checked when KISS_CLANG_3D_DEBUG is defined.
+
+/*
+Inverse of a unit quaternion, in place; this is simply the conjugate.
+*/
+template <typename T>
+inline void unit_quat_inv(quat_t<T> * q){
+    KISS_ASSERT_UNIT_QUAT(q);
+    quat_conj(q);
+}
+
+/*
+Write a unit rotation quaternion given a unit rotation axis and the angle in rad.
+*/
+template <typename T>
+void unit_quat_from_rotation(quat_t<T> * q, vec3_t<T> const * unit_rotation_axis, T const rotation_angle_rad);
+
+/*
+Extract the rotation axis and angle from a unit quaternion; the axis is undefined for the identity
+(angle 0), where it is left as the null vector.
+*/
+template <typename T>
+void unit_quat_to_rotation(vec3_t<T> * rotation_axis, T * rotation_angle_rad, quat_t<T> const * q_rotation);
+
+/*
+Get the vector part of a pure vector quaternion, without checking that the real part is null.
+*/
+template <typename T>
+inline void unit_quat_to_vec3(quat_t<T> const * q, vec3_t<T> * v_out){
+    v_out->i = q->i;
+    v_out->j = q->j;
+    v_out->k = q->k;
+}
+
+/*
+Rotate a vector in place by a unit quaternion; this is rotate_by_quat without the quat_inv
+and the two full quaternion products.
+*/
+template <typename T>
+inline void unit_quat_rotate(vec3_t<T> * v, quat_t<T> const * q){
+    KISS_ASSERT_UNIT_QUAT(q);
+
+    vec3_t<T> v_in;
+    vec3_copy(v, &v_in);
+    rotate_by_quat_R(&v_in, q, v);
+}
+
+/*
+Rotate a vector by the inverse of a unit quaternion, i.e. by its conjugate, without forming it.
+*/
+template <typename T>
+inline void unit_quat_rotate_inv(vec3_t<T> const * v, quat_t<T> const * q, vec3_t<T> * Rv){
+    KISS_ASSERT_UNIT_QUAT(q);
+
+    // same as rotate_by_quat_R, with the vector part of the quaternion negated
+    T u_dot_v = q->i * v->i + q->j * v->j + q->k * v->k;
+    T s2m05 = q->r * q->r - scalar_traits<T>::half();
+    Rv->i = scalar_traits<T>::two() * ( u_dot_v * q->i + s2m05 * v->i - q->r * ( q->j * v->k - q->k * v->j ) );
+    Rv->j = scalar_traits<T>::two() * ( u_dot_v * q->j + s2m05 * v->j - q->r * ( q->k * v->i - q->i * v->k ) );
+    Rv->k = scalar_traits<T>::two() * ( u_dot_v * q->k + s2m05 * v->k - q->r * ( q->i * v->j - q->j * v->i ) );
+}
+
+/*
+Write the 3x3 rotation matrix (row major) corresponding to a unit quaternion; this is the matrix
+form of rotate_by_quat_R, and gives the same result. Rotating a vector with the matrix is then
+only 9 multiply-adds, which is worth it when many vectors are rotated by the same quaternion.
+*/
+template <typename T>
+void quat_to_rotation_matrix(quat_t<T> const * q, T matrix[9]);
+
+/*
+Rotate a block of nbr_of_vectors vectors, given as a structure of arrays (one array per component),
+by the same unit quaternion. The rotation matrix is built once for the whole block. In place operation
+(in_X == out_X) is allowed.
+*/
+template <typename T>
+void rotate_by_quat_R_batch(T const * in_i, T const * in_j, T const * in_k,
+                            quat_t<T> const * q, size_t nbr_of_vectors,
+                            T * out_i, T * out_j, T * out_k);
+
+/*
+Rotate a block of nbr_of_vectors vectors, each by its own unit quaternion, all given as structures
+of arrays; this is rotate_by_quat_R written on plain arrays, so that the loop vectorizes.
+*/
+template <typename T>
+void rotate_by_quats_R_batch(T const * in_i, T const * in_j, T const * in_k,
+                             T const * q_r, T const * q_i, T const * q_j, T const * q_k,
+                             size_t nbr_of_vectors,
+                             T * out_i, T * out_j, T * out_k);
+
+// ---------------------------------------------
+// INTERPOLATION functions
+// ---------------------------------------------
+// interpolation between 2 unit quaternions q_0 (at t=0) and q_1 (at t=1), to resample the output of
+// a filter running at a given rate to the timestamps of sensors running at other rates. q and -q are
+// the same rotation: the interpolation always goes the short way, flipping q_1 if needed. t outside
+// of [0, 1] extrapolates. q_out may alias q_0 or q_1.
+
+/*
+Dot product of 2 quaternions, i.e. the cos of half the rotation angle between 2 unit quaternions
+*/
+template <typename T>
+inline T quat_dot(quat_t<T> const * q_1, quat_t<T> const * q_2){
+    return(
+        q_1->r * q_2->r + q_1->i * q_2->i + q_1->j * q_2->j + q_1->k * q_2->k
+    );
+}
+
+/*
+Normalized linear interpolation: lerp componentwise, and normalize. Only one sqrt, no trigonometry;
+the path is the same as slerp, but the angular velocity is not constant along it. For a filter at
+100 Hz the angle between consecutive outputs is small, and the error compared with slerp is then
+negligible (below 1e-4 rad for up to 10 deg between q_0 and q_1).
+*/
+template <typename T>
+inline void quat_nlerp(quat_t<T> const * q_0, quat_t<T> const * q_1, T t, quat_t<T> * q_out){
+    KISS_ASSERT_UNIT_QUAT(q_0);
+    KISS_ASSERT_UNIT_QUAT(q_1);
+
+    T const t_1 = (quat_dot(q_0, q_1) < scalar_traits<T>::zero()) ? -t : t;
+    T const t_0 = scalar_traits<T>::one() - t;
+
+    T const r = t_0 * q_0->r + t_1 * q_1->r;
+    T const i = t_0 * q_0->i + t_1 * q_1->i;
+    T const j = t_0 * q_0->j + t_1 * q_1->j;
+    T const k = t_0 * q_0->k + t_1 * q_1->k;
+
+    T const inv_norm = scalar_traits<T>::one() / scalar_traits<T>::sqrt(r * r + i * i + j * j + k * k);
+    q_out->r = r * inv_norm;
+    q_out->i = i * inv_norm;
+    q_out->j = j * inv_norm;
+    q_out->k = k * inv_norm;
+}
+
+/*
+Spherical linear interpolation: constant angular velocity from q_0 to q_1. Falls back to nlerp when
+q_0 and q_1 are very close (see scalar_traits<T>::slerp_threshold), where both agree to rounding and
+slerp would divide by a vanishing sin.
+*/
+template <typename T>
+void quat_slerp(quat_t<T> const * q_0, quat_t<T> const * q_1, T t, quat_t<T> * q_out);
+
+/*
+Fraction of the way of timestamp t between timestamps t_0 and t_1, as used by the interpolation
+functions; the timestamps are typically from micros() or millis(), and the difference is taken on
+unsigned integers so that it is correct across their wrap around.
+*/
+template <typename T>
+inline T interpolation_fraction(uint32_t t_0, uint32_t t_1, uint32_t t){
+    return(
+        static_cast<T>(static_cast<int32_t>(t - t_0)) / static_cast<T>(static_cast<int32_t>(t_1 - t_0))
+    );
+}
+
+/*
+Compute the nbr_of_fractions interpolation fractions of a block of timestamps between timestamps t_0 and t_1.
+*/
+template <typename T>
+void interpolation_fractions_batch(uint32_t t_0, uint32_t t_1, uint32_t const * timestamps,
+                                   size_t nbr_of_fractions, T * fractions);
+
+/*
+Slerp from q_0 to q_1 at a block of nbr_of_fractions fractions; the angle between q_0 and q_1 and its
+sin are computed once for the whole block, so each sample only costs 2 sin. The output is a structure of
+arrays, ready for rotate_by_quats_R_batch.
+*/
+template <typename T>
+void quat_slerp_batch(quat_t<T> const * q_0, quat_t<T> const * q_1,
+                      T const * fractions, size_t nbr_of_fractions,
+                      T * q_r, T * q_i, T * q_j, T * q_k);
+
+/*
+Same as quat_slerp_batch, but with nlerp: no trigonometry at all, and the loop vectorizes.
+*/
+template <typename T>
+void quat_nlerp_batch(quat_t<T> const * q_0, quat_t<T> const * q_1,
+                      T const * fractions, size_t nbr_of_fractions,
+                      T * q_r, T * q_i, T * q_j, T * q_k);
+
+// ---------------------------------------------
+// ROTATION MATRIX and ORIENTATION functions
+// ---------------------------------------------
+
+/*
+Apply a 3x3 rotation matrix (row major) to a vector; 9 multiply-adds. v and Rv must be different.
+*/
+template <typename T>
+inline void rotation_matrix_apply(T const matrix[9], vec3_t<T> const * v, vec3_t<T> * Rv){
+    Rv->i = matrix[0] * v->i + matrix[1] * v->j + matrix[2] * v->k;
+    Rv->j = matrix[3] * v->i + matrix[4] * v->j + matrix[5] * v->k;
+    Rv->k = matrix[6] * v->i + matrix[7] * v->j + matrix[8] * v->k;
+}
+
+/*
+Write the 3x3 rotation matrix (row major) of the intrinsic Z-Y-X (yaw, pitch, roll) Euler angles, i.e.
+R = Rz(yaw) Ry(pitch) Rx(roll): rotating by it is the same as rotating by roll around X, then by pitch
+around Y, then by yaw around Z.
+*/
+template <typename T>
+void euler_zyx_to_rotation_matrix(T const yaw_rad, T const pitch_rad, T const roll_rad, T matrix[9]);
+
+/*
+Rotate a vector by Z-Y-X Euler angles in one step, i.e. the same as rotating by roll around X, then pitch around
+Y, then yaw around Z, but with the combined rotation matrix, 3 paired sin / cos evaluations, and no temporaries.
+v and Rv must be different. When several vectors are rotated by the same angles, use an orientation instead.
+*/
+template <typename T>
+inline void euler_zyx_rotate(T const yaw_rad, T const pitch_rad, T const roll_rad, vec3_t<T> const * v, vec3_t<T> * Rv){
+    T matrix[9];
+    euler_zyx_to_rotation_matrix(yaw_rad, pitch_rad, roll_rad, matrix);
+    rotation_matrix_apply(matrix, v, Rv);
+}
+
+/*
+Only the k (vertical) component of euler_zyx_rotate, i.e. the last row of the rotation matrix applied to v; this
+does not depend on the yaw, so it costs only 2 paired sin / cos and 3 multiply-adds. This is for example the
+"down" (or "up") component of the acceleration given in the frame of the sensor.
+*/
+template <typename T>
+inline T euler_zyx_rotate_k(T const pitch_rad, T const roll_rad, vec3_t<T> const * v){
+    T sp, cp, sr, cr;
+    scalar_traits<T>::sincos(pitch_rad, &sp, &cp);
+    scalar_traits<T>::sincos(roll_rad, &sr, &cr);
+    return -sp * v->i + cp * (sr * v->j + cr * v->k);
+}
+
+/*
+An orientation, set from a unit quaternion or from Euler angles, used to transform several vectors: the
+rotation matrix is built on the first transform after each update and cached, so that each transform is
+then only 9 multiply-adds, and an orientation that is updated but not used costs nothing. Set it with the
+orientation_set_ functions only, so that the cache is invalidated.
+*/
+enum class orientation_source : unsigned char {quat, euler_zyx};
+
+template <typename T>
+struct orientation_t {
+    quat_t<T> q;
+    T yaw_rad;
+    T pitch_rad;
+    T roll_rad;
+    orientation_source source;
+    T matrix[9];
+    bool matrix_is_valid;
+};
+
+/*
+Set an orientation to the identity
+*/
+template <typename T>
+inline void orientation_init(orientation_t<T> * o){
+    quat_setter(&o->q, scalar_traits<T>::one(), scalar_traits<T>::zero(), scalar_traits<T>::zero(), scalar_traits<T>::zero());
+    o->source = orientation_source::quat;
+    o->matrix_is_valid = false;
+}
+
+/*
+Set an orientation from a unit quaternion
+*/
+template <typename T>
+inline void orientation_set_quat(orientation_t<T> * o, quat_t<T> const * q){
+    quat_copy(q, &o->q);
+    o->source = orientation_source::quat;
+    o->matrix_is_valid = false;
+}
+
+/*
+Set an orientation from Z-Y-X Euler angles, see euler_zyx_to_rotation_matrix
+*/
+template <typename T>
+inline void orientation_set_euler_zyx(orientation_t<T> * o, T const yaw_rad, T const pitch_rad, T const roll_rad){
+    o->yaw_rad = yaw_rad;
+    o->pitch_rad = pitch_rad;
+    o->roll_rad = roll_rad;
+    o->source = orientation_source::euler_zyx;
+    o->matrix_is_valid = false;
+}
+
+/*
+Get the rotation matrix (row major) of an orientation, building it if needed
+*/
+template <typename T>
+inline T const * orientation_rotation_matrix(orientation_t<T> * o){
+    if (!o->matrix_is_valid){
+        if (o->source == orientation_source::quat){
+            quat_to_rotation_matrix(&o->q, o->matrix);
+        }
+        else{
+            euler_zyx_to_rotation_matrix(o->yaw_rad, o->pitch_rad, o->roll_rad, o->matrix);
+        }
+        o->matrix_is_valid = true;
+    }
+    return o->matrix;
+}
+
+/*
+Rotate a vector by an orientation. v and Rv must be different.
+*/
+template <typename T>
+inline void orientation_rotate(orientation_t<T> * o, vec3_t<T> const * v, vec3_t<T> * Rv){
+    rotation_matrix_apply(orientation_rotation_matrix(o), v, Rv);
+}
+
+}  // namespace kiss3d
+
+// ------------------------------------------------------------
+// C-STYLE API
+// ------------------------------------------------------------
+
+// the C-style types and functions, on the F_TYPE scalar, are thin wrappers around the templated API
+// above; see there for the documentation of each function
+
+typedef kiss3d::vec3_t<F_TYPE> vec3;
+typedef kiss3d::quat_t<F_TYPE> quat;
+typedef kiss3d::varot_t<F_TYPE> varot;
+typedef kiss3d::orientation_t<F_TYPE> orientation;
+
+static inline void vec3_setter(vec3 * v, F_TYPE vi, F_TYPE vj, F_TYPE vk){
+    kiss3d::vec3_setter(v, vi, vj, vk);
+}
+
+static inline void vec3_copy(vec3 const * v_in, vec3 * v_out){
+    kiss3d::vec3_copy(v_in, v_out);
+}
+
+static inline bool vec3_is_null(vec3 const * v1, F_TYPE tolerance=DEFAULT_TOL){
+    return kiss3d::vec3_is_null(v1, tolerance);
+}
+
+static inline bool vec3_equal(vec3 const * v1, vec3 const * v2, F_TYPE tolerance=DEFAULT_TOL){
+    return kiss3d::vec3_equal(v1, v2, tolerance);
+}
+
+static inline F_TYPE vec3_norm_square(vec3 const * v){
+    return kiss3d::vec3_norm_square(v);
+}
+
+static inline F_TYPE vec3_norm(vec3 const * v){
+    return kiss3d::vec3_norm(v);
+}
+
+static inline void vec3_scale(vec3 * v, F_TYPE scale){
+    kiss3d::vec3_scale(v, scale);
+}
+
+static inline void vec3_add(vec3 * v_acc, vec3 const * v_add){
+    kiss3d::vec3_add(v_acc, v_add);
+}
+
+static inline void vec3_sub(vec3 * v_acc, vec3 const * v_sub){
+    kiss3d::vec3_sub(v_acc, v_sub);
+}
+
+static inline F_TYPE vec3_scalar(vec3 const * v1, vec3 const * v2){
+    return kiss3d::vec3_scalar(v1, v2);
+}
+
+static inline void vec3_cross(vec3 const * v1, vec3 const * v2, vec3 * v_res){
+    kiss3d::vec3_cross(v1, v2, v_res);
+}
+
+static inline bool vec3_normalize(vec3 * v){
+    return kiss3d::vec3_normalize(v);
+}
+
+static inline bool vec3_colinear(vec3 const * v, vec3 const * w, F_TYPE tolerance=DEFAULT_TOL){
+    return kiss3d::vec3_colinear(v, w, tolerance);
+}
+
+static inline void quat_setter(quat * q, F_TYPE qr, F_TYPE qi, F_TYPE qj, F_TYPE qk){
+    kiss3d::quat_setter(q, qr, qi, qj, qk);
+}
+
+static inline void quat_copy(quat const * q_in, quat * q_out){
+    kiss3d::quat_copy(q_in, q_out);
+}
+
+static inline F_TYPE quat_norm(quat const * q){
+    return kiss3d::quat_norm(q);
+}
+
+static inline F_TYPE quat_norm_square(quat const * q){
+    return kiss3d::quat_norm_square(q);
+}
+
+static inline bool quat_equal(quat const * q_1, quat const * q_2, F_TYPE tolerance=DEFAULT_TOL){
+    return kiss3d::quat_equal(q_1, q_2, tolerance);
+}
+
+static inline void quat_conj(quat * q){
+    kiss3d::quat_conj(q);
+}
+
+static inline bool quat_is_unitary(quat const * q, F_TYPE tolerance=DEFAULT_TOL){
+    return kiss3d::quat_is_unitary(q, tolerance);
+}
+
+static inline void quat_prod(quat const * q_left, quat const * q_right, quat * q_result){
+    kiss3d::quat_prod(q_left, q_right, q_result);
+}
+
+static inline void quat_add(quat * q_acc, quat const * q_add){
+    kiss3d::quat_add(q_acc, q_add);
+}
+
+static inline void quat_sub(quat * q_acc, quat const * q_sub){
+    kiss3d::quat_sub(q_acc, q_sub);
+}
+
+static inline bool quat_inv(quat * q, F_TYPE tolerance=DEFAULT_TOL){
+    return kiss3d::quat_inv(q, tolerance);
+}
+
+static inline bool quat_to_vec3(quat const * q, vec3 * v_out, F_TYPE tolerance=DEFAULT_TOL){
+    return kiss3d::quat_to_vec3(q, v_out, tolerance);
+}
+
+static inline void vec3_to_quat(vec3 const * v, quat * q_out){
+    kiss3d::vec3_to_quat(v, q_out);
+}
+
+static inline bool rotation_to_quat(quat * q, vec3 const * rotation_axis, F_TYPE const rotation_angle_rad, F_TYPE tolerance=DEFAULT_TOL){
+    return kiss3d::rotation_to_quat(q, rotation_axis, rotation_angle_rad, tolerance);
+}
+
+static inline bool quat_to_rotation(vec3 * rotation_axis, F_TYPE * rotation_angle_rad, quat const * q_rotation, F_TYPE tolerance=DEFAULT_TOL){
+    return kiss3d::quat_to_rotation(rotation_axis, rotation_angle_rad, q_rotation, tolerance);
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+__attribute__((deprecated("prefer using rotate_by_quat_R with is faster")))
+static inline bool rotate_by_quat(vec3 * v, quat const * q, F_TYPE tolerance=DEFAULT_TOL){
+    return kiss3d::rotate_by_quat(v, q, tolerance);
+}
+#pragma GCC diagnostic pop
+
+static inline void rotate_by_quat_R(vec3 const * v, quat const * q, vec3 * Rv){
+    kiss3d::rotate_by_quat_R(v, q, Rv);
+}
+
+static inline void unit_quat_inv(quat * q){
+    kiss3d::unit_quat_inv(q);
+}
+
+static inline void unit_quat_from_rotation(quat * q, vec3 const * unit_rotation_axis, F_TYPE const rotation_angle_rad){
+    kiss3d::unit_quat_from_rotation(q, unit_rotation_axis, rotation_angle_rad);
+}
+
+static inline void unit_quat_to_rotation(vec3 * rotation_axis, F_TYPE * rotation_angle_rad, quat const * q_rotation){
+    kiss3d::unit_quat_to_rotation(rotation_axis, rotation_angle_rad, q_rotation);
+}
+
+static inline void unit_quat_to_vec3(quat const * q, vec3 * v_out){
+    kiss3d::unit_quat_to_vec3(q, v_out);
+}
+
+static inline void unit_quat_rotate(vec3 * v, quat const * q){
+    kiss3d::unit_quat_rotate(v, q);
+}
+
+static inline void unit_quat_rotate_inv(vec3 const * v, quat const * q, vec3 * Rv){
+    kiss3d::unit_quat_rotate_inv(v, q, Rv);
+}
+
+static inline void quat_to_rotation_matrix(quat const * q, F_TYPE matrix[9]){
+    kiss3d::quat_to_rotation_matrix(q, matrix);
+}
+
+static inline void rotate_by_quat_R_batch(F_TYPE const * in_i, F_TYPE const * in_j, F_TYPE const * in_k,
+                            quat const * q, size_t nbr_of_vectors,
+                            F_TYPE * out_i, F_TYPE * out_j, F_TYPE * out_k){
+    kiss3d::rotate_by_quat_R_batch(in_i, in_j, in_k, q, nbr_of_vectors, out_i, out_j, out_k);
+}
+
+static inline void rotate_by_quats_R_batch(F_TYPE const * in_i, F_TYPE const * in_j, F_TYPE const * in_k,
+                             F_TYPE const * q_r, F_TYPE const * q_i, F_TYPE const * q_j, F_TYPE const * q_k,
+                             size_t nbr_of_vectors,
+                             F_TYPE * out_i, F_TYPE * out_j, F_TYPE * out_k){
+    kiss3d::rotate_by_quats_R_batch(in_i, in_j, in_k, q_r, q_i, q_j, q_k, nbr_of_vectors, out_i, out_j, out_k);
+}
+
+static inline F_TYPE quat_dot(quat const * q_1, quat const * q_2){
+    return kiss3d::quat_dot(q_1, q_2);
+}
+
+static inline void quat_nlerp(quat const * q_0, quat const * q_1, F_TYPE t, quat * q_out){
+    kiss3d::quat_nlerp(q_0, q_1, t, q_out);
+}
+
+static inline void quat_slerp(quat const * q_0, quat const * q_1, F_TYPE t, quat * q_out){
+    kiss3d::quat_slerp(q_0, q_1, t, q_out);
+}
+
+static inline F_TYPE interpolation_fraction(uint32_t t_0, uint32_t t_1, uint32_t t){
+    return kiss3d::interpolation_fraction<F_TYPE>(t_0, t_1, t);
+}
+
+static inline void interpolation_fractions_batch(uint32_t t_0, uint32_t t_1, uint32_t const * timestamps,
+                                   size_t nbr_of_fractions, F_TYPE * fractions){
+    kiss3d::interpolation_fractions_batch(t_0, t_1, timestamps, nbr_of_fractions, fractions);
+}
+
+static inline void quat_slerp_batch(quat const * q_0, quat const * q_1,
+                      F_TYPE const * fractions, size_t nbr_of_fractions,
+                      F_TYPE * q_r, F_TYPE * q_i, F_TYPE * q_j, F_TYPE * q_k){
+    kiss3d::quat_slerp_batch(q_0, q_1, fractions, nbr_of_fractions, q_r, q_i, q_j, q_k);
+}
+
+static inline void quat_nlerp_batch(quat const * q_0, quat const * q_1,
+                      F_TYPE const * fractions, size_t nbr_of_fractions,
+                      F_TYPE * q_r, F_TYPE * q_i, F_TYPE * q_j, F_TYPE * q_k){
+    kiss3d::quat_nlerp_batch(q_0, q_1, fractions, nbr_of_fractions, q_r, q_i, q_j, q_k);
+}
+
+static inline void rotation_matrix_apply(F_TYPE const matrix[9], vec3 const * v, vec3 * Rv){
+    kiss3d::rotation_matrix_apply(matrix, v, Rv);
+}
+
+static inline void euler_zyx_to_rotation_matrix(F_TYPE const yaw_rad, F_TYPE const pitch_rad, F_TYPE const roll_rad, F_TYPE matrix[9]){
+    kiss3d::euler_zyx_to_rotation_matrix(yaw_rad, pitch_rad, roll_rad, matrix);
+}
+
+static inline void euler_zyx_rotate(F_TYPE const yaw_rad, F_TYPE const pitch_rad, F_TYPE const roll_rad, vec3 const * v, vec3 * Rv){
+    kiss3d::euler_zyx_rotate(yaw_rad, pitch_rad, roll_rad, v, Rv);
+}
+
+static inline F_TYPE euler_zyx_rotate_k(F_TYPE const pitch_rad, F_TYPE const roll_rad, vec3 const * v){
+    return kiss3d::euler_zyx_rotate_k(pitch_rad, roll_rad, v);
+}
+
+static inline void orientation_init(orientation * o){
+    kiss3d::orientation_init(o);
+}
+
+static inline void orientation_set_quat(orientation * o, quat const * q){
+    kiss3d::orientation_set_quat(o, q);
+}
+
+static inline void orientation_set_euler_zyx(orientation * o, F_TYPE const yaw_rad, F_TYPE const pitch_rad, F_TYPE const roll_rad){
+    kiss3d::orientation_set_euler_zyx(o, yaw_rad, pitch_rad, roll_rad);
+}
+
+static inline F_TYPE const * orientation_rotation_matrix(orientation * o){
+    return kiss3d::orientation_rotation_matrix(o);
+}
+
+static inline void orientation_rotate(orientation * o, vec3 const * v, vec3 * Rv){
+    kiss3d::orientation_rotate(o, v, Rv);
+}
+
+#endif
@@ -0,0 +1,65 @@
+// time the CRC variants of kiss_crc on the board, with the cycle counter of the Cortex-M4 (DWT);
+// run it, then look at the bytes per cycle printed for each variant. All the variants of a same
+// CRC must give the same value.
+
+#include "Arduino.h"
+#include <kiss_crc.h>
+
+static constexpr size_t nbr_bytes {1024};
+static constexpr int nbr_repeats {16};
+
+uint8_t data[nbr_bytes];
+
+void enable_cycle_counter(void){
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+template <typename Function>
+void time_crc(char const * name, Function && function){
+  uint32_t result {0};
+
+  uint32_t const cycles_start = DWT->CYCCNT;
+  for (int ind=0; ind<nbr_repeats; ind++){
+    result = function(data, nbr_bytes);
+  }
+  uint32_t const cycles = DWT->CYCCNT - cycles_start;
+
+  Serial.print(name);
+  Serial.print(F(": 0x"));
+  Serial.print(result, HEX);
+  Serial.print(F(", "));
+  Serial.print(static_cast<float>(cycles) / (nbr_bytes * nbr_repeats), 2);
+  Serial.print(F(" cycles / byte, "));
+  Serial.print(static_cast<float>(nbr_bytes * nbr_repeats) / cycles, 4);
+  Serial.println(F(" bytes / cycle"));
+}
+
+void setup(){
+  Serial.begin(1000000);
+  delay(10);
+  Serial.println();
+  Serial.println(F("------------------------------------- booted -------------------------------------"));
+
+  for (size_t ind=0; ind<nbr_bytes; ind++){
+    data[ind] = static_cast<uint8_t>(ind * 31 + 7);
+  }
+
+  enable_cycle_counter();
+
+  Serial.print(F("CRC over ")); Serial.print(nbr_bytes); Serial.print(F(" bytes, ")); Serial.print(nbr_repeats); Serial.println(F(" times"));
+
+  time_crc("crc8_dallas        ", [](uint8_t const * d, size_t n){ return static_cast<uint32_t>(kiss_crc::crc8_dallas(d, n)); });
+  time_crc("crc8_dallas_nibble ", [](uint8_t const * d, size_t n){ return static_cast<uint32_t>(kiss_crc::crc8_dallas_nibble(d, n)); });
+  time_crc("crc8_dallas_bitwise", [](uint8_t const * d, size_t n){ return static_cast<uint32_t>(kiss_crc::crc8_dallas_bitwise(d, n)); });
+  time_crc("crc16_ccitt        ", [](uint8_t const * d, size_t n){ return static_cast<uint32_t>(kiss_crc::crc16_ccitt(d, n)); });
+  time_crc("crc16_ccitt_nibble ", [](uint8_t const * d, size_t n){ return static_cast<uint32_t>(kiss_crc::crc16_ccitt_nibble(d, n)); });
+  time_crc("crc16_ccitt_bitwise", [](uint8_t const * d, size_t n){ return static_cast<uint32_t>(kiss_crc::crc16_ccitt_bitwise(d, n)); });
+  time_crc("crc32              ", [](uint8_t const * d, size_t n){ return kiss_crc::crc32(d, n); });
+  time_crc("crc32_nibble       ", [](uint8_t const * d, size_t n){ return kiss_crc::crc32_nibble(d, n); });
+  time_crc("crc32_bitwise      ", [](uint8_t const * d, size_t n){ return kiss_crc::crc32_bitwise(d, n); });
+}
+
+void loop(){
+}
@@ -0,0 +1,128 @@
+// check the table driven and nibble CRCs against the bitwise reference and the standard check
+// values, and time them, on a computer:
+//
+//   g++ -O2 -std=c++11 -I../src crc_check.cpp -o crc_check
+//   ./crc_check
+//
+// on x86 the timings are also given in bytes per cycle of the time stamp counter; the numbers on
+// the Artemis are given by examples/crc_benchmark.
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAS_TSC 1
+#else
+#define HAS_TSC 0
+#endif
+
+#include "kiss_crc.h"
+
+using namespace kiss_crc;
+
+static unsigned long nbr_errors {0};
+
+template <typename T>
+static void expect_equal(char const * what, T const result, T const expected){
+  if (result != expected){
+    printf("ERROR %s: got 0x%lX, expected 0x%lX\n", what, static_cast<unsigned long>(result), static_cast<unsigned long>(expected));
+    nbr_errors++;
+  }
+}
+
+template <typename Function>
+static void time_crc(char const * name, Function && function, std::vector<uint8_t> const & data){
+  constexpr int nbr_repeats {200};
+  unsigned long checksum {0};
+
+  auto const time_start = std::chrono::steady_clock::now();
+#if HAS_TSC
+  uint64_t const tsc_start = __rdtsc();
+#endif
+  for (int ind=0; ind<nbr_repeats; ind++){
+    checksum += function(data.data(), data.size());
+  }
+#if HAS_TSC
+  uint64_t const tsc_cycles = __rdtsc() - tsc_start;
+#endif
+  double const ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - time_start).count();
+  double const nbr_bytes = static_cast<double>(data.size()) * nbr_repeats;
+
+  printf("%-22s %8.3f bytes / ns", name, nbr_bytes / ns);
+#if HAS_TSC
+  printf(" %8.3f bytes / TSC cycle", nbr_bytes / tsc_cycles);
+#endif
+  printf("  (checksum %lu)\n", checksum);
+}
+
+int main(){
+  // the standard check values, on "123456789"
+  uint8_t const check_input[] {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+  expect_equal("crc8_dallas check", crc8_dallas(check_input, 9), static_cast<uint8_t>(0xA1));
+  expect_equal("crc8_dallas_nibble check", crc8_dallas_nibble(check_input, 9), static_cast<uint8_t>(0xA1));
+  expect_equal("crc8_dallas_bitwise check", crc8_dallas_bitwise(check_input, 9), static_cast<uint8_t>(0xA1));
+  expect_equal("crc16_ccitt check", crc16_ccitt(check_input, 9), static_cast<uint16_t>(0x29B1));
+  expect_equal("crc16_ccitt_nibble check", crc16_ccitt_nibble(check_input, 9), static_cast<uint16_t>(0x29B1));
+  expect_equal("crc16_ccitt_bitwise check", crc16_ccitt_bitwise(check_input, 9), static_cast<uint16_t>(0x29B1));
+  expect_equal("crc32 check", crc32(check_input, 9), static_cast<uint32_t>(0xCBF43926));
+  expect_equal("crc32_nibble check", crc32_nibble(check_input, 9), static_cast<uint32_t>(0xCBF43926));
+  expect_equal("crc32_bitwise check", crc32_bitwise(check_input, 9), static_cast<uint32_t>(0xCBF43926));
+
+  // a DS18B20 ROM code and scratchpad: the CRC over all the bytes, including the CRC, is 0
+  uint8_t const rom[8] {0x28, 0xFF, 0x64, 0x1E, 0x0F, 0x75, 0x26, 0x7A};
+  uint8_t rom_crc = crc8_dallas_bitwise(rom, 7);
+  uint8_t rom_with_crc[8];
+  memcpy(rom_with_crc, rom, 7);
+  rom_with_crc[7] = rom_crc;
+  expect_equal("crc8_dallas over ROM and CRC", crc8_dallas(rom_with_crc, 8), static_cast<uint8_t>(0));
+
+  // random buffers, and incremental computation over 2 parts
+  std::mt19937 generator {1};
+  for (int ind=0; ind<20000; ind++){
+    std::vector<uint8_t> data(generator() % 300);
+    for (auto & crrt_byte : data){
+      crrt_byte = static_cast<uint8_t>(generator());
+    }
+    size_t const split = data.empty() ? 0 : generator() % data.size();
+
+    uint8_t const ref_8 = crc8_dallas_bitwise(data.data(), data.size());
+    expect_equal("crc8_dallas", crc8_dallas(data.data(), data.size()), ref_8);
+    expect_equal("crc8_dallas_nibble", crc8_dallas_nibble(data.data(), data.size()), ref_8);
+    expect_equal("crc8_dallas split", crc8_dallas(data.data() + split, data.size() - split, crc8_dallas(data.data(), split)), ref_8);
+
+    uint16_t const ref_16 = crc16_ccitt_bitwise(data.data(), data.size());
+    expect_equal("crc16_ccitt", crc16_ccitt(data.data(), data.size()), ref_16);
+    expect_equal("crc16_ccitt_nibble", crc16_ccitt_nibble(data.data(), data.size()), ref_16);
+    expect_equal("crc16_ccitt split", crc16_ccitt(data.data() + split, data.size() - split, crc16_ccitt(data.data(), split)), ref_16);
+
+    uint32_t const ref_32 = crc32_bitwise(data.data(), data.size());
+    expect_equal("crc32", crc32(data.data(), data.size()), ref_32);
+    expect_equal("crc32_nibble", crc32_nibble(data.data(), data.size()), ref_32);
+    expect_equal("crc32 split", ~crc32_update(data.data() + split, data.size() - split, crc32_update(data.data(), split)), ref_32);
+  }
+
+  printf("checks done, %lu errors\n", nbr_errors);
+
+  // timings, on 4 kB
+  std::vector<uint8_t> data(4096);
+  for (auto & crrt_byte : data){
+    crrt_byte = static_cast<uint8_t>(generator());
+  }
+
+  time_crc("crc8_dallas", [](uint8_t const * d, size_t n){ return crc8_dallas(d, n); }, data);
+  time_crc("crc8_dallas_nibble", [](uint8_t const * d, size_t n){ return crc8_dallas_nibble(d, n); }, data);
+  time_crc("crc8_dallas_bitwise", [](uint8_t const * d, size_t n){ return crc8_dallas_bitwise(d, n); }, data);
+  time_crc("crc16_ccitt", [](uint8_t const * d, size_t n){ return crc16_ccitt(d, n); }, data);
+  time_crc("crc16_ccitt_nibble", [](uint8_t const * d, size_t n){ return crc16_ccitt_nibble(d, n); }, data);
+  time_crc("crc16_ccitt_bitwise", [](uint8_t const * d, size_t n){ return crc16_ccitt_bitwise(d, n); }, data);
+  time_crc("crc32", [](uint8_t const * d, size_t n){ return crc32(d, n); }, data);
+  time_crc("crc32_nibble", [](uint8_t const * d, size_t n){ return crc32_nibble(d, n); }, data);
+  time_crc("crc32_bitwise", [](uint8_t const * d, size_t n){ return crc32_bitwise(d, n); }, data);
+
+  return (nbr_errors == 0) ? 0 : 1;
+}
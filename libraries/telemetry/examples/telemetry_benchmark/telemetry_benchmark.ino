@@ -0,0 +1,78 @@
+// compare the cost of sending the same records as text (Serial.print of each value) and as binary
+// telemetry frames; run it, then look at the timings printed at the end. The binary frames in the
+// middle of the output can be decoded with extras/telemetry_decode.py (type id 2).
+
+#include "Arduino.h"
+#include <telemetry_frame.h>
+
+static constexpr uint8_t telemetry_type_benchmark {2};
+static constexpr size_t nbr_records {200};
+static constexpr size_t nbr_values {9};
+
+TelemetryWriter<nbr_values * sizeof(float)> telemetry_writer;
+float values[nbr_values];
+
+void fill_values(size_t const record){
+  for (size_t ind=0; ind<nbr_values; ind++){
+    values[ind] = 0.001f * record * (ind + 1) - 4.5f;
+  }
+}
+
+void setup(){
+  Serial.begin(1000000);
+  delay(10);
+  Serial.println();
+  Serial.println(F("------------------------------------- booted -------------------------------------"));
+  delay(100);
+
+  // text output
+  size_t nbr_bytes_text {0};
+  unsigned long micros_start = micros();
+  for (size_t record=0; record<nbr_records; record++){
+    fill_values(record);
+    nbr_bytes_text += Serial.print(micros());
+    for (size_t ind=0; ind<nbr_values; ind++){
+      nbr_bytes_text += Serial.print(F(", "));
+      nbr_bytes_text += Serial.print(values[ind], 4);
+    }
+    nbr_bytes_text += Serial.println();
+  }
+  Serial.flush();
+  unsigned long const micros_text = micros() - micros_start;
+
+  delay(100);
+
+  // binary output; a lone delimiter first, so that the decoder drops whatever text came before
+  size_t nbr_bytes_binary {0};
+  Serial.write(static_cast<uint8_t>(0x00));
+  micros_start = micros();
+  for (size_t record=0; record<nbr_records; record++){
+    fill_values(record);
+    telemetry_writer.begin(telemetry_type_benchmark, micros());
+    telemetry_writer.put_array(values, nbr_values);
+    size_t const frame_length = telemetry_writer.finish();
+    nbr_bytes_binary += Serial.write(telemetry_writer.frame(), frame_length);
+  }
+  Serial.flush();
+  unsigned long const micros_binary = micros() - micros_start;
+
+  // the encoding alone, without the UART
+  micros_start = micros();
+  for (size_t record=0; record<nbr_records; record++){
+    fill_values(record);
+    telemetry_writer.begin(telemetry_type_benchmark, micros());
+    telemetry_writer.put_array(values, nbr_values);
+    telemetry_writer.finish();
+  }
+  unsigned long const micros_encoding = micros() - micros_start;
+
+  delay(100);
+  Serial.println();
+  Serial.print(F("records: ")); Serial.print(nbr_records); Serial.print(F(" of ")); Serial.print(nbr_values); Serial.println(F(" floats"));
+  Serial.print(F("text:   ")); Serial.print(nbr_bytes_text); Serial.print(F(" bytes, ")); Serial.print(micros_text); Serial.println(F(" us"));
+  Serial.print(F("binary: ")); Serial.print(nbr_bytes_binary); Serial.print(F(" bytes, ")); Serial.print(micros_binary); Serial.println(F(" us"));
+  Serial.print(F("binary encoding only: ")); Serial.print(micros_encoding); Serial.println(F(" us"));
+}
+
+void loop(){
+}
@@ -0,0 +1,124 @@
+// check format_float against snprintf, and time it against dtostrf and snprintf, on a computer:
+//
+//   g++ -O2 -std=c++11 -I../src float_format_check.cpp -o float_format_check
+//   ./float_format_check
+//
+// the check compares the strings for random floats (all exponents) and all the precisions; the
+// output must be identical to the correctly rounded printf("%*.*f"), which also guarantees that
+// parsing the text back gives the closest value at that precision.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <cfloat>
+#include <cstdint>
+#include <chrono>
+#include <random>
+
+#include "float_format.h"
+
+// the dtostrf of the Arduino cores (ard_supers/avr/dtostrf.c), through printf
+static char * dtostrf(double val, signed char width, unsigned char prec, char * sout){
+  char fmt[20];
+  sprintf(fmt, "%%%d.%df", width, prec);
+  sprintf(sout, fmt, val);
+  return sout;
+}
+
+static bool check_one(float const value, int const width, uint8_t const precision, unsigned long & nbr_errors){
+  char expected[128];
+  char result[128];
+
+  if (std::isnan(value) || std::isinf(value) || (std::fabs(value) >= 1e18f)){
+    return true;
+  }
+
+  snprintf(expected, sizeof(expected), "%*.*f", width, precision, static_cast<double>(value));
+  format_float(result, sizeof(result), value, width, precision);
+
+  if (strcmp(expected, result) != 0){
+    if (nbr_errors < 10){
+      printf("mismatch for %.9g width %d precision %u: expected '%s', got '%s'\n", value, width, precision, expected, result);
+    }
+    nbr_errors++;
+    return false;
+  }
+
+  // and the round trip: the value parsed back is within half a unit of the last digit (plus the
+  // rounding of the parsing into a double, for the large values)
+  double const parsed = strtod(result, nullptr);
+  if (std::fabs(parsed - value) > 0.5 * std::pow(10.0, -precision) * (1.0 + 1e-9) + std::fabs(value) * DBL_EPSILON){
+    nbr_errors++;
+    return false;
+  }
+  return true;
+}
+
+int main(){
+  std::mt19937 generator {42};
+  unsigned long nbr_checks {0};
+  unsigned long nbr_errors {0};
+
+  // random bit patterns, i.e. all the exponents, including subnormals
+  for (int ind=0; ind<2000000; ind++){
+    uint32_t const bits = generator();
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    uint8_t const precision = generator() % (float_format_max_precision + 1);
+    int const width = static_cast<int>(generator() % 33) - 16;
+    check_one(value, width, precision, nbr_errors);
+    nbr_checks++;
+  }
+
+  // values typical of the recipes, and exact ties
+  std::uniform_real_distribution<float> distribution {-1000.0f, 1000.0f};
+  for (int ind=0; ind<2000000; ind++){
+    check_one(distribution(generator), 16, 8, nbr_errors);
+    check_one(distribution(generator), 12, 4, nbr_errors);
+    nbr_checks += 2;
+  }
+  for (int ind=-4096; ind<=4096; ind++){
+    for (uint8_t precision=0; precision<4; precision++){
+      check_one(ind / 64.0f, 0, precision, nbr_errors);
+      nbr_checks++;
+    }
+  }
+
+  printf("checked %lu values, %lu errors\n", nbr_checks, nbr_errors);
+
+  // timing, on the values of the recipes
+  constexpr int nbr_timing {1000000};
+  static float values[nbr_timing];
+  for (int ind=0; ind<nbr_timing; ind++){
+    values[ind] = distribution(generator);
+  }
+  char buffer[64];
+  unsigned long checksum {0};
+
+  auto time_start = std::chrono::steady_clock::now();
+  for (int ind=0; ind<nbr_timing; ind++){
+    dtostrf(values[ind], 16, 8, buffer);
+    checksum += buffer[10];
+  }
+  double const ns_dtostrf = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - time_start).count() / nbr_timing;
+
+  time_start = std::chrono::steady_clock::now();
+  for (int ind=0; ind<nbr_timing; ind++){
+    snprintf(buffer, sizeof(buffer), "%16.8f", static_cast<double>(values[ind]));
+    checksum += buffer[10];
+  }
+  double const ns_snprintf = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - time_start).count() / nbr_timing;
+
+  time_start = std::chrono::steady_clock::now();
+  for (int ind=0; ind<nbr_timing; ind++){
+    format_float(buffer, sizeof(buffer), values[ind], 16, 8);
+    checksum += buffer[10];
+  }
+  double const ns_format_float = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - time_start).count() / nbr_timing;
+
+  printf("ns per value, width 16 precision 8: dtostrf %.1f, snprintf %.1f, format_float %.1f (checksum %lu)\n",
+         ns_dtostrf, ns_snprintf, ns_format_float, checksum);
+
+  return (nbr_errors == 0) ? 0 : 1;
+}
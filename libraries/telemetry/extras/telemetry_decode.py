@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+"""Decode the binary telemetry frames (see src/telemetry_frame.h) from a serial port or a file.
+
+usage:
+    python3 telemetry_decode.py /dev/ttyUSB0 [baudrate]   # needs pyserial
+    python3 telemetry_decode.py capture.bin
+
+each packet is printed as a CSV line: type name, timestamp, payload values. The layout of the
+payload of each type id is given in PAYLOAD_LAYOUTS, as a struct format (little endian); keep it in
+sync with the type ids and the put calls of the sketch.
+"""
+
+import struct
+import sys
+
+PAYLOAD_LAYOUTS = {
+    # recipe_artemis_LIS3MDL_ISM330DHCX: accel (m/s2), gyro (rad/s), mag (uT), quaternion
+    1: ("imu", "<13f"),
+    # telemetry_benchmark example: 9 floats
+    2: ("benchmark", "<9f"),
+}
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE, same as telemetry_crc16"""
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if (crc & 0x8000) else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(frame):
+    """decode a COBS frame (without the 0x00 delimiter), None if not valid"""
+    out = bytearray()
+    position = 0
+    while position < len(frame):
+        code = frame[position]
+        position += 1
+        if code == 0 or position + code - 1 > len(frame):
+            return None
+        block = frame[position:position + code - 1]
+        if 0 in block:
+            return None
+        out += block
+        position += code - 1
+        if code != 0xFF and position < len(frame):
+            out.append(0)
+    return bytes(out)
+
+
+class TelemetryDecoder:
+    def __init__(self):
+        self.buffer = bytearray()
+        self.packets_decoded = 0
+        self.crc_errors = 0
+        self.framing_errors = 0
+
+    def feed(self, data):
+        """feed raw bytes, yield the (type_id, timestamp, payload) of the valid packets"""
+        self.buffer += data
+        while True:
+            end = self.buffer.find(b"\x00")
+            if end < 0:
+                return
+            frame = bytes(self.buffer[:end])
+            del self.buffer[:end + 1]
+            if not frame:
+                continue
+
+            packet = cobs_decode(frame)
+            if packet is None or len(packet) < 7:
+                self.framing_errors += 1
+                continue
+            if crc16(packet[:-2]) != struct.unpack("<H", packet[-2:])[0]:
+                self.crc_errors += 1
+                continue
+
+            self.packets_decoded += 1
+            type_id, timestamp = struct.unpack("<BI", packet[:5])
+            yield type_id, timestamp, packet[5:-2]
+
+
+def format_packet(type_id, timestamp, payload):
+    if type_id in PAYLOAD_LAYOUTS:
+        name, layout = PAYLOAD_LAYOUTS[type_id]
+        if struct.calcsize(layout) == len(payload):
+            values = struct.unpack(layout, payload)
+            return ",".join([name, str(timestamp)] + ["{:.6g}".format(value) for value in values])
+    return ",".join(["type_{}".format(type_id), str(timestamp), payload.hex()])
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__)
+        sys.exit(1)
+
+    source = sys.argv[1]
+    if source.startswith("/dev/") or source.upper().startswith("COM"):
+        import serial
+        baudrate = int(sys.argv[2]) if len(sys.argv) > 2 else 1000000
+        stream = serial.Serial(source, baudrate, timeout=0.1)
+        read = lambda: stream.read(4096)
+    else:
+        stream = open(source, "rb")
+        read = lambda: stream.read(4096) or None
+
+    decoder = TelemetryDecoder()
+    try:
+        while True:
+            data = read()
+            if data is None:
+                break
+            for type_id, timestamp, payload in decoder.feed(data):
+                print(format_packet(type_id, timestamp, payload))
+    except KeyboardInterrupt:
+        pass
+
+    print("packets decoded: {}, CRC errors: {}, framing errors: {}".format(
+        decoder.packets_decoded, decoder.crc_errors, decoder.framing_errors), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,220 @@
+#ifndef FLOAT_FORMAT_H
+#define FLOAT_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// fixed precision float to text, with integer arithmetic only, directly into a caller buffer; a
+// replacement for dtostrf (which goes through the soft double printf on the Artemis) when human
+// readable output is still needed.
+//
+// the float is split into its 24 bits mantissa and its exponent, the integer part is printed with
+// integer divisions, and the fraction digits are produced one at a time by multiplying the
+// remaining binary fraction by 10. The last digit is correctly rounded (ties to even), i.e. the
+// output is the same as printf("%*.*f") for all the floats, except for:
+// - the precision is limited to 9 digits;
+// - |value| >= 1e18 is written as "ovf" (as Print::print does for large floats);
+// - nan and inf are written as "nan", "inf", "-inf".
+//
+// this does not depend on Arduino, see extras/float_format_check.cpp to check it against snprintf
+// and time it on a computer.
+
+constexpr uint8_t float_format_max_precision {9};
+
+namespace float_format_detail{
+
+// write the decimal digits of value backwards, ending at end; returns the start
+inline char * write_uint32_backwards(uint32_t value, char * end){
+  do{
+    *--end = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  return end;
+}
+
+inline char * write_uint64_backwards(uint64_t value, char * end){
+  // 64 bits divisions are slow on a 32 bits MCU, only use them for the high digits
+  while (value > 0xFFFFFFFFull){
+    *--end = static_cast<char>('0' + value % 10);
+    value /= 10;
+  }
+  return write_uint32_backwards(static_cast<uint32_t>(value), end);
+}
+
+// copy the len chars from text to out, right aligned on width (left aligned if width < 0), with a
+// terminating 0; returns the number of chars written, 0 (and an empty string) if it does not fit
+inline size_t write_padded(char * out, size_t const out_size, char const * text, size_t const len, int const width){
+  size_t const abs_width = static_cast<size_t>(width < 0 ? -width : width);
+  size_t const total_len = (len > abs_width) ? len : abs_width;
+
+  if (out_size == 0){
+    return 0;
+  }
+  if (total_len + 1 > out_size){
+    out[0] = '\0';
+    return 0;
+  }
+
+  size_t const nbr_pad = total_len - len;
+  if (width >= 0){
+    memset(out, ' ', nbr_pad);
+    memcpy(out + nbr_pad, text, len);
+  }
+  else{
+    memcpy(out, text, len);
+    memset(out + len, ' ', nbr_pad);
+  }
+  out[total_len] = '\0';
+  return total_len;
+}
+
+}  // namespace float_format_detail
+
+// write value with precision digits after the point, padded to width chars (as dtostrf: right
+// aligned, left aligned if width is negative) into out, with a terminating 0; returns the number
+// of chars written (without the terminating 0), or 0 and an empty string if out_size is too small
+inline size_t format_float(char * out, size_t const out_size, float const value, int const width, uint8_t precision){
+  using namespace float_format_detail;
+
+  if (precision > float_format_max_precision){
+    precision = float_format_max_precision;
+  }
+
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  bool const negative = (bits >> 31) != 0;
+  int const biased_exponent = static_cast<int>((bits >> 23) & 0xFF);
+  uint32_t mantissa = bits & 0x7FFFFF;
+
+  if (biased_exponent == 0xFF){
+    if (mantissa != 0){
+      return write_padded(out, out_size, "nan", 3, width);
+    }
+    return negative ? write_padded(out, out_size, "-inf", 4, width) : write_padded(out, out_size, "inf", 3, width);
+  }
+
+  // value = mantissa * 2^exponent
+  int exponent;
+  if (biased_exponent == 0){
+    exponent = -149;
+  }
+  else{
+    mantissa |= 0x800000;
+    exponent = biased_exponent - 150;
+  }
+
+  // integer part, and binary fraction (fraction / 2^shift)
+  uint64_t integer_part {0};
+  uint64_t fraction {0};
+  int shift {0};
+
+  if (exponent >= 0){
+    // 2^24 * 2^36 > 1e18
+    if (exponent > 36){
+      return write_padded(out, out_size, "ovf", 3, width);
+    }
+    integer_part = static_cast<uint64_t>(mantissa) << exponent;
+  }
+  else if (exponent > -24){
+    shift = -exponent;
+    integer_part = mantissa >> shift;
+    fraction = mantissa & ((1ul << shift) - 1);
+  }
+  else if (exponent >= -60){
+    shift = -exponent;
+    fraction = mantissa;
+  }
+  else{
+    // below 2^-37, rounds to 0 at any supported precision
+    shift = 0;
+    fraction = 0;
+  }
+
+  if (integer_part >= 1000000000000000000ull){
+    return write_padded(out, out_size, "ovf", 3, width);
+  }
+
+  // fraction digits: fraction < 2^shift with shift <= 60, so fraction * 10 fits in 64 bits
+  char fraction_digits[float_format_max_precision];
+  for (uint8_t ind=0; ind<precision; ind++){
+    if (shift == 0){
+      fraction_digits[ind] = '0';
+      continue;
+    }
+    fraction *= 10;
+    fraction_digits[ind] = static_cast<char>('0' + (fraction >> shift));
+    fraction &= (static_cast<uint64_t>(1) << shift) - 1;
+  }
+
+  // rounding of the last digit, ties to even
+  if (shift > 0){
+    uint64_t const half = static_cast<uint64_t>(1) << (shift - 1);
+    bool const last_is_odd = (precision > 0) ? ((fraction_digits[precision - 1] - '0') & 1) : (integer_part & 1);
+    if ((fraction > half) || ((fraction == half) && last_is_odd)){
+      int ind = static_cast<int>(precision) - 1;
+      while ((ind >= 0) && (fraction_digits[ind] == '9')){
+        fraction_digits[ind] = '0';
+        ind--;
+      }
+      if (ind >= 0){
+        fraction_digits[ind]++;
+      }
+      else{
+        integer_part++;
+      }
+    }
+  }
+
+  // assemble, sign + at most 18 integer digits + point + fraction digits
+  char text[1 + 19 + 1 + float_format_max_precision];
+  char * const text_end = text + sizeof(text);
+  char * start = text_end - precision;
+  memcpy(start, fraction_digits, precision);
+  if (precision > 0){
+    *--start = '.';
+  }
+  start = write_uint64_backwards(integer_part, start);
+  if (negative){
+    *--start = '-';
+  }
+
+  return write_padded(out, out_size, start, static_cast<size_t>(text_end - start), width);
+}
+
+// write the nbr_values values, each formatted as with format_float, joined by separator, into out,
+// with a terminating 0; returns the number of chars written, or 0 and an empty string if out_size
+// is too small
+inline size_t format_floats_csv(char * out, size_t const out_size, float const * values, size_t const nbr_values,
+                                int const width, uint8_t const precision, char const * separator=", "){
+  size_t const separator_len = strlen(separator);
+  size_t position {0};
+
+  if (out_size == 0){
+    return 0;
+  }
+  out[0] = '\0';
+
+  for (size_t ind=0; ind<nbr_values; ind++){
+    if (ind > 0){
+      if (position + separator_len + 1 > out_size){
+        out[0] = '\0';
+        return 0;
+      }
+      memcpy(out + position, separator, separator_len);
+      position += separator_len;
+    }
+
+    size_t const len = format_float(out + position, out_size - position, values[ind], width, precision);
+    if (len == 0){
+      out[0] = '\0';
+      return 0;
+    }
+    position += len;
+  }
+
+  out[position] = '\0';
+  return position;
+}
+
+#endif
@@ -0,0 +1,254 @@
+#ifndef TELEMETRY_FRAME_H
+#define TELEMETRY_FRAME_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <kiss_crc.h>
+
+// binary framed telemetry: rather than formatting every value as text with Serial.print / dtostrf,
+// the values are packed as they are in memory (little endian) in a small packet, and the packet is
+// framed so that the receiver can resynchronise on any byte loss:
+//
+//   packet: type id (uint8) | timestamp (uint32 LE, typically micros()) | payload (LE) | CRC16 (LE)
+//   frame:  COBS(packet) | 0x00
+//
+// COBS (consistent overhead byte stuffing) removes all the 0x00 bytes from the packet, with an
+// overhead of 1 byte per 254 bytes, so that 0x00 is only the frame delimiter. The CRC is the
+// CRC-16/CCITT-FALSE (polynomial 0x1021, init 0xFFFF) over the type, timestamp and payload.
+//
+// this does not depend on Arduino (only on the kiss_crc library): the same code is used to decode on
+// a computer, see the extras for a Python decoder.
+
+constexpr size_t telemetry_header_length {5};
+constexpr size_t telemetry_crc_length {2};
+
+// maximum length of the COBS encoding of nbr_bytes bytes, excluding the 0x00 delimiter
+constexpr size_t cobs_max_encoded_length(size_t const nbr_bytes){
+  return nbr_bytes + nbr_bytes / 254 + 1;
+}
+
+//--------------------------------------------------------------------------------
+// CRC-16/CCITT-FALSE, from kiss_crc: table driven, 1 lookup per byte
+inline uint16_t telemetry_crc16(uint8_t const * data, size_t const nbr_bytes, uint16_t crc=0xFFFF){
+  return kiss_crc::crc16_ccitt(data, nbr_bytes, crc);
+}
+
+//--------------------------------------------------------------------------------
+// COBS encode nbr_bytes from src into dst, which must hold cobs_max_encoded_length(nbr_bytes) bytes;
+// returns the encoded length (the 0x00 delimiter is not added)
+inline size_t cobs_encode(uint8_t const * src, size_t const nbr_bytes, uint8_t * dst){
+  size_t code_position {0};
+  size_t write_position {1};
+  uint8_t code {1};
+
+  for (size_t ind=0; ind<nbr_bytes; ind++){
+    if (src[ind] == 0){
+      dst[code_position] = code;
+      code_position = write_position++;
+      code = 1;
+    }
+    else{
+      dst[write_position++] = src[ind];
+      code++;
+      if (code == 0xFF){
+        dst[code_position] = code;
+        code_position = write_position++;
+        code = 1;
+      }
+    }
+  }
+
+  dst[code_position] = code;
+  return write_position;
+}
+
+// COBS decode nbr_bytes from src (without the 0x00 delimiter) into dst, which must hold nbr_bytes
+// bytes; returns the decoded length, or 0 if the input is not valid COBS
+inline size_t cobs_decode(uint8_t const * src, size_t const nbr_bytes, uint8_t * dst){
+  size_t read_position {0};
+  size_t write_position {0};
+
+  while (read_position < nbr_bytes){
+    uint8_t const code = src[read_position++];
+    if ((code == 0) || (read_position + code - 1 > nbr_bytes)){
+      return 0;
+    }
+    for (uint8_t ind=1; ind<code; ind++){
+      uint8_t const byte = src[read_position++];
+      if (byte == 0){
+        return 0;
+      }
+      dst[write_position++] = byte;
+    }
+    if ((code != 0xFF) && (read_position < nbr_bytes)){
+      dst[write_position++] = 0;
+    }
+  }
+
+  return write_position;
+}
+
+//--------------------------------------------------------------------------------
+// build one frame: begin, put the payload values, then finish, which returns the frame to send:
+//
+//   TelemetryWriter<64> writer;
+//   writer.begin(telemetry_type_imu, micros());
+//   writer.put(acc_x); writer.put(acc_y); ...
+//   size_t length = writer.finish();
+//   Serial.write(writer.frame(), length);
+//
+// max_payload_length is the largest payload, in bytes; a put that does not fit is dropped, and
+// marks the packet as truncated (finish then returns 0).
+template <size_t max_payload_length>
+class TelemetryWriter{
+  public:
+    void begin(uint8_t const type_id, uint32_t const timestamp){
+      packet_length = 0;
+      truncated = false;
+      put(type_id);
+      put(timestamp);
+    }
+
+    // any trivially copyable value (integers, floats, packed structs), copied as in memory, i.e.
+    // little endian on the Artemis (Cortex-M4) and on x86 / ARM computers
+    template <typename T>
+    void put(T const & value){
+      put_bytes(reinterpret_cast<uint8_t const *>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    void put_array(T const * values, size_t const nbr_values){
+      put_bytes(reinterpret_cast<uint8_t const *>(values), nbr_values * sizeof(T));
+    }
+
+    void put_bytes(uint8_t const * bytes, size_t const nbr_bytes){
+      if (packet_length + nbr_bytes > telemetry_header_length + max_payload_length){
+        truncated = true;
+        return;
+      }
+      memcpy(packet + packet_length, bytes, nbr_bytes);
+      packet_length += nbr_bytes;
+    }
+
+    // append the CRC, COBS encode, and add the delimiter; returns the frame length, 0 if truncated
+    size_t finish(void){
+      if (truncated){
+        return 0;
+      }
+
+      uint16_t const crc = telemetry_crc16(packet, packet_length);
+      packet[packet_length++] = static_cast<uint8_t>(crc & 0xFF);
+      packet[packet_length++] = static_cast<uint8_t>(crc >> 8);
+
+      frame_length = cobs_encode(packet, packet_length, frame_buffer);
+      frame_buffer[frame_length++] = 0x00;
+      return frame_length;
+    }
+
+    uint8_t const * frame(void) const{
+      return frame_buffer;
+    }
+
+  private:
+    static constexpr size_t max_packet_length {telemetry_header_length + max_payload_length + telemetry_crc_length};
+
+    uint8_t packet[max_packet_length];
+    uint8_t frame_buffer[cobs_max_encoded_length(max_packet_length) + 1];
+    size_t packet_length {0};
+    size_t frame_length {0};
+    bool truncated {false};
+};
+
+//--------------------------------------------------------------------------------
+struct TelemetryPacket{
+  uint8_t type_id;
+  uint32_t timestamp;
+  uint8_t const * payload;
+  size_t payload_length;
+};
+
+struct TelemetryDecoderCounters{
+  uint32_t packets_decoded {0};
+  // frames with a wrong CRC
+  uint32_t crc_errors {0};
+  // frames that are not valid COBS, or too short to be a packet
+  uint32_t framing_errors {0};
+  // frames longer than the buffer, dropped
+  uint32_t overflows {0};
+};
+
+// decode a byte stream, one byte at a time: push returns true when a valid packet was completed by
+// this byte, and it is then available with packet() until the next push
+template <size_t max_payload_length>
+class TelemetryDecoder{
+  public:
+    bool push(uint8_t const byte){
+      if (byte != 0x00){
+        if (frame_length < max_frame_length){
+          frame_buffer[frame_length++] = byte;
+        }
+        else{
+          overflowing = true;
+        }
+        return false;
+      }
+
+      // end of frame
+      size_t const crrt_frame_length = frame_length;
+      bool const crrt_overflowing = overflowing;
+      frame_length = 0;
+      overflowing = false;
+
+      if (crrt_overflowing){
+        crrt_counters.overflows++;
+        return false;
+      }
+      if (crrt_frame_length == 0){
+        return false;
+      }
+
+      size_t const packet_length = cobs_decode(frame_buffer, crrt_frame_length, packet_buffer);
+      if (packet_length < telemetry_header_length + telemetry_crc_length){
+        crrt_counters.framing_errors++;
+        return false;
+      }
+
+      size_t const crc_position = packet_length - telemetry_crc_length;
+      uint16_t const crc_received = static_cast<uint16_t>(packet_buffer[crc_position] | (packet_buffer[crc_position + 1] << 8));
+      if (telemetry_crc16(packet_buffer, crc_position) != crc_received){
+        crrt_counters.crc_errors++;
+        return false;
+      }
+
+      crrt_packet.type_id = packet_buffer[0];
+      crrt_packet.timestamp = static_cast<uint32_t>(packet_buffer[1]) | (static_cast<uint32_t>(packet_buffer[2]) << 8) |
+                              (static_cast<uint32_t>(packet_buffer[3]) << 16) | (static_cast<uint32_t>(packet_buffer[4]) << 24);
+      crrt_packet.payload = packet_buffer + telemetry_header_length;
+      crrt_packet.payload_length = crc_position - telemetry_header_length;
+      crrt_counters.packets_decoded++;
+      return true;
+    }
+
+    TelemetryPacket const & packet(void) const{
+      return crrt_packet;
+    }
+
+    TelemetryDecoderCounters const & counters(void) const{
+      return crrt_counters;
+    }
+
+  private:
+    static constexpr size_t max_packet_length {telemetry_header_length + max_payload_length + telemetry_crc_length};
+    static constexpr size_t max_frame_length {cobs_max_encoded_length(max_packet_length)};
+
+    uint8_t frame_buffer[max_frame_length];
+    uint8_t packet_buffer[max_frame_length];
+    size_t frame_length {0};
+    bool overflowing {false};
+    TelemetryPacket crrt_packet {};
+    TelemetryDecoderCounters crrt_counters {};
+};
+
+#endif
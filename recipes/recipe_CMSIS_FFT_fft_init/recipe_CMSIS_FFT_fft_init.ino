@@ -1,7 +1,8 @@
 #include "Arduino.h"
 #include "arm_math.h"
 
-#include "ard_supers/avr/dtostrf.h"
+// fast float to text, from the telemetry library; dtostrf goes through the soft double printf
+#include <float_format.h>
 
 // FFT settings
 // admissible rfft lengths as well as some documentation are available at
@@ -48,7 +49,7 @@ void serial_print_int_width_4(unsigned int input){
 }
 
 void serial_print_float_width_16_prec_8(float input){ 
-  dtostrf(input, 16, 8, format_buffer);
+  format_float(format_buffer, length_format_buffer, input, 16, 8);
   Serial.print(format_buffer);
 }
 
@@ -0,0 +1,205 @@
+#ifndef ASYNC_LOGGER_H
+#define ASYNC_LOGGER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// non blocking logging: the sensing loop appends its text records into a ring buffer, and a lower
+// priority thread drains the buffer to the UART; so the loop never waits on the UART, only the
+// drain thread does.
+//
+// a record is everything up to and including a '\n'; only complete records are visible to the
+// drain side, so that the lines are not interleaved with partial ones. When the buffer is full, the
+// oldest complete records are dropped to make room (drop oldest: the latest data is the most
+// relevant), and counted. The drain side hands over whole records only, so that the oldest record
+// is never half sent when it is dropped; for this a record longer than drain_chunk_size is dropped
+// when it is written.
+//
+// the buffer is protected by a mutex, held only for memcpy-like operations, never during the UART
+// writes. The mutex type is a template parameter (rtos::Mutex on the board, std::mutex on a
+// computer), so that this can be tested off the board.
+
+struct AsyncLogCounters{
+  // bytes accepted into the buffer (including the ones dropped later to make room)
+  uint32_t bytes_logged {0};
+  // bytes handed over to the UART
+  uint32_t bytes_sent {0};
+  // records dropped to make room, or because longer than drain_chunk_size
+  uint32_t records_dropped {0};
+  uint32_t bytes_dropped {0};
+  // high water mark of the buffer use, to size it
+  uint32_t max_bytes_used {0};
+};
+
+// N must be a power of 2; drain_chunk_size is the largest write handed over to the UART at once, and
+// the longest record
+template <size_t N, typename Mutex, size_t drain_chunk_size=256>
+class AsyncLogBuffer{
+  static_assert((N != 0) && ((N & (N - 1)) == 0), "the log buffer size must be a power of 2");
+  static_assert(drain_chunk_size <= N, "the drain chunk should not be larger than the buffer");
+
+  public:
+    // producer side, the sensing loop
+    size_t write(uint8_t const * bytes, size_t const nbr_bytes){
+      lock.lock();
+
+      for (size_t ind=0; ind<nbr_bytes; ind++){
+        uint8_t const byte = bytes[ind];
+
+        if (discarding_record){
+          crrt_counters.bytes_dropped++;
+          if (byte == '\n'){
+            discarding_record = false;
+          }
+          continue;
+        }
+
+        if (write_position - head == drain_chunk_size){
+          drop_record_being_written();
+        }
+        else if (write_position - tail == N){
+          make_room();
+        }
+        if (discarding_record){
+          crrt_counters.bytes_dropped++;
+          if (byte == '\n'){
+            discarding_record = false;
+          }
+          continue;
+        }
+
+        buffer[write_position & mask] = byte;
+        write_position++;
+        crrt_counters.bytes_logged++;
+
+        if (byte == '\n'){
+          head = write_position;
+        }
+      }
+
+      uint32_t const bytes_used = write_position - tail;
+      if (bytes_used > crrt_counters.max_bytes_used){
+        crrt_counters.max_bytes_used = bytes_used;
+      }
+
+      lock.unlock();
+      return nbr_bytes;
+    }
+
+    // consumer side, the drain thread: take up to drain_chunk_size bytes of complete records out of
+    // the buffer and hand them over to sink(uint8_t const * bytes, size_t nbr_bytes), which may block;
+    // returns the number of bytes handed over, 0 if there was nothing to send
+    template <typename Sink>
+    size_t drain(Sink && sink){
+      lock.lock();
+
+      size_t nbr_bytes = head - tail;
+      if (nbr_bytes > drain_chunk_size){
+        // stop at the end of the last complete record in the chunk; there is one, as no record is
+        // longer than the chunk
+        nbr_bytes = drain_chunk_size;
+        while (buffer[(tail + nbr_bytes - 1) & mask] != '\n'){
+          nbr_bytes--;
+        }
+      }
+
+      for (size_t ind=0; ind<nbr_bytes; ind++){
+        drain_chunk[ind] = buffer[(tail + ind) & mask];
+      }
+      tail += nbr_bytes;
+      crrt_counters.bytes_sent += nbr_bytes;
+
+      lock.unlock();
+
+      if (nbr_bytes > 0){
+        sink(drain_chunk, nbr_bytes);
+      }
+      return nbr_bytes;
+    }
+
+    AsyncLogCounters counters(void){
+      lock.lock();
+      AsyncLogCounters const crrt_copy = crrt_counters;
+      lock.unlock();
+      return crrt_copy;
+    }
+
+  private:
+    // the buffer is full: drop the oldest complete record, or if there is none, the record being
+    // written, which then fills the whole buffer; tail is always at the start of a record, see drain
+    void make_room(void){
+      if (head != tail){
+        uint32_t end_record = tail;
+        while (end_record != head){
+          end_record++;
+          if (buffer[(end_record - 1) & mask] == '\n'){
+            break;
+          }
+        }
+        crrt_counters.bytes_dropped += end_record - tail;
+        crrt_counters.records_dropped++;
+        tail = end_record;
+      }
+      else{
+        drop_record_being_written();
+      }
+    }
+
+    // drop the bytes of the record being written so far, and the next ones until its '\n'
+    void drop_record_being_written(void){
+      crrt_counters.bytes_dropped += write_position - head;
+      crrt_counters.records_dropped++;
+      write_position = head;
+      discarding_record = true;
+    }
+
+    static constexpr uint32_t mask {N - 1};
+
+    Mutex lock;
+    uint8_t buffer[N];
+    uint8_t drain_chunk[drain_chunk_size];
+    // free running indexes: tail is the oldest byte not yet sent, head the end of the last complete
+    // record, write_position the end of the record being written
+    uint32_t tail {0};
+    uint32_t head {0};
+    uint32_t write_position {0};
+    bool discarding_record {false};
+    AsyncLogCounters crrt_counters {};
+};
+
+//--------------------------------------------------------------------------------
+#ifdef ARDUINO
+
+#include "Arduino.h"
+#include "mbed.h"
+
+// a Print on top of the buffer, so that all the usual print / println overloads (F strings, floats
+// with a number of digits, etc) can be used as with Serial
+template <size_t N>
+class AsyncLogger : public Print{
+  public:
+    size_t write(uint8_t byte) override{
+      return log_buffer.write(&byte, 1);
+    }
+
+    size_t write(uint8_t const * bytes, size_t nbr_bytes) override{
+      return log_buffer.write(bytes, nbr_bytes);
+    }
+
+    // to call from the drain thread
+    size_t drain_to(Print & out){
+      return log_buffer.drain([&out](uint8_t const * bytes, size_t nbr_bytes){ out.write(bytes, nbr_bytes); });
+    }
+
+    AsyncLogCounters counters(void){
+      return log_buffer.counters();
+    }
+
+  private:
+    AsyncLogBuffer<N, rtos::Mutex> log_buffer;
+};
+
+#endif
+
+#endif
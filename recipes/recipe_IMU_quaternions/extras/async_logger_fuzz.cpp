@@ -0,0 +1,144 @@
+// fuzz the async log buffer on a computer, with std::mutex and 2 threads as on the board: a producer
+// writes numbered records of random lengths (some longer than the drain chunk, or than the whole
+// buffer) in random pieces, and a slow consumer drains them; every record received must be whole and
+// intact, in order, and the records received and dropped must add up to the ones written:
+//
+//   g++ -O2 -std=c++11 -pthread -I.. async_logger_fuzz.cpp -o async_logger_fuzz
+//   ./async_logger_fuzz
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "async_logger.h"
+
+static constexpr size_t buffer_size {1024};
+static constexpr size_t chunk_size {256};
+static constexpr uint32_t nbr_records {200000};
+
+using LogBuffer = AsyncLogBuffer<buffer_size, std::mutex, chunk_size>;
+
+// "index:length:payload\n", the payload a pattern derived from the index
+static std::string make_record(uint32_t const index, size_t const payload_length){
+  std::string record = std::to_string(index) + ":" + std::to_string(payload_length) + ":";
+  for (size_t ind=0; ind<payload_length; ind++){
+    record += static_cast<char>('a' + (index + ind) % 26);
+  }
+  record += '\n';
+  return record;
+}
+
+int main(){
+  LogBuffer log_buffer;
+  std::atomic<bool> producer_done {false};
+  unsigned long nbr_errors {0};
+  uint32_t nbr_received {0};
+  uint32_t nbr_written_fitting {0};
+
+  std::thread producer([&](){
+    std::mt19937 generator {11};
+    for (uint32_t index=0; index<nbr_records; index++){
+      // mostly short lines, some around the chunk size, a few longer than the buffer
+      size_t payload_length = generator() % 200;
+      if (generator() % 20 == 0){
+        payload_length = chunk_size - 20 + generator() % 40;
+      }
+      if (generator() % 500 == 0){
+        payload_length = buffer_size + generator() % 100;
+      }
+      std::string const record = make_record(index, payload_length);
+      if (record.size() <= chunk_size){
+        nbr_written_fitting++;
+      }
+
+      // in random pieces, as from the print overloads
+      size_t position {0};
+      while (position < record.size()){
+        size_t const piece = 1 + generator() % 40;
+        size_t const nbr_bytes = (position + piece <= record.size()) ? piece : record.size() - position;
+        log_buffer.write(reinterpret_cast<uint8_t const *>(record.data()) + position, nbr_bytes);
+        position += nbr_bytes;
+      }
+      if (generator() % 8 == 0){
+        std::this_thread::sleep_for(std::chrono::microseconds(20));
+      }
+    }
+    producer_done = true;
+  });
+
+  std::string pending;
+  long previous_index {-1};
+  auto parse = [&](uint8_t const * bytes, size_t nbr_bytes){
+    if (bytes[nbr_bytes - 1] != '\n'){
+      printf("ERROR: a chunk does not end on a whole record\n");
+      nbr_errors++;
+    }
+    pending.append(reinterpret_cast<char const *>(bytes), nbr_bytes);
+
+    size_t end_line;
+    while ((end_line = pending.find('\n')) != std::string::npos){
+      std::string const line = pending.substr(0, end_line + 1);
+      pending.erase(0, end_line + 1);
+
+      unsigned long index;
+      unsigned long payload_length;
+      int header_length;
+      if ((sscanf(line.c_str(), "%lu:%lu:%n", &index, &payload_length, &header_length) != 2) ||
+          (line != make_record(static_cast<uint32_t>(index), payload_length))){
+        printf("ERROR: corrupt record: %.60s\n", line.c_str());
+        nbr_errors++;
+        continue;
+      }
+      if (static_cast<long>(index) <= previous_index){
+        printf("ERROR: record %lu after %ld\n", index, previous_index);
+        nbr_errors++;
+      }
+      previous_index = static_cast<long>(index);
+      nbr_received++;
+    }
+  };
+
+  std::mt19937 consumer_generator {13};
+  while (true){
+    bool const done = producer_done;
+    size_t const nbr_sent = log_buffer.drain(parse);
+    if ((nbr_sent == 0) && done){
+      break;
+    }
+    // a UART sometimes slower than the producer, so that the buffer overflows
+    if (consumer_generator() % 8 == 0){
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+  }
+  producer.join();
+
+  AsyncLogCounters const counters = log_buffer.counters();
+  printf("written %u records, received %u, dropped %u (%u bytes), max bytes used %u\n",
+         nbr_records, nbr_received, counters.records_dropped, counters.bytes_dropped, counters.max_bytes_used);
+
+  if (!pending.empty()){
+    printf("ERROR: %zu bytes of a partial record received\n", pending.size());
+    nbr_errors++;
+  }
+  if (nbr_received + counters.records_dropped != nbr_records){
+    printf("ERROR: %u received + %u dropped, %u written\n", nbr_received, counters.records_dropped, nbr_records);
+    nbr_errors++;
+  }
+  if (counters.bytes_sent + counters.bytes_dropped < counters.bytes_logged){
+    printf("ERROR: bytes logged %u, sent %u, dropped %u\n", counters.bytes_logged, counters.bytes_sent, counters.bytes_dropped);
+    nbr_errors++;
+  }
+  if (nbr_received > nbr_written_fitting){
+    printf("ERROR: more records received than written within the chunk size\n");
+    nbr_errors++;
+  }
+
+  printf("%lu errors\n", nbr_errors);
+  return (nbr_errors == 0) ? 0 : 1;
+}
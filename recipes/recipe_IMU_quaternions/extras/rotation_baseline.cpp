@@ -0,0 +1,166 @@
+#include "rotation_baseline.h"
+
+#include <math.h>
+
+namespace baseline{
+
+bool is_approx(float val_1, float val_2, float tol){
+  return(fabsf(val_1-val_2)<tol);
+}
+
+//--------------------------------------------------------------------------------
+Quaternion::Quaternion(float q0, float q1, float q2, float q3):
+  q0{q0}, q1{q1}, q2{q2}, q3{q3}
+  {}
+
+Quaternion::Quaternion(void):
+  q0{0}, q1{0}, q2{0}, q3{0}
+  {}
+
+float Quaternion::norm_squared(void) const {
+  float res = q0*q0 + q1*q1 + q2*q2 + q3*q3;
+  return res;
+}
+
+bool Quaternion::is_normed(float tol) const {
+  return ((this->norm_squared() - 1) < tol);
+}
+
+void Quaternion::set(float q0, float q1, float q2, float q3){
+  this->q0 = q0;
+  this->q1 = q1;
+  this->q2 = q2;
+  this->q3 = q3;
+}
+
+//--------------------------------------------------------------------------------
+Vector::Vector(float v0, float v1, float v2):
+  v0{v0}, v1{v1}, v2{v2}
+  {}
+
+Vector::Vector(Vector const & vect_in):
+  v0{vect_in.v0}, v1{vect_in.v1}, v2{vect_in.v2}
+  {}
+
+Vector::Vector(void):
+  v0{0}, v1{0}, v2{0}
+  {}
+
+void Vector::copy(Vector const & vect_in){
+  v0 = vect_in.v0;
+  v1 = vect_in.v1;
+  v2 = vect_in.v2;
+}
+
+void Vector::add(Vector const & vect_in){
+  v0 += vect_in.v0;
+  v1 += vect_in.v1;
+  v2 += vect_in.v2;
+}
+
+void Vector::scale(float const scale){
+  v0 *= scale;
+  v1 *= scale;
+  v2 *= scale;
+}
+
+float Vector::norm_squared(void) const{
+  return(v0*v0 + v1*v1 + v2*v2);
+}
+
+bool Vector::is_normed(void) const{
+  return(is_approx(this->norm_squared(), 1.0f));
+}
+
+//--------------------------------------------------------------------------------
+float vect_norm_square(Vector const & vect_in){
+  float res = 
+    vect_in.v0 * vect_in.v0 +
+    vect_in.v1 * vect_in.v1 +
+    vect_in.v2 * vect_in.v2;
+  return res;
+}
+
+float vect_dot(Vector const & vect_1, Vector const & vect_2){
+  float res = 
+    vect_1.v0 * vect_2.v0 +
+    vect_1.v1 * vect_2.v1 +
+    vect_1.v2 * vect_2.v2;
+  return res;
+}
+
+void vect_cross(Vector const & vect_1, Vector const & vect_2, Vector & vect_out){
+  vect_out.v0 =  vect_1.v1 * vect_2.v2 - vect_1.v2 * vect_2.v1;
+  vect_out.v1 = -vect_1.v0 * vect_2.v2 + vect_1.v2 * vect_2.v0;
+  vect_out.v2 =  vect_1.v0 * vect_2.v1 - vect_1.v1 * vect_2.v0;
+}
+
+void vect_add(Vector const & vect_1, Vector const & vect_2, Vector & vect_out){
+  vect_out.v0 = vect_1.v0 + vect_2.v0;
+  vect_out.v1 = vect_1.v1 + vect_2.v1;
+  vect_out.v2 = vect_1.v2 + vect_2.v2;
+}
+
+//--------------------------------------------------------------------------------
+void quat_to_vect_part(Quaternion const & quat_in, Vector & vect_out){
+  vect_out.v0 = quat_in.q1;
+  vect_out.v1 = quat_in.q2;
+  vect_out.v2 = quat_in.q3;
+}
+
+float quat_to_scalar_part(Quaternion const & quat_in){
+  float res = quat_in.q0;
+  return res;
+}
+
+bool rot_theta_normed_axis_to_rot_quat(float const rot_theta_rad, Vector const & normed_rot_axis, Quaternion & quat_out){
+  float cos_theta = cos(rot_theta_rad);
+  float sin_theta = sin(rot_theta_rad);
+  quat_out.set(
+    cos_theta,
+    sin_theta * normed_rot_axis.v0, sin_theta * normed_rot_axis.v1, sin_theta * normed_rot_axis.v2
+  );
+
+  if (!normed_rot_axis.is_normed()){
+    return false;
+  }
+  return true;
+}
+
+// using Rodriguez method: faster, see https://gamedev.stackexchange.com/questions/28395/rotating-vector3-by-a-quaternion
+bool rotate_vect_by_quat_R(Vector const & vect_in, Quaternion const & quat_in, Vector & vect_out){
+  Vector quat_vect_part{0, 0, 0};
+  quat_to_vect_part(quat_in, quat_vect_part);
+
+  float quat_scalar_part = quat_to_scalar_part(quat_in);
+
+  // compute each term in our working vector
+  Vector working_vector {0, 0, 0};
+
+  // reset vect out
+  vect_out.copy(working_vector);
+
+  // part 1
+  working_vector.copy(quat_vect_part);
+  working_vector.scale(vect_dot(quat_vect_part, vect_in));
+  working_vector.scale(2.0f);
+  vect_add(working_vector, vect_out, vect_out);
+
+  // part 2
+  working_vector.copy(vect_in);
+  working_vector.scale(quat_scalar_part*quat_scalar_part - vect_norm_square(quat_vect_part));
+  vect_add(working_vector, vect_out, vect_out);
+
+  // part 3
+  vect_cross(quat_vect_part, vect_in, working_vector);
+  working_vector.scale(2.0f * quat_scalar_part);
+  vect_add(working_vector, vect_out, vect_out);
+
+  if (!quat_in.is_normed()){
+    return false;
+  }
+
+  return true;
+}
+
+}
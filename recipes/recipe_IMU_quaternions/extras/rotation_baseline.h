@@ -0,0 +1,62 @@
+#ifndef ROTATION_BASELINE_H
+#define ROTATION_BASELINE_H
+
+// the Vector, Quaternion and rotate_vect_by_quat_R of vector_and_quaternion before they became header
+// only, reduced to what the rotation needs, for rotation_benchmark.cpp: classes with a per object
+// tolerance, and every operation out of line, in rotation_baseline.cpp.
+
+namespace baseline{
+
+constexpr float default_tol = 1.0e-4;
+
+bool is_approx(float val_1, float val_2, float tol=default_tol);
+
+class Vector{
+  public:
+    Vector(float v0, float v1, float v2);
+    Vector(Vector const & vect_in);
+    Vector(void);
+
+    void copy(Vector const & vect_in);
+    void add(Vector const & vect_in);
+    void scale(float const scale);
+    float norm_squared(void) const;
+    bool is_normed(void) const;
+
+    float v0;
+    float v1;
+    float v2;
+
+    float tol = default_tol;
+};
+
+class Quaternion{
+  public:
+    Quaternion(float q0, float q1, float q2, float q3);
+    Quaternion(void);
+
+    float norm_squared(void) const;
+    bool is_normed(float tol=default_tol) const;
+    void set(float q0, float q1, float q2, float q3);
+
+    float q0;
+    float q1;
+    float q2;
+    float q3;
+
+    float tol = default_tol;
+};
+
+float vect_norm_square(Vector const & vect_in);
+float vect_dot(Vector const & vect_1, Vector const & vect_2);
+void vect_cross(Vector const & vect_1, Vector const & vect_2, Vector & vect_out);
+void vect_add(Vector const & vect_1, Vector const & vect_2, Vector & vect_out);
+
+void quat_to_vect_part(Quaternion const & quat_in, Vector & vect_out);
+float quat_to_scalar_part(Quaternion const & quat_in);
+bool rot_theta_normed_axis_to_rot_quat(float const rot_theta_rad, Vector const & normed_rot_axis, Quaternion & quat_out);
+bool rotate_vect_by_quat_R(Vector const & vect_in, Quaternion const & quat_in, Vector & vect_out);
+
+}
+
+#endif
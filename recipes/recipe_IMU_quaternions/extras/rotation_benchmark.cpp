@@ -0,0 +1,75 @@
+// rotations per second on a computer, with the header only, templated Vector / Quaternion of
+// vector_and_quaternion.h against the previous classes with every operation out of line (kept in
+// rotation_baseline.cpp, a separate translation unit as it was, so that nothing is inlined across):
+//
+//   g++ -O2 -std=c++11 -I.. rotation_benchmark.cpp rotation_baseline.cpp -o rotation_benchmark
+//   ./rotation_benchmark
+//
+// both rotate the same stream of vectors by the same quaternion; the results are accumulated and
+// compared, so that the loops cannot be dropped and the 2 versions are checked to agree.
+
+#include <cstdio>
+#include <cmath>
+#include <chrono>
+
+#include "vector_and_quaternion.h"
+#include "rotation_baseline.h"
+
+static constexpr long nbr_of_rotations {50000000};
+
+int main(){
+  float const axis_x {0.5f};
+  float const axis_y {0.25f};
+  float const axis_z {sqrtf(1.0f - axis_x * axis_x - axis_y * axis_y)};
+  float const half_angle {0.3f};
+
+  // header only
+  Quaternion quat_new;
+  rot_theta_normed_axis_to_rot_quat(half_angle, Vector{axis_x, axis_y, axis_z}, quat_new);
+  Vector vect_new {1.0f, 2.0f, 3.0f};
+  Vector rotated_new;
+  double sum_new[3] {0.0, 0.0, 0.0};
+
+  auto time_start = std::chrono::steady_clock::now();
+  for (long ind=0; ind<nbr_of_rotations; ind++){
+    rotate_vect_by_quat_R(vect_new, quat_new, rotated_new);
+    sum_new[0] += rotated_new.v0;
+    sum_new[1] += rotated_new.v1;
+    sum_new[2] += rotated_new.v2;
+    vect_new.v0 += 1.0e-7f;
+  }
+  double const new_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - time_start).count();
+
+  // out of line
+  baseline::Quaternion quat_old;
+  baseline::rot_theta_normed_axis_to_rot_quat(half_angle, baseline::Vector{axis_x, axis_y, axis_z}, quat_old);
+  baseline::Vector vect_old {1.0f, 2.0f, 3.0f};
+  baseline::Vector rotated_old;
+  double sum_old[3] {0.0, 0.0, 0.0};
+
+  time_start = std::chrono::steady_clock::now();
+  for (long ind=0; ind<nbr_of_rotations; ind++){
+    baseline::rotate_vect_by_quat_R(vect_old, quat_old, rotated_old);
+    sum_old[0] += rotated_old.v0;
+    sum_old[1] += rotated_old.v1;
+    sum_old[2] += rotated_old.v2;
+    vect_old.v0 += 1.0e-7f;
+  }
+  double const old_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - time_start).count();
+
+  printf("out of line:  %.1f M rotations / s\n", nbr_of_rotations / old_us);
+  printf("header only:  %.1f M rotations / s (x %.2f)\n", nbr_of_rotations / new_us, old_us / new_us);
+  printf("sums: %.3f %.3f %.3f / %.3f %.3f %.3f\n", sum_new[0], sum_new[1], sum_new[2], sum_old[0], sum_old[1], sum_old[2]);
+
+  double difference {0.0};
+  double scale {0.0};
+  for (int ind=0; ind<3; ind++){
+    difference += fabs(sum_new[ind] - sum_old[ind]);
+    scale += fabs(sum_old[ind]);
+  }
+  if (difference > 1.0e-6 * scale){
+    printf("ERROR the 2 versions do not agree\n");
+    return 1;
+  }
+  return 0;
+}
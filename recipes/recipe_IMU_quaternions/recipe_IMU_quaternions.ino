@@ -1,18 +1,37 @@
 #include "Arduino.h"
 #include <Wire.h>
 #include "SparkFun_BNO080_Arduino_Library.h"
+#include "mbed.h"
 #include "vector_and_quaternion.h"
+#include "async_logger.h"
 
 BNO080 bno080_imu;
 
 //--------------------------------------------------------------------------------
 // a few helper functions
 
-void printAccuracyLevel(byte accuracyNumber){          // accuracy is:
-  if (accuracyNumber == 0) Serial.print(F("U"));       // Unreliable
-  else if (accuracyNumber == 1) Serial.print(F("L"));  // Low
-  else if (accuracyNumber == 2) Serial.print(F("M"));  // Medium
-  else if (accuracyNumber == 3) Serial.print(F("H"));  // High
+void printAccuracyLevel(Print & out, byte accuracyNumber){  // accuracy is:
+  if (accuracyNumber == 0) out.print(F("U"));               // Unreliable
+  else if (accuracyNumber == 1) out.print(F("L"));          // Low
+  else if (accuracyNumber == 2) out.print(F("M"));          // Medium
+  else if (accuracyNumber == 3) out.print(F("H"));          // High
+}
+
+//------------------------------------------------------------------------
+// all the output of the loop goes through the asynchronous logger: the loop only appends to a
+// buffer, and a lower priority thread writes it to Serial, so that the 5 ms cycle never waits on the
+// UART; if the output is more than the UART can take, the oldest lines are dropped and counted
+AsyncLogger<4096> logger;
+rtos::Thread log_drain_thread{osPriorityBelowNormal};
+constexpr unsigned long logger_stats_period_millis = 10000UL;
+unsigned long millis_last_logger_stats {0};
+
+void drain_logger(void){
+  while (true){
+    if (logger.drain_to(Serial) == 0){
+      rtos::ThisThread::sleep_for(std::chrono::milliseconds(2));
+    }
+  }
 }
 
 //------------------------------------------------------------------------
@@ -22,6 +41,9 @@ unsigned long millis_last_analysis {0};
 unsigned long millis_last_data_receiving {0};
 constexpr bool verbose_loop {false};
 constexpr bool verbose_timing {false};
+// the on board benchmark of the rotations delays the boot and the start of the IMU; see
+// extras/rotation_benchmark.cpp for the same on a computer
+constexpr bool run_benchmark {false};
 
 //------------------------------------------------------------------------
 void setup() {
@@ -32,6 +54,9 @@ void setup() {
   delay(10);
 
   vect_quat_library_self_diagnostic();
+  if (run_benchmark){
+    vect_quat_library_benchmark();
+  }
 
   Wire.begin();
   delay(50);
@@ -65,6 +90,10 @@ void setup() {
       break;
     }
   }
+
+  // from now on, print through the logger
+  log_drain_thread.start(drain_logger);
+  millis_last_logger_stats = millis();
 }
 
 float accel_x, accel_y, accel_z;
@@ -75,14 +104,19 @@ float mag_x, mag_y, mag_z;
 byte mag_accuracy;
 float quat_i, quat_j, quat_k, quat_real, quat_radian_accuracy;
 byte quat_accuracy;
+Orientation orientation;
 
 //------------------------------------------------------------------------
 void loop() {
   uint16_t reading_status = bno080_imu.getReadings();
   
-  if (reading_status != 0){
+  if (reading_status == 0){
+    // nothing new from the BNO; let the logger thread, which has a lower priority, run a bit
+    rtos::ThisThread::sleep_for(std::chrono::milliseconds(1));
+  }
+  else{
     if (verbose_timing){
-      Serial.print(F("received data at ms: ")); Serial.print(millis()); Serial.print(F(" | type: "));
+      logger.print(F("received data at ms: ")); logger.print(millis()); logger.print(F(" | type: "));
     }
     millis_last_data_receiving = millis();
 
@@ -92,7 +126,7 @@ void loop() {
       accel_z = bno080_imu.getAccelZ();
       accel_accuracy = bno080_imu.getLinAccelAccuracy();
       if (verbose_timing){
-        Serial.print(F("accel"));
+        logger.print(F("accel"));
       }
     }
 
@@ -102,7 +136,7 @@ void loop() {
       gyro_z = bno080_imu.getGyroZ();
       gyro_accuracy = bno080_imu.getGyroAccuracy();
       if (verbose_timing){
-        Serial.print(F("gyro"));
+        logger.print(F("gyro"));
       }
     }
 
@@ -112,7 +146,7 @@ void loop() {
       mag_z = bno080_imu.getMagZ();
       mag_accuracy = bno080_imu.getMagAccuracy();
       if (verbose_timing){
-        Serial.print(F("mag"));
+        logger.print(F("mag"));
       }
     }
 
@@ -124,20 +158,20 @@ void loop() {
       quat_accuracy = bno080_imu.getQuatAccuracy();
       quat_radian_accuracy = bno080_imu.getQuatRadianAccuracy();
       if (verbose_timing){
-        Serial.print(F("quat"));
+        logger.print(F("quat"));
       }
     }
 
     if (verbose_timing){
-        Serial.print(F(" | receive and print took ")); Serial.print(millis() - millis_last_data_receiving); Serial.println(F(" ms"));
+        logger.print(F(" | receive and print took ")); logger.print(millis() - millis_last_data_receiving); logger.println(F(" ms"));
     }
   }
 
   if (millis() - millis_last_analysis > 2 * imu_output_period_millis){
-    Serial.println(F("*************************************"));
-    Serial.println(F("WARNING: QUAT ANALYSIS FALLING BEHIND"));
-    Serial.print(F("ms: ")); Serial.println(millis());
-    Serial.println(F("*************************************"));
+    logger.println(F("*************************************"));
+    logger.println(F("WARNING: QUAT ANALYSIS FALLING BEHIND"));
+    logger.print(F("ms: ")); logger.println(millis());
+    logger.println(F("*************************************"));
     millis_last_analysis = millis();
   }
 
@@ -146,106 +180,117 @@ void loop() {
     unsigned long millis_start = millis();
 
     if (verbose_loop){
-      Serial.println();
-      Serial.print(F("millis start analysis: ")); Serial.println(millis_start);
+      logger.println();
+      logger.print(F("millis start analysis: ")); logger.println(millis_start);
   
-      Serial.print(F("accel: "));
-      Serial.print(accel_x, 4);
-      Serial.print(F(", "));
-      Serial.print(accel_y, 4);
-      Serial.print(F(", "));
-      Serial.print(accel_z, 4);
-      Serial.print(F(", pres: "));
-      printAccuracyLevel(accel_accuracy);
+      logger.print(F("accel: "));
+      logger.print(accel_x, 4);
+      logger.print(F(", "));
+      logger.print(accel_y, 4);
+      logger.print(F(", "));
+      logger.print(accel_z, 4);
+      logger.print(F(", pres: "));
+      printAccuracyLevel(logger, accel_accuracy);
   
-      Serial.print(F(" | gyro: "));
-      Serial.print(gyro_x, 4);
-      Serial.print(F(", "));
-      Serial.print(gyro_y, 4);
-      Serial.print(F(", "));
-      Serial.print(gyro_z, 4);
-      Serial.print(F(", pres: "));
-      printAccuracyLevel(gyro_accuracy);
+      logger.print(F(" | gyro: "));
+      logger.print(gyro_x, 4);
+      logger.print(F(", "));
+      logger.print(gyro_y, 4);
+      logger.print(F(", "));
+      logger.print(gyro_z, 4);
+      logger.print(F(", pres: "));
+      printAccuracyLevel(logger, gyro_accuracy);
   
-      Serial.print(F(" | mag: "));
-      Serial.print(mag_x, 4);
-      Serial.print(F(", "));
-      Serial.print(mag_y, 4);
-      Serial.print(F(", "));
-      Serial.print(mag_z, 4);
-      Serial.print(F(", pres: "));
-      printAccuracyLevel(mag_accuracy);
+      logger.print(F(" | mag: "));
+      logger.print(mag_x, 4);
+      logger.print(F(", "));
+      logger.print(mag_y, 4);
+      logger.print(F(", "));
+      logger.print(mag_z, 4);
+      logger.print(F(", pres: "));
+      printAccuracyLevel(logger, mag_accuracy);
       
-      Serial.print(F(" | quat: "));
-      Serial.print(quat_i, 4);
-      Serial.print(F(", "));
-      Serial.print(quat_j, 4);
-      Serial.print(F(", "));
-      Serial.print(quat_k, 4);
-      Serial.print(F(", "));
-      Serial.print(quat_real, 4);
-      Serial.print(F(", pres: "));
-      printAccuracyLevel(quat_accuracy);
-      Serial.print(F(", "));
-      Serial.print(quat_radian_accuracy, 4);
-      Serial.println();
+      logger.print(F(" | quat: "));
+      logger.print(quat_i, 4);
+      logger.print(F(", "));
+      logger.print(quat_j, 4);
+      logger.print(F(", "));
+      logger.print(quat_k, 4);
+      logger.print(F(", "));
+      logger.print(quat_real, 4);
+      logger.print(F(", pres: "));
+      printAccuracyLevel(logger, quat_accuracy);
+      logger.print(F(", "));
+      logger.print(quat_radian_accuracy, 4);
+      logger.println();
     }
 
     // look at quaternion data
     Quaternion quat_orientation {quat_real, quat_i, quat_j, quat_k};
+
+    // the rotation matrix is built once, on the first transform, and reused for all the vectors under
+    orientation.set(quat_orientation);
     
     if (verbose_loop){
-      print(quat_orientation);
-      Serial.print(F("quat norm: "));
-      Serial.println(quat_orientation.norm());
+      print(logger, quat_orientation);
+      logger.print(F("quat norm: "));
+      logger.println(quat_orientation.norm());
     }
 
     if (abs(quat_orientation.norm() - 1.0f) > 1.0e-2){
-      Serial.println(F("*************"));
-      Serial.println(F("NON UNIT QUAT"));
-      Serial.print(F("at ms: ")); Serial.print(millis()); Serial.print(F(", quat norm: ")); Serial.println(quat_orientation.norm());
-      Serial.println(F("*************"));
+      logger.println(F("*************"));
+      logger.println(F("NON UNIT QUAT"));
+      logger.print(F("at ms: ")); logger.print(millis()); logger.print(F(", quat norm: ")); logger.println(quat_orientation.norm());
+      logger.println(F("*************"));
     }
 
     // acceleration in an IMU and ENU referential (the datasheet says it outputs in East North Up rather than North East Down)
     Vector accel_imu_ref{accel_x, accel_y, accel_z};
     
     if (verbose_loop){
-      Serial.print(F("accel norm IMU frame of ref: ")); Serial.print(accel_imu_ref.norm());
+      logger.print(F("accel norm IMU frame of ref: ")); logger.print(accel_imu_ref.norm());
     }
 
-    Vector accel_ENU_ref{};
-    rotate_vect_by_quat_R(accel_imu_ref, quat_orientation, accel_ENU_ref);
+    Vector accel_ENU_ref = orientation.rotate(accel_imu_ref);
     
     if (verbose_loop){
-      Serial.print(F(" | ENU frame of ref: ")); Serial.println(accel_ENU_ref.norm());
-      Serial.print(F("accel ENU: "));
-      print(accel_ENU_ref);
+      logger.print(F(" | ENU frame of ref: ")); logger.println(accel_ENU_ref.norm());
+      logger.print(F("accel ENU: "));
+      print(logger, accel_ENU_ref);
     }
 
     // where is the X-direction of the IMU pointing?
     Vector imu_dir_x_ref_imu{1, 0, 0};
-    Vector imu_dir_x_ref_enu{};
-    rotate_vect_by_quat_R(imu_dir_x_ref_imu, quat_orientation, imu_dir_x_ref_enu);
+    Vector imu_dir_x_ref_enu = orientation.rotate(imu_dir_x_ref_imu);
     
     if (verbose_loop){
-      Serial.print(F("IMU X-dir in ENU frame: "));
-      print(imu_dir_x_ref_enu);
+      logger.print(F("IMU X-dir in ENU frame: "));
+      print(logger, imu_dir_x_ref_enu);
     }
 
     // quality checks
     if (abs(accel_ENU_ref.norm() - 9.81) > 10.0){
-      Serial.println(F("************"));
-      Serial.println(F("*HIGH ACCEL*"));
-      Serial.print(F("at ms: ")); Serial.print(millis()); Serial.print(F(", accel vect: ")); print(accel_ENU_ref);
-      Serial.println(F("************"));
+      logger.println(F("************"));
+      logger.println(F("*HIGH ACCEL*"));
+      logger.print(F("at ms: ")); logger.print(millis()); logger.print(F(", accel vect: ")); print(logger, accel_ENU_ref);
+      logger.println(F("************"));
     }
 
     unsigned long millis_end = millis();
     
     if (verbose_timing){
-      Serial.print(F("millis end: ")); Serial.print(millis_end); Serial.print(F(" | analysis + print duration: ")); Serial.print(millis_end-millis_start); Serial.println(F("ms"));
-      Serial.println();
+      logger.print(F("millis end: ")); logger.print(millis_end); logger.print(F(" | analysis + print duration: ")); logger.print(millis_end-millis_start); logger.println(F("ms"));
+      logger.println();
     }
   }
+
+  if (millis() - millis_last_logger_stats >= logger_stats_period_millis){
+    millis_last_logger_stats += logger_stats_period_millis;
+    AsyncLogCounters const log_counters = logger.counters();
+    logger.print(F("logger bytes logged: ")); logger.print(log_counters.bytes_logged);
+    logger.print(F(", sent: ")); logger.print(log_counters.bytes_sent);
+    logger.print(F(", records dropped: ")); logger.print(log_counters.records_dropped);
+    logger.print(F(", bytes dropped: ")); logger.print(log_counters.bytes_dropped);
+    logger.print(F(", max buffer use: ")); logger.println(log_counters.max_bytes_used);
+  }
 }
@@ -1,303 +1,40 @@
 #include "vector_and_quaternion.h"
 
 //--------------------------------------------------------------------------------
-bool is_approx(float val_1, float val_2, float tol){
-  return(abs(val_1-val_2)<tol);
-}
-
-//--------------------------------------------------------------------------------
-Quaternion::Quaternion(float q0, float q1, float q2, float q3):
-  q0{q0}, q1{q1}, q2{q2}, q3{q3}
-  {}
-
-Quaternion::Quaternion(Quaternion const & quat_in):
-  q0{quat_in.q0}, q1{quat_in.q1}, q2{quat_in.q2}, q3{quat_in.q3}
-  {}
-
-Quaternion::Quaternion(void):
-  q0{0}, q1{0}, q2{0}, q3{0}
-  {}
-
-void Quaternion::copy(Quaternion const & quat_in){
-  q0 = quat_in.q0;
-  q1 = quat_in.q1;
-  q2 = quat_in.q2;
-  q3 = quat_in.q3;
-}
-
-void Quaternion::conj(void){
-  q0 =  q0;
-  q1 = -q1;
-  q2 = -q2;
-  q3 = -q3;
-}
-
-float Quaternion::norm(void) const {
-  float res = sqrt(q0*q0 + q1*q1 + q2*q2 + q3*q3);
-  return res;
-}
-
-float Quaternion::norm_squared(void) const {
-  float res = q0*q0 + q1*q1 + q2*q2 + q3*q3;
-  return res;
-}
-
-bool Quaternion::is_normed(float tol) const {
-  return ((this->norm_squared() - 1) < tol);
-}
-
-void Quaternion::set(float q0, float q1, float q2, float q3){
-  this->q0 = q0;
-  this->q1 = q1;
-  this->q2 = q2;
-  this->q3 = q3;
-}
-
-bool Quaternion::operator==(Quaternion const & quat_in){
-  bool equal_content = (
-    (abs(q0 - quat_in.q0) < tol) &&
-    (abs(q1 - quat_in.q1) < tol) &&
-    (abs(q2 - quat_in.q2) < tol)
-  );
-  return equal_content;
-}
-
-//--------------------------------------------------------------------------------
-Vector::Vector(float v0, float v1, float v2):
-  v0{v0}, v1{v1}, v2{v2}
-  {}
-
-Vector::Vector(Vector const & vect_in):
-  v0{vect_in.v0}, v1{vect_in.v1}, v2{vect_in.v2}
-  {}
-
-Vector::Vector(void):
-  v0{0}, v1{0}, v2{0}
-  {}
-
-void Vector::copy(Vector const & vect_in){
-  v0 = vect_in.v0;
-  v1 = vect_in.v1;
-  v2 = vect_in.v2;
-}
-
-void Vector::add(Vector const & vect_in){
-  v0 += vect_in.v0;
-  v1 += vect_in.v1;
-  v2 += vect_in.v2;
-}
-
-void Vector::scale(float const scale){
-  v0 *= scale;
-  v1 *= scale;
-  v2 *= scale;
-}
-
-void Vector::set(float v0, float v1, float v2){
-  this->v0 = v0;
-  this->v1 = v1;
-  this->v2 = v2;
-}
-
-float Vector::norm(void) const{
-  return(sqrt(v0*v0 + v1*v1 + v2*v2));
+void print(Quaternion const & quat_in, bool println){
+  print(Serial, quat_in, println);
 }
 
-float Vector::norm_squared(void) const{
-  return(v0*v0 + v1*v1 + v2*v2);
+void print(Vector const & vect_in, bool println){
+  print(Serial, vect_in, println);
 }
 
-bool Vector::is_normed(void) const{
-  return(is_approx(this->norm_squared(), 1.0f));
-}
-
-bool Vector::operator==(Vector const & vect_in){
-  bool equal_content = ( 
-    (abs(v0 - vect_in.v0) < tol) &&
-    (abs(v1 - vect_in.v1) < tol) &&
-    (abs(v2 - vect_in.v2) < tol)
-  );
-  return equal_content;
-}
-
-//--------------------------------------------------------------------------------
-void print(Quaternion const & quat_in, bool println){
-  Serial.print(F("quat: scal = "));
-  Serial.print(quat_to_scalar_part(quat_in));
-  Serial.print(F(" | "));
+void print(Print & out, Quaternion const & quat_in, bool println){
+  out.print(F("quat: scal = "));
+  out.print(quat_to_scalar_part(quat_in));
+  out.print(F(" | "));
 
   Vector vect_part {0, 0, 0};
   quat_to_vect_part(quat_in, vect_part);
-  print(vect_part, false);
+  print(out, vect_part, false);
 
   if (println){
-    Serial.println();
+    out.println();
   }
 }
 
-void print(Vector const & vect_in, bool println){
-  Serial.print(F("vect = [ "));
-  Serial.print(vect_in.v0);
-  Serial.print(F(", "));
-  Serial.print(vect_in.v1);
-  Serial.print(F(", "));
-  Serial.print(vect_in.v2);
-  Serial.print(F(" ]"));
+void print(Print & out, Vector const & vect_in, bool println){
+  out.print(F("vect = [ "));
+  out.print(vect_in.v0);
+  out.print(F(", "));
+  out.print(vect_in.v1);
+  out.print(F(", "));
+  out.print(vect_in.v2);
+  out.print(F(" ]"));
 
   if (println){
-    Serial.println();
-  }
-}
-
-//--------------------------------------------------------------------------------
-float vect_norm_square(Vector const & vect_in){
-  float res = 
-    vect_in.v0 * vect_in.v0 +
-    vect_in.v1 * vect_in.v1 +
-    vect_in.v2 * vect_in.v2;
-  return res;
-}
-
-float vect_dot(Vector const & vect_1, Vector const & vect_2){
-  float res = 
-    vect_1.v0 * vect_2.v0 +
-    vect_1.v1 * vect_2.v1 +
-    vect_1.v2 * vect_2.v2;
-  return res;
-}
-
-void vect_cross(Vector const & vect_1, Vector const & vect_2, Vector & vect_out){
-  vect_out.v0 =  vect_1.v1 * vect_2.v2 - vect_1.v2 * vect_2.v1;
-  vect_out.v1 = -vect_1.v0 * vect_2.v2 + vect_1.v2 * vect_2.v0;
-  vect_out.v2 =  vect_1.v0 * vect_2.v1 - vect_1.v1 * vect_2.v0;
-}
-
-void vect_add(Vector const & vect_1, Vector const & vect_2, Vector & vect_out){
-  vect_out.v0 = vect_1.v0 + vect_2.v0;
-  vect_out.v1 = vect_1.v1 + vect_2.v1;
-  vect_out.v2 = vect_1.v2 + vect_2.v2;
-}
-
-void vect_scale(Vector const & vect_in, float const scale, Vector & vect_out){
-  vect_out.v0 = vect_in.v0 * scale;
-  vect_out.v1 = vect_in.v1 * scale;
-  vect_out.v2 = vect_in.v2 * scale;
-}
-
-//--------------------------------------------------------------------------------
-void quat_conj(Quaternion const & quat_in, Quaternion & quat_out){
-  quat_out.q0 =   quat_in.q0;
-  quat_out.q1 = - quat_in.q1;
-  quat_out.q2 = - quat_in.q2;
-  quat_out.q3 = - quat_in.q3;
-}
-
-void quat_prod(Quaternion const & quat_1, Quaternion const & quat_2, Quaternion & quat_out){
-    quat_out.q0 = quat_1.q0 * quat_2.q0 - quat_1.q1 * quat_2.q1 - quat_1.q2 * quat_2.q2 - quat_1.q3 * quat_2.q3;
-    quat_out.q1 = quat_1.q0 * quat_2.q1 + quat_1.q1 * quat_2.q0 + quat_1.q2 * quat_2.q3 - quat_1.q3 * quat_2.q2;
-    quat_out.q2 = quat_1.q0 * quat_2.q2 - quat_1.q1 * quat_2.q3 + quat_1.q2 * quat_2.q0 + quat_1.q3 * quat_2.q1;
-    quat_out.q3 = quat_1.q0 * quat_2.q3 + quat_1.q1 * quat_2.q2 - quat_1.q2 * quat_2.q1 + quat_1.q3 * quat_2.q0;
-}
-
-//--------------------------------------------------------------------------------
-void vect_to_quat(Vector const & vect_in, Quaternion & quat_out){
-  quat_out.q0 = 0;
-  quat_out.q1 = vect_in.v0;
-  quat_out.q2 = vect_in.v1;
-  quat_out.q3 = vect_in.v2;
-}
-
-bool quat_to_vect(Quaternion const & quat_in, Vector & vect_out, float tol){
-  vect_out.v0 = quat_in.q1;
-  vect_out.v1 = quat_in.q2;
-  vect_out.v2 = quat_in.q3;
-
-  if (abs(quat_in.q0) > tol){
-    return false;
+    out.println();
   }
-
-  return true;
-}
-
-void quat_to_vect_part(Quaternion const & quat_in, Vector & vect_out){
-  vect_out.v0 = quat_in.q1;
-  vect_out.v1 = quat_in.q2;
-  vect_out.v2 = quat_in.q3;
-}
-
-float quat_to_scalar_part(Quaternion const & quat_in){
-  float res = quat_in.q0;
-  return res;
-}
-
-bool rot_theta_normed_axis_to_rot_quat(float const rot_theta_rad, Vector const & normed_rot_axis, Quaternion & quat_out){
-  float cos_theta = cos(rot_theta_rad);
-  float sin_theta = sin(rot_theta_rad);
-  quat_out.set(
-    cos_theta,
-    sin_theta * normed_rot_axis.v0, sin_theta * normed_rot_axis.v1, sin_theta * normed_rot_axis.v2
-  );
-
-  if (!normed_rot_axis.is_normed()){
-    return false;
-  }
-  return true;
-}
-
-// using Rodriguez method: faster, see https://gamedev.stackexchange.com/questions/28395/rotating-vector3-by-a-quaternion
-bool rotate_vect_by_quat_R(Vector const & vect_in, Quaternion const & quat_in, Vector & vect_out){
-  Vector quat_vect_part{0, 0, 0};
-  quat_to_vect_part(quat_in, quat_vect_part);
-
-  float quat_scalar_part = quat_to_scalar_part(quat_in);
-
-  // compute each term in our working vector
-  Vector working_vector {0, 0, 0};
-
-  // reset vect out
-  vect_out.copy(working_vector);
-
-  // part 1
-  working_vector.copy(quat_vect_part);
-  working_vector.scale(vect_dot(quat_vect_part, vect_in));
-  working_vector.scale(2.0f);
-  vect_add(working_vector, vect_out, vect_out);
-
-  // part 2
-  working_vector.copy(vect_in);
-  working_vector.scale(quat_scalar_part*quat_scalar_part - vect_norm_square(quat_vect_part));
-  vect_add(working_vector, vect_out, vect_out);
-
-  // part 3
-  vect_cross(quat_vect_part, vect_in, working_vector);
-  working_vector.scale(2.0f * quat_scalar_part);
-  vect_add(working_vector, vect_out, vect_out);
-
-  if (!quat_in.is_normed()){
-    return false;
-  }
-
-  return true;
-}
-
-// using plain quaternion method
-bool rotate_vect_by_quat_Q(Vector const & vect_in, Quaternion const & quat_in, Vector & vect_out){
-  Quaternion working_quaternion = Quaternion{0, 0, 0, 0};
-  vect_to_quat(vect_in, working_quaternion);
-  
-  Quaternion input_conj_quaternion = Quaternion{quat_in};
-  input_conj_quaternion.conj();
-
-  quat_prod(quat_in, working_quaternion, working_quaternion);
-  quat_prod(working_quaternion, input_conj_quaternion, working_quaternion);
-
-  quat_to_vect(working_quaternion, vect_out);
-
-  if (!quat_in.is_normed()){
-    return false;
-  }
-
-  return true;
 }
 
 //--------------------------------------------------------------------------------
@@ -619,6 +356,28 @@ bool vect_quat_library_self_diagnostic(void){
   return_flag_rotate_Q = rotate_vect_by_quat_R(v1, q1, v3);
   uassert(v2 == v3, "rotate_vect_by_quat_R and return_flag_rotate_Q 1 do not agree");
 
+  // check the orientation and its cached rotation matrix --------------------
+  Orientation orientation {};
+  v1.set(0.5, 0.25, sqrt(1 - 0.5*0.5 - 0.25*0.25));
+  rot_theta_normed_axis_to_rot_quat(rot_theta, v1, q1);
+  orientation.set(q1);
+  v1.set(1, 2, 3);
+  rotate_vect_by_quat_R(v1, q1, v2);
+  uassert(orientation.rotate(v1) == v2, "Orientation from quaternion and rotate_vect_by_quat_R do not agree");
+  v1.set(-3, 0.5, 2);
+  rotate_vect_by_quat_R(v1, q1, v2);
+  uassert(orientation.rotate(v1) == v2, "Orientation cached matrix and rotate_vect_by_quat_R do not agree");
+
+  // yaw 90 deg around Z, pitch 90 deg around Y, roll 90 deg around X; rotate roll first, then pitch, then yaw
+  orientation.set_euler_zyx(0.5f * pi, 0, 0);
+  uassert(orientation.rotate(Vector{1, 0, 0}) == Vector(0, 1, 0), "Orientation yaw fails");
+  orientation.set_euler_zyx(0, 0.5f * pi, 0);
+  uassert(orientation.rotate(Vector{1, 0, 0}) == Vector(0, 0, -1), "Orientation pitch fails");
+  orientation.set_euler_zyx(0, 0, 0.5f * pi);
+  uassert(orientation.rotate(Vector{0, 1, 0}) == Vector(0, 0, 1), "Orientation roll fails");
+  orientation.set_euler_zyx(0.5f * pi, 0.5f * pi, 0);
+  uassert(orientation.rotate(Vector{0, 0, 1}) == Vector(0, 1, 0), "Orientation pitch then yaw fails");
+
   //--------------------------------------------------------------------------------
 
   Serial.println(F("diagnostic finished, vect and quat operations a success"));
@@ -627,3 +386,66 @@ bool vect_quat_library_self_diagnostic(void){
   return true;
 }
 
+
+//--------------------------------------------------------------------------------
+void vect_quat_library_benchmark(unsigned long nbr_of_rotations){
+  Serial.println(F("benchmark of the rotations"));
+
+  Quaternion quat_rotation {};
+  Vector axis {0.5f, 0.25f, sqrt(1.0f - 0.5f*0.5f - 0.25f*0.25f)};
+  rot_theta_normed_axis_to_rot_quat(28.5f * pi / 180.0f, axis, quat_rotation);
+
+  // the accumulation prevents the compiler from optimizing the loops away
+  Vector vect_in {1.0f, 2.0f, 3.0f};
+  Vector vect_out {};
+  Vector vect_acc {};
+
+  unsigned long micros_start = micros();
+  for (unsigned long ind=0; ind<nbr_of_rotations; ind++){
+    rotate_vect_by_quat_R(vect_in, quat_rotation, vect_out);
+    vect_acc.add(vect_out);
+    vect_in.v0 += 1.0e-3f;
+  }
+  unsigned long micros_R = micros() - micros_start;
+
+  micros_start = micros();
+  for (unsigned long ind=0; ind<nbr_of_rotations; ind++){
+    rotate_vect_by_quat_Q(vect_in, quat_rotation, vect_out);
+    vect_acc.add(vect_out);
+    vect_in.v0 += 1.0e-3f;
+  }
+  unsigned long micros_Q = micros() - micros_start;
+
+  // the batched version, on blocks of vectors given as structure of arrays
+  constexpr size_t block_size {64};
+  float block_0[block_size];
+  float block_1[block_size];
+  float block_2[block_size];
+  for (size_t ind=0; ind<block_size; ind++){
+    block_0[ind] = 1.0f + 1.0e-3f * ind;
+    block_1[ind] = 2.0f;
+    block_2[ind] = 3.0f;
+  }
+
+  unsigned long nbr_of_blocks = nbr_of_rotations / block_size;
+  micros_start = micros();
+  for (unsigned long ind=0; ind<nbr_of_blocks; ind++){
+    rotate_vects_by_quat_batch(block_0, block_1, block_2, quat_rotation, block_size, block_0, block_1, block_2);
+  }
+  unsigned long micros_batch = micros() - micros_start;
+  vect_acc.add(Vector{block_0[0], block_1[0], block_2[0]});
+
+  // check that the batched version agrees with the Rodriguez formula
+  vect_in.set(1.0f, 2.0f, 3.0f);
+  rotate_vect_by_quat_R(vect_in, quat_rotation, vect_out);
+  block_0[0] = 1.0f;
+  block_1[0] = 2.0f;
+  block_2[0] = 3.0f;
+  rotate_vects_by_quat_batch(block_0, block_1, block_2, quat_rotation, 1, block_0, block_1, block_2);
+  uassert(vect_out == Vector(block_0[0], block_1[0], block_2[0]), "rotate_vects_by_quat_batch and rotate_vect_by_quat_R do not agree");
+
+  Serial.print(F("rotate_vect_by_quat_R [rotations per s]: ")); Serial.println(1.0e6f * nbr_of_rotations / micros_R);
+  Serial.print(F("rotate_vect_by_quat_Q [rotations per s]: ")); Serial.println(1.0e6f * nbr_of_rotations / micros_Q);
+  Serial.print(F("rotate_vects_by_quat_batch [rotations per s]: ")); Serial.println(1.0e6f * nbr_of_blocks * block_size / micros_batch);
+  Serial.print(F("(accumulated, ignore) ")); print(vect_acc);
+}
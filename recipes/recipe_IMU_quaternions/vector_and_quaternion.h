@@ -3,18 +3,42 @@
 
 #ifdef ARDUINO
   #include "Arduino.h"
+  #include "assert_tools.h"
 #else
   #include "math.h"
   using namespace std;
 #endif
 
-#include "assert_tools.h"
-
 //--------------------------------------------------------------------------------
 constexpr float default_tol = 1.0e-4;
 constexpr float pi = 3.141592653589793f;
 
-bool is_approx(float val_1, float val_2, float tol=default_tol);
+inline bool is_approx(float val_1, float val_2, float tol=default_tol){
+  return(abs(val_1-val_2)<tol);
+}
+
+//--------------------------------------------------------------------------------
+// the vector and quaternion math is header only, and templated on the scalar type, so that all the small operations
+// can be inlined into the IMU loop; the objects hold only their components (no per object tolerance), the tolerances
+// used in the comparisons come from the traits under.
+
+template <typename T>
+struct VectQuatTraits;
+
+template <>
+struct VectQuatTraits<float>{
+  static constexpr float tol(void){return default_tol;}
+};
+
+template <>
+struct VectQuatTraits<double>{
+  static constexpr double tol(void){return 1.0e-9;}
+};
+
+template <typename T>
+constexpr T scalar_abs(T const value){
+  return (value < T(0)) ? -value : value;
+}
 
 //------------------------------------------------------------------------
 // Quaternion and Vector functions
@@ -23,84 +47,469 @@ bool is_approx(float val_1, float val_2, float tol=default_tol);
 // Rodriguez formula: https://gamedev.stackexchange.com/questions/28395/rotating-vector3-by-a-quaternion
 
 //--------------------------------------------------------------------------------
-class Vector{
+template <typename T>
+class VectorT{
   public:
+    using scalar_type = T;
+
     // constructor
-    Vector(float v0, float v1, float v2);
-    Vector(Vector const & vect_in);
-    Vector(void);
-
-    void copy(Vector const & vect_in);
-    void add(Vector const & vect_in);
-    void scale(float const scale);
-    void set(float v0, float v1, float v2);
-    float norm(void) const;
-    float norm_squared(void) const;
-    bool is_normed(void) const;
-    bool operator==(Vector const & vect_in);
+    constexpr VectorT(T v0, T v1, T v2): v0{v0}, v1{v1}, v2{v2} {}
+    constexpr VectorT(void): v0{0}, v1{0}, v2{0} {}
 
-    // data members
-    float v0;  // i component
-    float v1;  // j component
-    float v2;  // k component
+    void copy(VectorT const & vect_in){
+      *this = vect_in;
+    }
+
+    void add(VectorT const & vect_in){
+      v0 += vect_in.v0;
+      v1 += vect_in.v1;
+      v2 += vect_in.v2;
+    }
 
-    float tol = default_tol;
+    void scale(T const scale){
+      v0 *= scale;
+      v1 *= scale;
+      v2 *= scale;
+    }
+
+    void set(T v0, T v1, T v2){
+      this->v0 = v0;
+      this->v1 = v1;
+      this->v2 = v2;
+    }
+
+    T norm(void) const{
+      return(sqrt(norm_squared()));
+    }
+
+    constexpr T norm_squared(void) const{
+      return(v0*v0 + v1*v1 + v2*v2);
+    }
+
+    constexpr bool is_normed(T tol=VectQuatTraits<T>::tol()) const{
+      return(scalar_abs(norm_squared() - T(1)) < tol);
+    }
+
+    constexpr bool operator==(VectorT const & vect_in) const{
+      return(
+        (scalar_abs(v0 - vect_in.v0) < VectQuatTraits<T>::tol()) &&
+        (scalar_abs(v1 - vect_in.v1) < VectQuatTraits<T>::tol()) &&
+        (scalar_abs(v2 - vect_in.v2) < VectQuatTraits<T>::tol())
+      );
+    }
+
+    // data members
+    T v0;  // i component
+    T v1;  // j component
+    T v2;  // k component
 };
 
 //--------------------------------------------------------------------------------
-class Quaternion{
+template <typename T>
+class QuaternionT{
   public:
+    using scalar_type = T;
+
     // constructor
-    Quaternion(float q0, float q1, float q2, float q3);
-    Quaternion(Quaternion const & quat_in);
-    Quaternion(void);
-
-    void copy(Quaternion const & quat_in);
-    void conj(void);
-    float norm(void) const;
-    float norm_squared(void) const;
-    bool is_normed(float tol=default_tol) const;
-    void set (float q0, float q1, float q2, float q3);
-    bool operator==(Quaternion const & quat_in);
-    
-    // data members
-    float q0;  // real component
-    float q1;  // i component
-    float q2;  // j component
-    float q3;  // k component
+    constexpr QuaternionT(T q0, T q1, T q2, T q3): q0{q0}, q1{q1}, q2{q2}, q3{q3} {}
+    constexpr QuaternionT(void): q0{0}, q1{0}, q2{0}, q3{0} {}
+
+    void copy(QuaternionT const & quat_in){
+      *this = quat_in;
+    }
+
+    void conj(void){
+      q1 = -q1;
+      q2 = -q2;
+      q3 = -q3;
+    }
 
-    float tol = default_tol;
+    T norm(void) const{
+      return(sqrt(norm_squared()));
+    }
+
+    constexpr T norm_squared(void) const{
+      return(q0*q0 + q1*q1 + q2*q2 + q3*q3);
+    }
+
+    constexpr bool is_normed(T tol=VectQuatTraits<T>::tol()) const{
+      return(scalar_abs(norm_squared() - T(1)) < tol);
+    }
+
+    void set(T q0, T q1, T q2, T q3){
+      this->q0 = q0;
+      this->q1 = q1;
+      this->q2 = q2;
+      this->q3 = q3;
+    }
+
+    constexpr bool operator==(QuaternionT const & quat_in) const{
+      return(
+        (scalar_abs(q0 - quat_in.q0) < VectQuatTraits<T>::tol()) &&
+        (scalar_abs(q1 - quat_in.q1) < VectQuatTraits<T>::tol()) &&
+        (scalar_abs(q2 - quat_in.q2) < VectQuatTraits<T>::tol()) &&
+        (scalar_abs(q3 - quat_in.q3) < VectQuatTraits<T>::tol())
+      );
+    }
+
+    // data members
+    T q0;  // real component
+    T q1;  // i component
+    T q2;  // j component
+    T q3;  // k component
 };
 
+using Vector = VectorT<float>;
+using Quaternion = QuaternionT<float>;
+
+static_assert(sizeof(Vector) == 3 * sizeof(float), "Vector should only hold its components");
+static_assert(sizeof(Quaternion) == 4 * sizeof(float), "Quaternion should only hold its components");
+
 //--------------------------------------------------------------------------------
+// print to Serial, or to any other Print (for example the asynchronous logger)
+#ifdef ARDUINO
 void print(Vector const & vect_in, bool println=true);
 void print(Quaternion const & quat_in, bool println=true);
+void print(Print & out, Vector const & vect_in, bool println=true);
+void print(Print & out, Quaternion const & quat_in, bool println=true);
+#endif
 
 //--------------------------------------------------------------------------------
-float vect_norm_square(Vector const & vect_in);
-float vect_dot(Vector const & vect_1, Vector const & vect_2);
-void vect_cross(Vector const & vect_1, Vector const & vect_2, Vector & vect_out);
-void vect_add(Vector const & vect_1, Vector const & vect_2, Vector & vect_out);
-void vect_scale(Vector const & vect_in, float const scale, Vector & vect_out);
+// value returning, constexpr versions; the versions with an output argument under are thin wrappers around these
+
+template <typename T>
+constexpr T vect_norm_square(VectorT<T> const & vect_in){
+  return vect_in.v0 * vect_in.v0 + vect_in.v1 * vect_in.v1 + vect_in.v2 * vect_in.v2;
+}
+
+template <typename T>
+constexpr T vect_dot(VectorT<T> const & vect_1, VectorT<T> const & vect_2){
+  return vect_1.v0 * vect_2.v0 + vect_1.v1 * vect_2.v1 + vect_1.v2 * vect_2.v2;
+}
+
+template <typename T>
+constexpr VectorT<T> vect_cross(VectorT<T> const & vect_1, VectorT<T> const & vect_2){
+  return VectorT<T>{
+     vect_1.v1 * vect_2.v2 - vect_1.v2 * vect_2.v1,
+    -vect_1.v0 * vect_2.v2 + vect_1.v2 * vect_2.v0,
+     vect_1.v0 * vect_2.v1 - vect_1.v1 * vect_2.v0
+  };
+}
+
+template <typename T>
+constexpr VectorT<T> vect_add(VectorT<T> const & vect_1, VectorT<T> const & vect_2){
+  return VectorT<T>{vect_1.v0 + vect_2.v0, vect_1.v1 + vect_2.v1, vect_1.v2 + vect_2.v2};
+}
+
+template <typename T>
+constexpr VectorT<T> vect_scale(VectorT<T> const & vect_in, typename VectorT<T>::scalar_type const scale){
+  return VectorT<T>{vect_in.v0 * scale, vect_in.v1 * scale, vect_in.v2 * scale};
+}
+
+template <typename T>
+constexpr QuaternionT<T> quat_conj(QuaternionT<T> const & quat_in){
+  return QuaternionT<T>{quat_in.q0, -quat_in.q1, -quat_in.q2, -quat_in.q3};
+}
+
+template <typename T>
+constexpr QuaternionT<T> quat_prod(QuaternionT<T> const & quat_1, QuaternionT<T> const & quat_2){
+  return QuaternionT<T>{
+    quat_1.q0 * quat_2.q0 - quat_1.q1 * quat_2.q1 - quat_1.q2 * quat_2.q2 - quat_1.q3 * quat_2.q3,
+    quat_1.q0 * quat_2.q1 + quat_1.q1 * quat_2.q0 + quat_1.q2 * quat_2.q3 - quat_1.q3 * quat_2.q2,
+    quat_1.q0 * quat_2.q2 - quat_1.q1 * quat_2.q3 + quat_1.q2 * quat_2.q0 + quat_1.q3 * quat_2.q1,
+    quat_1.q0 * quat_2.q3 + quat_1.q1 * quat_2.q2 - quat_1.q2 * quat_2.q1 + quat_1.q3 * quat_2.q0
+  };
+}
+
+template <typename T>
+constexpr QuaternionT<T> vect_to_quat(VectorT<T> const & vect_in){
+  return QuaternionT<T>{0, vect_in.v0, vect_in.v1, vect_in.v2};
+}
+
+template <typename T>
+constexpr VectorT<T> quat_to_vect_part(QuaternionT<T> const & quat_in){
+  return VectorT<T>{quat_in.q1, quat_in.q2, quat_in.q3};
+}
+
+template <typename T>
+constexpr T quat_to_scalar_part(QuaternionT<T> const & quat_in){
+  return quat_in.q0;
+}
+
+// Rodriguez formula, R(v) = 2 (u . v) u + (s * s - u . u) v + 2 s (u x v) with q = [s, u]; written as a single
+// expression so that it is constexpr in C++11, the compiler factors the common terms
+template <typename T>
+constexpr VectorT<T> rodriguez_combine(VectorT<T> const & vect_in, QuaternionT<T> const & quat_in, T const two_u_dot_v, T const s2_minus_u2){
+  return VectorT<T>{
+    two_u_dot_v * quat_in.q1 + s2_minus_u2 * vect_in.v0 + T(2) * quat_in.q0 * (quat_in.q2 * vect_in.v2 - quat_in.q3 * vect_in.v1),
+    two_u_dot_v * quat_in.q2 + s2_minus_u2 * vect_in.v1 + T(2) * quat_in.q0 * (quat_in.q3 * vect_in.v0 - quat_in.q1 * vect_in.v2),
+    two_u_dot_v * quat_in.q3 + s2_minus_u2 * vect_in.v2 + T(2) * quat_in.q0 * (quat_in.q1 * vect_in.v1 - quat_in.q2 * vect_in.v0)
+  };
+}
+
+// rotate a vector by a quaternion, without any check on the quaternion
+template <typename T>
+constexpr VectorT<T> rotated_by_quat_R(VectorT<T> const & vect_in, QuaternionT<T> const & quat_in){
+  return rodriguez_combine(
+    vect_in, quat_in,
+    T(2) * (quat_in.q1 * vect_in.v0 + quat_in.q2 * vect_in.v1 + quat_in.q3 * vect_in.v2),
+    quat_in.q0 * quat_in.q0 - (quat_in.q1 * quat_in.q1 + quat_in.q2 * quat_in.q2 + quat_in.q3 * quat_in.q3)
+  );
+}
 
 //--------------------------------------------------------------------------------
-void quat_conj(Quaternion const & quat_in, Quaternion & quat_out);
-void quat_prod(Quaternion const & quat_1, Quaternion const & quat_2, Quaternion & quat_out);
+template <typename T>
+inline void vect_cross(VectorT<T> const & vect_1, VectorT<T> const & vect_2, VectorT<T> & vect_out){
+  vect_out = vect_cross(vect_1, vect_2);
+}
+
+template <typename T>
+inline void vect_add(VectorT<T> const & vect_1, VectorT<T> const & vect_2, VectorT<T> & vect_out){
+  vect_out = vect_add(vect_1, vect_2);
+}
+
+template <typename T>
+inline void vect_scale(VectorT<T> const & vect_in, typename VectorT<T>::scalar_type const scale, VectorT<T> & vect_out){
+  vect_out = vect_scale(vect_in, scale);
+}
+
+//--------------------------------------------------------------------------------
+template <typename T>
+inline void quat_conj(QuaternionT<T> const & quat_in, QuaternionT<T> & quat_out){
+  quat_out = quat_conj(quat_in);
+}
+
+template <typename T>
+inline void quat_prod(QuaternionT<T> const & quat_1, QuaternionT<T> const & quat_2, QuaternionT<T> & quat_out){
+  quat_out = quat_prod(quat_1, quat_2);
+}
 
 //--------------------------------------------------------------------------------
-void vect_to_quat(Vector const & vect_in, Quaternion & quat_out);
-bool quat_to_vect(Quaternion const & quat_in, Vector & vect_out, float tol=default_tol);
-void quat_to_vect_part(Quaternion const & quat_in, Vector & vect_out);
-float quat_to_scalar_part(Quaternion const & quat_in);
-bool rot_theta_normed_axis_to_rot_quat(float const rot_theta_rad, Vector const & normed_rot_axis, Quaternion & quat_out);
-bool rotate_vect_by_quat_R(Vector const & vect_in, Quaternion const & quat_in, Vector & vect_out);  // using the Rodriguez formula: much faster
+template <typename T>
+inline void vect_to_quat(VectorT<T> const & vect_in, QuaternionT<T> & quat_out){
+  quat_out = vect_to_quat(vect_in);
+}
+
+template <typename T>
+inline bool quat_to_vect(QuaternionT<T> const & quat_in, VectorT<T> & vect_out, typename VectorT<T>::scalar_type tol=VectQuatTraits<T>::tol()){
+  vect_out = quat_to_vect_part(quat_in);
+  return (scalar_abs(quat_in.q0) <= tol);
+}
+
+template <typename T>
+inline void quat_to_vect_part(QuaternionT<T> const & quat_in, VectorT<T> & vect_out){
+  vect_out = quat_to_vect_part(quat_in);
+}
+
+template <typename T>
+inline bool rot_theta_normed_axis_to_rot_quat(typename VectorT<T>::scalar_type const rot_theta_rad, VectorT<T> const & normed_rot_axis, QuaternionT<T> & quat_out){
+  T cos_theta = cos(rot_theta_rad);
+  T sin_theta = sin(rot_theta_rad);
+  quat_out.set(
+    cos_theta,
+    sin_theta * normed_rot_axis.v0, sin_theta * normed_rot_axis.v1, sin_theta * normed_rot_axis.v2
+  );
+
+  return normed_rot_axis.is_normed();
+}
+
+// using the Rodriguez formula: much faster
+template <typename T>
+inline bool rotate_vect_by_quat_R(VectorT<T> const & vect_in, QuaternionT<T> const & quat_in, VectorT<T> & vect_out){
+  vect_out = rotated_by_quat_R(vect_in, quat_in);
+  return quat_in.is_normed();
+}
+
+// using the quaternions formula: slower
 // TODO: put a depreciation warning
-bool rotate_vect_by_quat_Q(Vector const & vect_in, Quaternion const & quat_in, Vector & vect_out);  // using the quaternions formula: slower
+template <typename T>
+inline bool rotate_vect_by_quat_Q(VectorT<T> const & vect_in, QuaternionT<T> const & quat_in, VectorT<T> & vect_out){
+  QuaternionT<T> rotated = quat_prod(quat_prod(quat_in, vect_to_quat(vect_in)), quat_conj(quat_in));
+  vect_out = quat_to_vect_part(rotated);
+  return quat_in.is_normed();
+}
+
+//--------------------------------------------------------------------------------
+// rotation matrix and batched rotations: when many vectors are rotated by the same quaternion, it is cheaper to build
+// the 3x3 rotation matrix once (9 multiply adds per vector afterwards).
+// the matrix is written in homogeneous form, so that it gives exactly the same result as the Rodriguez formula also for
+// non unit quaternions (i.e. a rotation and a scaling by the square norm of the quaternion).
+
+template <typename T>
+struct RotationMatrixT{
+  // row major: m[3 * row + col]
+  T m[9];
+};
+
+using RotationMatrix = RotationMatrixT<float>;
+
+template <typename T>
+constexpr RotationMatrixT<T> quat_to_rotation_matrix(QuaternionT<T> const & quat_in){
+  return RotationMatrixT<T>{{
+    quat_in.q0 * quat_in.q0 + quat_in.q1 * quat_in.q1 - quat_in.q2 * quat_in.q2 - quat_in.q3 * quat_in.q3,
+    T(2) * (quat_in.q1 * quat_in.q2 - quat_in.q0 * quat_in.q3),
+    T(2) * (quat_in.q1 * quat_in.q3 + quat_in.q0 * quat_in.q2),
+
+    T(2) * (quat_in.q1 * quat_in.q2 + quat_in.q0 * quat_in.q3),
+    quat_in.q0 * quat_in.q0 - quat_in.q1 * quat_in.q1 + quat_in.q2 * quat_in.q2 - quat_in.q3 * quat_in.q3,
+    T(2) * (quat_in.q2 * quat_in.q3 - quat_in.q0 * quat_in.q1),
+
+    T(2) * (quat_in.q1 * quat_in.q3 - quat_in.q0 * quat_in.q2),
+    T(2) * (quat_in.q2 * quat_in.q3 + quat_in.q0 * quat_in.q1),
+    quat_in.q0 * quat_in.q0 - quat_in.q1 * quat_in.q1 - quat_in.q2 * quat_in.q2 + quat_in.q3 * quat_in.q3
+  }};
+}
+
+template <typename T>
+constexpr VectorT<T> rotation_matrix_apply(RotationMatrixT<T> const & matrix, VectorT<T> const & vect_in){
+  return VectorT<T>{
+    matrix.m[0] * vect_in.v0 + matrix.m[1] * vect_in.v1 + matrix.m[2] * vect_in.v2,
+    matrix.m[3] * vect_in.v0 + matrix.m[4] * vect_in.v1 + matrix.m[5] * vect_in.v2,
+    matrix.m[6] * vect_in.v0 + matrix.m[7] * vect_in.v1 + matrix.m[8] * vect_in.v2
+  };
+}
+
+// rotate a block of nbr_of_vects vectors, given as a structure of arrays (one array per component), by a single
+// quaternion; in place operation (in_X == out_X) is allowed, partially overlapping arrays are not
+template <typename T>
+void rotate_vects_by_quat_batch(T const * in_0, T const * in_1, T const * in_2,
+                                QuaternionT<T> const & quat_in, size_t nbr_of_vects,
+                                T * out_0, T * out_1, T * out_2){
+  RotationMatrixT<T> const matrix = quat_to_rotation_matrix(quat_in);
+
+  // copy the coefficients to locals, so that the compiler knows they are not modified through the output pointers
+  T const m0 = matrix.m[0], m1 = matrix.m[1], m2 = matrix.m[2];
+  T const m3 = matrix.m[3], m4 = matrix.m[4], m5 = matrix.m[5];
+  T const m6 = matrix.m[6], m7 = matrix.m[7], m8 = matrix.m[8];
+
+  for (size_t ind=0; ind<nbr_of_vects; ind++){
+    T const v0 = in_0[ind];
+    T const v1 = in_1[ind];
+    T const v2 = in_2[ind];
+    out_0[ind] = m0 * v0 + m1 * v1 + m2 * v2;
+    out_1[ind] = m3 * v0 + m4 * v1 + m5 * v2;
+    out_2[ind] = m6 * v0 + m7 * v1 + m8 * v2;
+  }
+}
+
+// rotate a block of vectors, each by its own quaternion, all given as structures of arrays; this is the Rodriguez
+// formula written on plain arrays, so that the loop vectorizes
+template <typename T>
+void rotate_vects_by_quats_batch(T const * in_0, T const * in_1, T const * in_2,
+                                 T const * quat_0, T const * quat_1, T const * quat_2, T const * quat_3,
+                                 size_t nbr_of_vects,
+                                 T * out_0, T * out_1, T * out_2){
+  for (size_t ind=0; ind<nbr_of_vects; ind++){
+    T const v0 = in_0[ind];
+    T const v1 = in_1[ind];
+    T const v2 = in_2[ind];
+    T const s  = quat_0[ind];
+    T const u0 = quat_1[ind];
+    T const u1 = quat_2[ind];
+    T const u2 = quat_3[ind];
+
+    T const two_u_dot_v = T(2) * (u0 * v0 + u1 * v1 + u2 * v2);
+    T const s2_minus_u2 = s * s - (u0 * u0 + u1 * u1 + u2 * u2);
+    T const two_s = T(2) * s;
+
+    out_0[ind] = two_u_dot_v * u0 + s2_minus_u2 * v0 + two_s * (u1 * v2 - u2 * v1);
+    out_1[ind] = two_u_dot_v * u1 + s2_minus_u2 * v1 + two_s * (u2 * v0 - u0 * v2);
+    out_2[ind] = two_u_dot_v * u2 + s2_minus_u2 * v2 + two_s * (u0 * v1 - u1 * v0);
+  }
+}
+
+//--------------------------------------------------------------------------------
+// rotation matrix of the intrinsic Z-Y-X (yaw, pitch, roll) Euler angles, i.e. R = Rz(yaw) Ry(pitch) Rx(roll): rotating
+// by it is the same as rotating by roll around X, then by pitch around Y, then by yaw around Z
+template <typename T>
+RotationMatrixT<T> euler_zyx_to_rotation_matrix(T const yaw_rad, T const pitch_rad, T const roll_rad){
+  T const cy = cos(yaw_rad);
+  T const sy = sin(yaw_rad);
+  T const cp = cos(pitch_rad);
+  T const sp = sin(pitch_rad);
+  T const cr = cos(roll_rad);
+  T const sr = sin(roll_rad);
+
+  return RotationMatrixT<T>{{
+    cy * cp, cy * sp * sr - sy * cr, cy * sp * cr + sy * sr,
+    sy * cp, sy * sp * sr + cy * cr, sy * sp * cr - cy * sr,
+    -sp,     cp * sr,                cp * cr
+  }};
+}
+
+//--------------------------------------------------------------------------------
+// an orientation, set from a quaternion or from Euler angles, that is used to transform several vectors; the rotation
+// matrix is built on the first transform after each update and cached, so that each transform is then only 9
+// multiply adds, and an orientation that is updated but not used costs nothing.
+template <typename T>
+class OrientationT{
+  public:
+    using scalar_type = T;
+
+    // constructor; the identity
+    constexpr OrientationT(void):
+      quat{T(1), T(0), T(0), T(0)}, yaw_rad{0}, pitch_rad{0}, roll_rad{0},
+      source{Source::quaternion}, matrix{}, matrix_is_valid{false} {}
+
+    void set(QuaternionT<T> const & quat_in){
+      quat = quat_in;
+      source = Source::quaternion;
+      matrix_is_valid = false;
+    }
+
+    void set_euler_zyx(T const yaw_rad, T const pitch_rad, T const roll_rad){
+      this->yaw_rad = yaw_rad;
+      this->pitch_rad = pitch_rad;
+      this->roll_rad = roll_rad;
+      source = Source::euler_zyx;
+      matrix_is_valid = false;
+    }
+
+    RotationMatrixT<T> const & rotation_matrix(void){
+      if (!matrix_is_valid){
+        if (source == Source::quaternion){
+          matrix = quat_to_rotation_matrix(quat);
+        }
+        else{
+          matrix = euler_zyx_to_rotation_matrix(yaw_rad, pitch_rad, roll_rad);
+        }
+        matrix_is_valid = true;
+      }
+      return matrix;
+    }
+
+    VectorT<T> rotate(VectorT<T> const & vect_in){
+      return rotation_matrix_apply(rotation_matrix(), vect_in);
+    }
+
+    void rotate(VectorT<T> const & vect_in, VectorT<T> & vect_out){
+      vect_out = rotate(vect_in);
+    }
+
+  private:
+    enum class Source : uint8_t {quaternion, euler_zyx};
+
+    // data members; what the orientation was last set from
+    QuaternionT<T> quat;
+    T yaw_rad;
+    T pitch_rad;
+    T roll_rad;
+    Source source;
+
+    // the cached rotation matrix
+    RotationMatrixT<T> matrix;
+    bool matrix_is_valid;
+};
+
+using Orientation = OrientationT<float>;
 
 //--------------------------------------------------------------------------------
 // TODO: move into some proper tests
 bool vect_quat_library_self_diagnostic(void);
 
+// time a number of rotations with each method, and print the number of rotations per second
+void vect_quat_library_benchmark(unsigned long nbr_of_rotations=10000);
+
 #endif
 
 // TODO: change all function names expecting normed quats and vector to _normed_
@@ -11,7 +11,7 @@
 #include "Arduino.h"
 #include <Adafruit_Sensor_Calibration.h>
 #include <Adafruit_AHRS.h>
-#include "kiss_clang_3d.h"
+#include <kiss_clang_3d.h>
 
 Adafruit_Sensor *accelerometer, *gyroscope, *magnetometer;
 
@@ -164,20 +164,58 @@ void loop() {
   Serial.print("Printing took "); Serial.print(micros()-timestamp); Serial.println(" us");
 #endif
 
-  // perform the quaternion transform to go into a NED or similar referential
-  vec3 accel_raw;
+  // perform the quaternion transform to go into a NED or similar referential; the filter output is a
+  // unit quaternion, so the unchecked unit_quat path applies
   vec3 accel_NED;
   quat quat_rotation;
   
-  vec3_setter(&accel_raw, accel.acceleration.x, accel.acceleration.y, accel.acceleration.z);
+  vec3_setter(&accel_NED, accel.acceleration.x, accel.acceleration.y, accel.acceleration.z);
   quat_setter(&quat_rotation, qw, qx, qy, qz);
-  rotate_by_quat_R(&accel_raw, &quat_rotation, &accel_NED);
+  unit_quat_rotate(&accel_NED, &quat_rotation);
   
   Serial.print("rotated acc: ");
   Serial.print(accel_NED.i, 4); Serial.print(", ");
   Serial.print(accel_NED.j, 4); Serial.print(", ");
   Serial.print(accel_NED.k, 4); Serial.print(", ");
   Serial.println();
+
+#if defined(AHRS_DEBUG_OUTPUT)
+  // per sample cost of going back from the NED to the sensor frame, with the checked path vs the unit
+  // quaternion path; the quaternion is read through volatile and the vector changes at each repeat,
+  // and the results are summed and printed, so that the compiler can neither hoist nor drop the work
+  constexpr int nbr_of_repeats {100};
+  volatile float volatile_quat[4] {qw, qx, qy, qz};
+  vec3 accel_in;
+  vec3 accel_back;
+  float sum_checked_path {0.0f};
+  float sum_unit_path {0.0f};
+
+  timestamp = micros();
+  for (int repeat=0; repeat<nbr_of_repeats; repeat++){
+    quat quat_inverse;
+    quat_setter(&quat_inverse, volatile_quat[0], volatile_quat[1], volatile_quat[2], volatile_quat[3]);
+    vec3_setter(&accel_in, accel_NED.i + 1.0e-3f * repeat, accel_NED.j, accel_NED.k);
+    if (quat_is_unitary(&quat_inverse) && quat_inv(&quat_inverse)){
+      rotate_by_quat_R(&accel_in, &quat_inverse, &accel_back);
+      sum_checked_path += accel_back.i + accel_back.j + accel_back.k;
+    }
+  }
+  unsigned long checked_path_us = micros() - timestamp;
+
+  timestamp = micros();
+  for (int repeat=0; repeat<nbr_of_repeats; repeat++){
+    quat quat_crrt;
+    quat_setter(&quat_crrt, volatile_quat[0], volatile_quat[1], volatile_quat[2], volatile_quat[3]);
+    vec3_setter(&accel_in, accel_NED.i + 1.0e-3f * repeat, accel_NED.j, accel_NED.k);
+    unit_quat_rotate_inv(&accel_in, &quat_crrt, &accel_back);
+    sum_unit_path += accel_back.i + accel_back.j + accel_back.k;
+  }
+  unsigned long unit_path_us = micros() - timestamp;
+
+  Serial.print("back rotation per sample, checked path [ns]: "); Serial.print(checked_path_us * 1000UL / nbr_of_repeats);
+  Serial.print(" | unit_quat path [ns]: "); Serial.print(unit_path_us * 1000UL / nbr_of_repeats);
+  Serial.print(" | sums (should agree): "); Serial.print(sum_checked_path, 4); Serial.print(", "); Serial.println(sum_unit_path, 4);
+#endif
 }
 
 /*
@@ -0,0 +1,161 @@
+// check the FRAM capacity detection on a computer, on simulated FRAMs of all the usual sizes, and
+// compare its number of SPI transactions with the linear probe (readBack every 256 bytes):
+//
+//   g++ -O2 -std=c++11 -I.. -I../../../libraries/kiss_crc/src fram_capacity_sim.cpp -o fram_capacity_sim
+//   ./fram_capacity_sim
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "fram_capacity.h"
+
+// the FRAM: the address bits above the capacity are ignored, so that the addresses wrap
+struct SimulatedFram{
+  std::vector<uint8_t> memory;
+  unsigned long nbr_transactions {0};
+  // the writes outside of [allowed_begin, allowed_end), once set
+  uint32_t allowed_begin {0};
+  uint32_t allowed_end {UINT32_MAX};
+  unsigned long nbr_writes_outside {0};
+
+  explicit SimulatedFram(uint32_t const capacity): memory(capacity) {
+    std::mt19937 generator {capacity};
+    for (auto & crrt_byte : memory){
+      crrt_byte = static_cast<uint8_t>(generator());
+    }
+  }
+
+  void read(uint32_t address, uint8_t * buffer, size_t nbr_bytes){
+    nbr_transactions++;
+    for (size_t ind=0; ind<nbr_bytes; ind++){
+      buffer[ind] = memory[(address + ind) & (memory.size() - 1)];
+    }
+  }
+
+  void write(uint32_t address, uint8_t const * buffer, size_t nbr_bytes){
+    nbr_transactions++;
+    if ((address < allowed_begin) || (address + nbr_bytes > allowed_end)){
+      nbr_writes_outside++;
+    }
+    for (size_t ind=0; ind<nbr_bytes; ind++){
+      memory[(address + ind) & (memory.size() - 1)] = buffer[ind];
+    }
+  }
+};
+
+// the linear probe of the recipe before, for comparison: readBack at every 256 bytes
+static int32_t read_back(SimulatedFram & fram, uint32_t addr, int32_t data){
+  int32_t check;
+  int32_t wrap_check;
+  int32_t backup;
+  fram.read(addr, reinterpret_cast<uint8_t *>(&backup), 4);
+  fram.write(addr, reinterpret_cast<uint8_t *>(&data), 4);
+  fram.read(addr, reinterpret_cast<uint8_t *>(&check), 4);
+  fram.read(0, reinterpret_cast<uint8_t *>(&wrap_check), 4);
+  fram.write(addr, reinterpret_cast<uint8_t *>(&backup), 4);
+  if (wrap_check == check)
+    check = 0;
+  return check;
+}
+
+static uint32_t linear_capacity(SimulatedFram & fram){
+  uint32_t mem_size = 256;
+  while (read_back(fram, mem_size, mem_size) == static_cast<int32_t>(mem_size)) {
+    mem_size += 256;
+  }
+  return mem_size;
+}
+
+static constexpr uint32_t metadata_address {0x3F0};
+static unsigned long nbr_errors {0};
+
+static void expect(char const * what, bool const condition){
+  if (!condition){
+    printf("ERROR: %s\n", what);
+    nbr_errors++;
+  }
+}
+
+static char const * source_name(FramCapacitySource const source){
+  switch (source){
+    case FramCapacitySource::cache: return "cache";
+    case FramCapacitySource::device_id: return "device id";
+    case FramCapacitySource::search: return "search";
+    default: return "none";
+  }
+}
+
+int main(){
+  printf("%10s %4s | %-26s | %-26s | %-26s | %s\n", "capacity", "addr", "search", "device id", "next boot (cache)", "linear probe");
+
+  for (uint32_t capacity=2048; capacity<=(1u << 22); capacity*=2){
+    uint8_t const address_size = (capacity <= (1u << 16)) ? 2 : 3;
+
+    // first boot, no device ID
+    SimulatedFram fram(capacity);
+    fram.allowed_begin = metadata_address;
+    fram.allowed_end = metadata_address + fram_capacity_metadata_length;
+    std::vector<uint8_t> const original = fram.memory;
+    FramCapacityDetector<SimulatedFram> detector(fram, metadata_address);
+    FramCapacityResult const searched = detector.detect(address_size);
+    expect("search capacity", searched.capacity == capacity);
+    expect("search source", searched.source == FramCapacitySource::search);
+    // only the metadata may have changed
+    std::vector<uint8_t> restored = fram.memory;
+    for (size_t ind=0; ind<fram_capacity_metadata_length; ind++){
+      restored[(metadata_address + ind) & (capacity - 1)] = original[(metadata_address + ind) & (capacity - 1)];
+    }
+    expect("memory restored", restored == original);
+    expect("writes only in the metadata record", fram.nbr_writes_outside == 0);
+
+    // next boot: from the cache
+    FramCapacityResult const cached = detector.detect(address_size);
+    expect("cache capacity", cached.capacity == capacity);
+    expect("cache source", cached.source == FramCapacitySource::cache);
+
+    // first boot with the device ID
+    SimulatedFram fram_id(capacity);
+    FramCapacityDetector<SimulatedFram> detector_id(fram_id, metadata_address);
+    uint8_t density {0};
+    while ((1u << (10 + density)) < capacity){
+      density++;
+    }
+    uint32_t const id_capacity = fram_capacity_from_device_id(0x04, static_cast<uint16_t>((density << 8) | 0x02));
+    expect("device id capacity", id_capacity == capacity);
+    fram_id.allowed_begin = metadata_address;
+    fram_id.allowed_end = metadata_address + fram_capacity_metadata_length;
+    FramCapacityResult const from_id = detector_id.detect(address_size, id_capacity);
+    expect("device id result", (from_id.capacity == capacity) && (from_id.source == FramCapacitySource::device_id));
+    expect("device id, writes only in the metadata record", fram_id.nbr_writes_outside == 0);
+
+    // a wrong device ID, and a stale cache (another chip): both fall back to the search
+    SimulatedFram fram_wrong(capacity);
+    FramCapacityDetector<SimulatedFram> detector_wrong(fram_wrong, metadata_address);
+    FramCapacityResult const wrong_id = detector_wrong.detect(address_size, capacity / 4);
+    expect("wrong device id", (wrong_id.capacity == capacity) && (wrong_id.source == FramCapacitySource::search));
+    if (capacity >= 4096){
+      SimulatedFram fram_bigger(capacity);
+      uint8_t metadata[fram_capacity_metadata_length];
+      fram_wrong.read(metadata_address, metadata, fram_capacity_metadata_length);
+      SimulatedFram fram_smaller(capacity / 2);
+      fram_smaller.write(metadata_address, metadata, fram_capacity_metadata_length);
+      FramCapacityDetector<SimulatedFram> detector_stale(fram_smaller, metadata_address);
+      FramCapacityResult const stale = detector_stale.detect(address_size);
+      expect("stale cache", (stale.capacity == capacity / 2) && (stale.source == FramCapacitySource::search));
+    }
+
+    SimulatedFram fram_linear(capacity);
+    uint32_t const linear = linear_capacity(fram_linear);
+    expect("linear capacity", linear == capacity);
+
+    printf("%10u %4u | %2u probes %4u transactions | %2u probes %4u transactions | %2u probes %4u transactions (%s) | %lu transactions\n",
+           capacity, address_size, searched.nbr_probes, searched.nbr_transactions, from_id.nbr_probes, from_id.nbr_transactions,
+           cached.nbr_probes, cached.nbr_transactions, source_name(cached.source), fram_linear.nbr_transactions);
+  }
+
+  printf("%lu errors\n", nbr_errors);
+  return (nbr_errors == 0) ? 0 : 1;
+}
@@ -0,0 +1,270 @@
+// drive the FRAM log store on a computer, with a simulated FRAM that can lose power in the middle of
+// a write: random records are appended and committed, the power is cut at random points, and after
+// each reboot the store is mounted again and all the records read back are checked:
+//
+//   g++ -O2 -std=c++11 -I.. -I../../../libraries/kiss_crc/src fram_log_store_sim.cpp -o fram_log_store_sim
+//   ./fram_log_store_sim
+//
+// every record carries its index and a pattern derived from it, so the records read back must be
+// intact, in order, without gaps, and include at least all the records committed before the power
+// loss.
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "fram_log_store.h"
+
+// the FRAM: writes are effective byte per byte, so that a power loss tears a write at any byte
+struct SimulatedFram{
+  std::vector<uint8_t> memory;
+  // bytes that can still be written before the power loss; negative for no power loss
+  long bytes_before_power_loss {-1};
+  bool powered {true};
+  unsigned long nbr_read_transactions {0};
+  unsigned long nbr_write_transactions {0};
+
+  explicit SimulatedFram(size_t const nbr_bytes): memory(nbr_bytes, 0xFF) {}
+
+  void read(uint32_t address, uint8_t * buffer, size_t nbr_bytes){
+    nbr_read_transactions++;
+    memcpy(buffer, memory.data() + address, nbr_bytes);
+  }
+
+  void write(uint32_t address, uint8_t const * buffer, size_t nbr_bytes){
+    nbr_write_transactions++;
+    for (size_t ind=0; ind<nbr_bytes; ind++){
+      if (!powered){
+        return;
+      }
+      if (bytes_before_power_loss == 0){
+        powered = false;
+        return;
+      }
+      if (bytes_before_power_loss > 0){
+        bytes_before_power_loss--;
+      }
+      memory[address + ind] = buffer[ind];
+    }
+  }
+};
+
+static constexpr uint32_t base_address {256};
+static constexpr uint32_t region_length {4096};
+static constexpr size_t batch_length {128};
+
+using Store = FramLogStore<SimulatedFram, batch_length>;
+
+static size_t record_length(uint32_t const index){
+  return 4 + (index * 7919u) % 60;
+}
+
+static void make_record(uint32_t const index, uint8_t * const record){
+  memcpy(record, &index, 4);
+  for (size_t ind=4; ind<record_length(index); ind++){
+    record[ind] = static_cast<uint8_t>(index * 31 + ind);
+  }
+}
+
+static unsigned long nbr_errors {0};
+
+// read all the records back, check them; returns the index of the last one, or -1 if none
+static long check_records(Store & store, long const min_last_index){
+  FramLogCursor cursor = store.begin();
+  uint8_t buffer[256];
+  long previous_index {-1};
+  uint32_t nbr_read {0};
+
+  while (true){
+    size_t const nbr_in_chunk = store.read(cursor, buffer, sizeof(buffer), [&](uint8_t const * data, size_t nbr_bytes){
+      uint32_t index;
+      memcpy(&index, data, 4);
+      uint8_t expected[64];
+      make_record(index, expected);
+      if ((nbr_bytes != record_length(index)) || (memcmp(data, expected, nbr_bytes) != 0)){
+        printf("ERROR: corrupt record %u\n", index);
+        nbr_errors++;
+      }
+      if ((previous_index >= 0) && (static_cast<long>(index) != previous_index + 1)){
+        printf("ERROR: record %u after %ld\n", index, previous_index);
+        nbr_errors++;
+      }
+      previous_index = index;
+      nbr_read++;
+    });
+    if (nbr_in_chunk == 0){
+      break;
+    }
+  }
+
+  if (cursor.remaining_bytes != 0){
+    printf("ERROR: %u bytes left unread\n", cursor.remaining_bytes);
+    nbr_errors++;
+  }
+  if (nbr_read != store.nbr_records()){
+    printf("ERROR: read %u records, header says %u\n", nbr_read, store.nbr_records());
+    nbr_errors++;
+  }
+  if (previous_index < min_last_index){
+    printf("ERROR: last record %ld, committed up to %ld\n", previous_index, min_last_index);
+    nbr_errors++;
+  }
+  return previous_index;
+}
+
+int main(){
+  std::mt19937 generator {7};
+
+  // nominal use, and the number of write transactions per batch
+  {
+    SimulatedFram fram(base_address + region_length);
+    Store store(fram, base_address, region_length);
+    printf("mount on a blank FRAM: %d (formatted)\n", store.mount());
+
+    uint8_t record[64];
+    uint32_t index {0};
+    for (int batch=0; batch<200; batch++){
+      for (int ind=0; ind<4; ind++, index++){
+        make_record(index, record);
+        store.append(record, record_length(index));
+      }
+      store.commit();
+    }
+    FramLogCounters const & counters = store.counters();
+    printf("appended %u, dropped %u, batches %u, header writes %u, write transactions %u (%.2f per batch)\n",
+           counters.records_appended, counters.records_dropped, counters.batches_committed, counters.header_writes,
+           counters.storage_writes, static_cast<double>(counters.storage_writes) / counters.batches_committed);
+
+    unsigned long const reads_before = fram.nbr_read_transactions;
+    check_records(store, index - 1);
+    printf("%u records (%u bytes) read back in %lu read transactions\n", store.nbr_records(), store.used_bytes(), fram.nbr_read_transactions - reads_before);
+
+    // consume half, then mount again
+    FramLogCursor cursor = store.begin();
+    uint8_t buffer[256];
+    store.read(cursor, buffer, sizeof(buffer), [](uint8_t const *, size_t){});
+    store.consume(cursor);
+    Store remounted(fram, base_address, region_length);
+    bool const mounted = remounted.mount();
+    printf("remount: %d, %u records\n", mounted, remounted.nbr_records());
+    check_records(remounted, index - 1);
+  }
+
+  // reads, appends and consumes interleaved: consume drops only the records the cursor went past, and
+  // refuses a cursor on records dropped since
+  {
+    SimulatedFram fram(base_address + region_length);
+    Store store(fram, base_address, region_length);
+    store.mount();
+
+    uint8_t record[64];
+    uint32_t index {0};
+    for (; index<5; index++){
+      make_record(index, record);
+      store.append(record, record_length(index));
+    }
+    store.commit();
+
+    FramLogCursor cursor = store.begin();
+    uint8_t buffer[256];
+    size_t nbr_read {0};
+    while (true){
+      size_t const nbr_in_chunk = store.read(cursor, buffer, sizeof(buffer), [](uint8_t const *, size_t){});
+      if (nbr_in_chunk == 0){
+        break;
+      }
+      nbr_read += nbr_in_chunk;
+    }
+
+    for (; index<8; index++){
+      make_record(index, record);
+      store.append(record, record_length(index));
+    }
+    store.commit();
+
+    bool const consumed = store.consume(cursor);
+    long first_index {-1};
+    FramLogCursor check_cursor = store.begin();
+    store.read(check_cursor, buffer, sizeof(buffer), [&](uint8_t const * data, size_t){
+      if (first_index < 0){
+        uint32_t crrt_index;
+        memcpy(&crrt_index, data, 4);
+        first_index = crrt_index;
+      }
+    });
+    printf("interleaved: read %zu, consumed %d, left %u records from %ld\n", nbr_read, consumed, store.nbr_records(), first_index);
+    if ((nbr_read != 5) || !consumed || (store.nbr_records() != 3) || (first_index != 5)){
+      printf("ERROR: consume dropped records committed after the cursor was taken\n");
+      nbr_errors++;
+    }
+    check_records(store, index - 1);
+
+    // a cursor overtaken by the records dropped to make space
+    FramLogCursor stale_cursor = store.begin();
+    store.read(stale_cursor, buffer, 16, [](uint8_t const *, size_t){});
+    while (store.counters().records_dropped == 0){
+      make_record(index, record);
+      store.append(record, record_length(index));
+      index++;
+    }
+    store.commit();
+    uint32_t const nbr_before = store.nbr_records();
+    bool const stale_consumed = store.consume(stale_cursor);
+    size_t const stale_read = store.read(stale_cursor, buffer, sizeof(buffer), [](uint8_t const *, size_t){});
+    printf("stale cursor: consumed %d, read %zu, %u records kept of %u\n", stale_consumed, stale_read, store.nbr_records(), nbr_before);
+    if (stale_consumed || (stale_read != 0) || (store.nbr_records() != nbr_before)){
+      printf("ERROR: a stale cursor was used\n");
+      nbr_errors++;
+    }
+    check_records(store, index - 1);
+  }
+
+  // power losses at random points
+  {
+    SimulatedFram fram(base_address + region_length);
+    uint32_t next_index {0};
+    long last_committed {-1};
+    int nbr_power_losses {0};
+
+    for (int cycle=0; cycle<2000; cycle++){
+      Store store(fram, base_address, region_length);
+      store.mount();
+      long const last_recovered = check_records(store, last_committed);
+      if (last_recovered >= 0){
+        next_index = static_cast<uint32_t>(last_recovered) + 1;
+        last_committed = last_recovered;
+      }
+
+      fram.powered = true;
+      fram.bytes_before_power_loss = generator() % 2000;
+
+      uint8_t record[64];
+      while (fram.powered){
+        make_record(next_index, record);
+        store.append(record, record_length(next_index));
+        next_index++;
+        if (generator() % 3 == 0){
+          uint32_t const writes_before = store.counters().header_writes;
+          store.commit();
+          // fully committed only if the last header write went through
+          if (fram.powered && (fram.bytes_before_power_loss != 0) && (store.counters().header_writes != writes_before)){
+            last_committed = next_index - 1;
+          }
+        }
+        if ((generator() % 50 == 0) && fram.powered){
+          FramLogCursor cursor = store.begin();
+          uint8_t buffer[128];
+          store.read(cursor, buffer, sizeof(buffer), [](uint8_t const *, size_t){});
+          store.consume(cursor);
+        }
+      }
+      nbr_power_losses++;
+    }
+    printf("%d power losses, last committed record %ld\n", nbr_power_losses, last_committed);
+  }
+
+  printf("%lu errors\n", nbr_errors);
+  return (nbr_errors == 0) ? 0 : 1;
+}
@@ -0,0 +1,231 @@
+#ifndef FRAM_CAPACITY_H
+#define FRAM_CAPACITY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <kiss_crc.h>
+
+// capacity detection of a SPI FRAM. The FRAMs ignore the address bits above their size, so that an
+// address at or beyond the capacity aliases (wraps to) the same address modulo the capacity; the
+// capacities are powers of 2. Rather than probing every 256 bytes until the wrap, the smallest power
+// of 2 that wraps is found by a binary search over the exponents, i.e. in O(log log size) probes of a
+// few transactions each.
+//
+// the probes only write in the first 4 bytes of the metadata record (the probe slot, at
+// metadata_address), so that they never touch the data around, for example a log after the
+// metadata: a probe of the power of 2 p saves the 4 bytes of the slot, reads the 4 bytes at
+// metadata_address + p, writes their complement in the slot, and p wraps (p is at or beyond the
+// capacity) if they then read as this marker; the slot is then restored. Away from the slot, the
+// probes only read. A power loss in the middle of a probe may leave the marker in the slot, which
+// then invalidates the metadata record (its magic), and the capacity is searched again at the next
+// boot. A FRAM that does not wrap is seen as the largest addressable capacity.
+//
+// optionally, a capacity read from the device ID register (RDID) is used as a first guess, which
+// then only needs 2 probes to confirm. The result is cached in a small metadata record in the FRAM
+// (magic, version, address size, capacity, CRC16), checked with the same 2 probes at the next boots.
+//
+// the storage is a template parameter, with the same interface as for the log store:
+//   void read(uint32_t address, uint8_t * buffer, size_t nbr_bytes);
+//   void write(uint32_t address, uint8_t const * buffer, size_t nbr_bytes);
+// see extras/fram_capacity_sim.cpp for a simulation on a computer.
+
+constexpr size_t fram_capacity_metadata_length {12};
+// the smallest capacity considered, 256 bytes
+constexpr uint8_t fram_capacity_min_exponent {8};
+
+enum class FramCapacitySource : uint8_t {
+  none,         // no FRAM answering
+  cache,        // the metadata record, confirmed by probes
+  device_id,    // the device ID, confirmed by probes
+  search,       // the binary search
+};
+
+struct FramCapacityResult{
+  uint32_t capacity;
+  FramCapacitySource source;
+  uint8_t nbr_probes;
+  // read and write transactions, including for the metadata
+  uint16_t nbr_transactions;
+};
+
+// the capacity from the device ID, as returned by Adafruit_FRAM_SPI::getDeviceID, or 0 if not
+// known: for the Fujitsu FRAMs (manufacturer 0x04), the 5 low bits of the first product ID byte are
+// the density code, and the capacity is 2^(10 + density) bytes (0x01: 16 kbit, ..., 0x09: 4 Mbit)
+inline uint32_t fram_capacity_from_device_id(uint8_t const manufacturer_id, uint16_t const product_id){
+  uint8_t const density = (product_id >> 8) & 0x1F;
+  if ((manufacturer_id != 0x04) || (density == 0) || (density > 14)){
+    return 0;
+  }
+  return static_cast<uint32_t>(1) << (10 + density);
+}
+
+//--------------------------------------------------------------------------------
+template <typename Storage>
+class FramCapacityDetector{
+  public:
+    // the fram_capacity_metadata_length bytes at metadata_address, also used as the probe slot, must
+    // be reserved for the detector, below the smallest capacity to detect
+    FramCapacityDetector(Storage & storage, uint32_t const metadata_address):
+      storage(storage), metadata_address(metadata_address)
+    {}
+
+    // the capacity of a FRAM with address_size address bytes (2 to 4): from the cache if it is
+    // valid for this address size and confirmed by probes, else from device_id_capacity (0 if not
+    // known) if confirmed by probes, else from the binary search; the metadata is then updated.
+    FramCapacityResult detect(uint8_t const address_size, uint32_t const device_id_capacity=0){
+      crrt_result = FramCapacityResult{0, FramCapacitySource::none, 0, 0};
+
+      // the largest capacity addressable; above 2^31 is not considered
+      max_exponent = (address_size >= 4) ? 31 : static_cast<uint8_t>(8 * address_size);
+
+      uint32_t cached_capacity {0};
+      if (load_metadata(address_size, cached_capacity) && confirm(cached_capacity)){
+        crrt_result.capacity = cached_capacity;
+        crrt_result.source = FramCapacitySource::cache;
+        return crrt_result;
+      }
+
+      if ((device_id_capacity != 0) && confirm(device_id_capacity)){
+        crrt_result.capacity = device_id_capacity;
+        crrt_result.source = FramCapacitySource::device_id;
+      }
+      else{
+        crrt_result.capacity = search();
+        crrt_result.source = (crrt_result.capacity != 0) ? FramCapacitySource::search : FramCapacitySource::none;
+      }
+
+      if (crrt_result.capacity != 0){
+        store_metadata(address_size, crrt_result.capacity);
+      }
+      return crrt_result;
+    }
+
+  private:
+    static constexpr uint8_t magic[4] {'F', 'C', 'A', 'P'};
+    static constexpr uint8_t metadata_version {1};
+
+    void read(uint32_t const address, uint8_t * const buffer, size_t const nbr_bytes){
+      storage.read(address, buffer, nbr_bytes);
+      crrt_result.nbr_transactions++;
+    }
+
+    void write(uint32_t const address, uint8_t const * const buffer, size_t const nbr_bytes){
+      storage.write(address, buffer, nbr_bytes);
+      crrt_result.nbr_transactions++;
+    }
+
+    // true if the power of 2 p is at or beyond the capacity, i.e. metadata_address + p wraps to
+    // the probe slot
+    bool beyond_capacity(uint32_t const p){
+      crrt_result.nbr_probes++;
+
+      uint8_t backup_slot[4];
+      uint8_t backup_address[4];
+      read(metadata_address, backup_slot, 4);
+      read(metadata_address + p, backup_address, 4);
+
+      uint8_t marker[4];
+      for (size_t ind=0; ind<4; ind++){
+        marker[ind] = static_cast<uint8_t>(~backup_address[ind]);
+      }
+      uint8_t check[4];
+
+      write(metadata_address, marker, 4);
+      read(metadata_address + p, check, 4);
+      write(metadata_address, backup_slot, 4);
+      return memcmp(check, marker, 4) == 0;
+    }
+
+    // write the complement of the 4 bytes backup at address, read them back, and restore them
+    bool holds_data(uint32_t const address, uint8_t const backup[4]){
+      uint8_t marker[4];
+      for (size_t ind=0; ind<4; ind++){
+        marker[ind] = static_cast<uint8_t>(~backup[ind]);
+      }
+      uint8_t check[4];
+
+      write(address, marker, 4);
+      read(address, check, 4);
+      write(address, backup, 4);
+      return memcmp(check, marker, 4) == 0;
+    }
+
+    // capacity is the capacity if it wraps, and half of it does not
+    bool confirm(uint32_t const capacity){
+      if ((capacity < (static_cast<uint32_t>(1) << fram_capacity_min_exponent)) || ((capacity & (capacity - 1)) != 0) ||
+          (capacity > (static_cast<uint32_t>(1) << max_exponent))){
+        return false;
+      }
+
+      // the largest addressable capacity cannot wrap: only check that half of it does not
+      bool const wraps = (capacity == (static_cast<uint32_t>(1) << max_exponent)) || beyond_capacity(capacity);
+      return wraps && ((capacity == (static_cast<uint32_t>(1) << fram_capacity_min_exponent)) || !beyond_capacity(capacity / 2));
+    }
+
+    // the smallest power of 2 beyond the capacity, by binary search on the exponent; if none is,
+    // the largest addressable capacity. 0 if even the probe slot does not hold data.
+    uint32_t search(void){
+      uint8_t backup_slot[4];
+      read(metadata_address, backup_slot, 4);
+      if (!holds_data(metadata_address, backup_slot)){
+        return 0;
+      }
+
+      uint8_t low = fram_capacity_min_exponent;
+      uint8_t high = max_exponent;
+
+      while (low < high){
+        uint8_t const middle = static_cast<uint8_t>((low + high) / 2);
+        if (beyond_capacity(static_cast<uint32_t>(1) << middle)){
+          high = middle;
+        }
+        else{
+          low = middle + 1;
+        }
+      }
+
+      return static_cast<uint32_t>(1) << low;
+    }
+
+    bool load_metadata(uint8_t const address_size, uint32_t & capacity){
+      uint8_t image[fram_capacity_metadata_length];
+      read(metadata_address, image, fram_capacity_metadata_length);
+
+      uint16_t const crc = static_cast<uint16_t>(image[10] | (image[11] << 8));
+      if ((memcmp(image, magic, 4) != 0) || (image[4] != metadata_version) || (image[5] != address_size) ||
+          (kiss_crc::crc16_ccitt(image, 10) != crc)){
+        return false;
+      }
+
+      capacity = static_cast<uint32_t>(image[6]) | (static_cast<uint32_t>(image[7]) << 8) |
+                 (static_cast<uint32_t>(image[8]) << 16) | (static_cast<uint32_t>(image[9]) << 24);
+      return true;
+    }
+
+    void store_metadata(uint8_t const address_size, uint32_t const capacity){
+      uint8_t image[fram_capacity_metadata_length];
+      memcpy(image, magic, 4);
+      image[4] = metadata_version;
+      image[5] = address_size;
+      for (int ind=0; ind<4; ind++){
+        image[6 + ind] = static_cast<uint8_t>(capacity >> (8 * ind));
+      }
+      uint16_t const crc = kiss_crc::crc16_ccitt(image, 10);
+      image[10] = static_cast<uint8_t>(crc & 0xFF);
+      image[11] = static_cast<uint8_t>(crc >> 8);
+
+      write(metadata_address, image, fram_capacity_metadata_length);
+    }
+
+    Storage & storage;
+    uint32_t const metadata_address;
+    uint8_t max_exponent {16};
+    FramCapacityResult crrt_result {0, FramCapacitySource::none, 0, 0};
+};
+
+template <typename Storage>
+constexpr uint8_t FramCapacityDetector<Storage>::magic[4];
+
+#endif
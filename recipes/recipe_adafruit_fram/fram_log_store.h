@@ -0,0 +1,389 @@
+#ifndef FRAM_LOG_STORE_H
+#define FRAM_LOG_STORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <kiss_crc.h>
+
+// log structured ring store on a FRAM (or any byte addressable non volatile memory): variable
+// length records are appended at the tail of a ring, and when the ring is full the oldest records
+// are dropped. The records are staged in RAM and written per batch, each batch in a single multi
+// byte write (two when the batch wraps around the end of the ring), rather than byte per byte.
+//
+// layout of the region [base_address, base_address + region_length):
+//   header slot A (32 bytes) | header slot B (32 bytes) | data ring
+// a record in the ring is its length (uint16 LE) followed by its bytes. A header is:
+//   magic "FLOG" | version | 3 reserved | sequence | head | used | nbr_records | region_length | CRC32
+// (uint32 LE), where head is the offset of the oldest record in the ring and used the number of
+// bytes of the committed records.
+//
+// power loss safe commit: the records of a batch are written after the committed tail first, and
+// only then a new header, with the next sequence number, into the header slot not holding the
+// current one. Until the new header is completely written, the previous one (in the other slot) is
+// still valid, so that a power loss at any point loses at most the batch being committed. When a
+// batch overwrites the oldest records, a header dropping them is committed before they are
+// overwritten. At mount, the valid header (magic, CRC, fields in range) with the latest sequence is
+// used.
+//
+// the storage is a template parameter, with the same interface as for the DS18B20 topology cache:
+//   void read(uint32_t address, uint8_t * buffer, size_t nbr_bytes);
+//   void write(uint32_t address, uint8_t const * buffer, size_t nbr_bytes);
+// with one writeEnable and one SPI transaction per call on the FRAM; this also allows to simulate
+// the FRAM on a computer, see extras/fram_log_store_sim.cpp.
+
+constexpr size_t fram_log_header_length {32};
+constexpr size_t fram_log_record_overhead {2};
+
+struct FramLogCounters{
+  uint32_t records_appended {0};
+  // records dropped from the ring to make space for new ones
+  uint32_t records_dropped {0};
+  uint32_t batches_committed {0};
+  uint32_t header_writes {0};
+  // calls to Storage::write, i.e. SPI write transactions
+  uint32_t storage_writes {0};
+  // record lengths found inconsistent with the header (corrupted memory); the records from there on
+  // are dropped
+  uint32_t corruptions {0};
+};
+
+// position in the committed records, to read them in order; position counts the bytes from the
+// head at mount (free running, with wrap around), so that a cursor overtaken by the head, i.e. on
+// records dropped since, is detected
+struct FramLogCursor{
+  uint32_t offset;
+  uint32_t remaining_bytes;
+  uint32_t position;
+};
+
+//--------------------------------------------------------------------------------
+// batch_length is the RAM staging buffer, i.e. the largest batch written at once; a record is at
+// most batch_length - 2 bytes
+template <typename Storage, size_t batch_length=256>
+class FramLogStore{
+  static_assert(batch_length > fram_log_record_overhead, "the batch must hold at least one record");
+  static_assert(batch_length - fram_log_record_overhead <= UINT16_MAX, "the record length is a uint16");
+
+  public:
+    FramLogStore(Storage & storage, uint32_t const base_address, uint32_t const region_length):
+      storage(storage),
+      base_address(base_address),
+      region_length(region_length),
+      data_address(base_address + 2 * fram_log_header_length),
+      data_length((region_length > 2 * fram_log_header_length) ? region_length - 2 * fram_log_header_length : 0)
+    {}
+
+    // load the latest valid header; if there is none, format the region. Returns false if the
+    // region was formatted (or is too small to hold a batch).
+    bool mount(void){
+      if (data_length < batch_length){
+        return false;
+      }
+
+      Header header_a;
+      Header header_b;
+      bool const valid_a = read_header(0, header_a);
+      bool const valid_b = read_header(1, header_b);
+
+      if (!valid_a && !valid_b){
+        format();
+        return false;
+      }
+
+      head_position = 0;
+      if (valid_a && (!valid_b || static_cast<int32_t>(header_a.sequence - header_b.sequence) > 0)){
+        committed = header_a;
+        committed_slot = 0;
+      }
+      else{
+        committed = header_b;
+        committed_slot = 1;
+      }
+
+      batch_bytes = 0;
+      batch_records = 0;
+      return true;
+    }
+
+    // drop all the records; both header slots are written, so that no older header can come back
+    void format(void){
+      committed = Header{0, 0, 0, 0};
+      head_position = 0;
+      batch_bytes = 0;
+      batch_records = 0;
+
+      write_header(1, committed);
+      committed.sequence = 1;
+      write_header(0, committed);
+      committed_slot = 0;
+    }
+
+    // stage a record; the current batch is committed first if the record does not fit in it.
+    // Returns false if the record is longer than batch_length - 2 bytes.
+    bool append(uint8_t const * const record, size_t const nbr_bytes){
+      if (nbr_bytes + fram_log_record_overhead > batch_length){
+        return false;
+      }
+
+      if (batch_bytes + fram_log_record_overhead + nbr_bytes > batch_length){
+        commit();
+      }
+
+      batch[batch_bytes++] = static_cast<uint8_t>(nbr_bytes & 0xFF);
+      batch[batch_bytes++] = static_cast<uint8_t>(nbr_bytes >> 8);
+      memcpy(batch + batch_bytes, record, nbr_bytes);
+      batch_bytes += nbr_bytes;
+      batch_records++;
+      crrt_counters.records_appended++;
+      return true;
+    }
+
+    // write the staged records and commit them; nothing is written if no record is staged
+    void commit(void){
+      if (batch_records == 0){
+        return;
+      }
+
+      // make space by dropping the oldest records, and commit that before overwriting them
+      if (committed.used + batch_bytes > data_length){
+        while (committed.used + batch_bytes > data_length){
+          uint32_t const record_bytes = stored_record_bytes(committed.head, committed.used);
+          if (record_bytes == 0){
+            drop_corrupt_records(committed.head);
+            break;
+          }
+          committed.head = wrap(committed.head + record_bytes);
+          committed.used -= record_bytes;
+          committed.nbr_records--;
+          head_position += record_bytes;
+          crrt_counters.records_dropped++;
+        }
+        commit_header();
+      }
+
+      write_data(wrap(committed.head + committed.used), batch, batch_bytes);
+
+      committed.used += batch_bytes;
+      committed.nbr_records += batch_records;
+      commit_header();
+
+      batch_bytes = 0;
+      batch_records = 0;
+      crrt_counters.batches_committed++;
+    }
+
+    // the committed records (the staged ones are not included)
+    uint32_t nbr_records(void) const{
+      return committed.nbr_records;
+    }
+
+    uint32_t used_bytes(void) const{
+      return committed.used;
+    }
+
+    // the size of the ring, including the 2 bytes of length of each record
+    uint32_t capacity(void) const{
+      return data_length;
+    }
+
+    // a cursor on the oldest committed record; it covers the records committed until now
+    FramLogCursor begin(void) const{
+      return FramLogCursor{committed.head, committed.used, head_position};
+    }
+
+    // sequential bulk read: read the bytes after cursor in a single read of up to buffer_length bytes
+    // (two when wrapping), and call on_record(uint8_t const * data, size_t nbr_bytes) for each whole
+    // record in them; the cursor is moved past these. Returns the number of records read, 0 at the
+    // end, if buffer_length is shorter than the next record, or if the records at cursor were dropped
+    // since (by commit making space, or by consume with another cursor).
+    template <typename RecordFunction>
+    size_t read(FramLogCursor & cursor, uint8_t * const buffer, size_t const buffer_length, RecordFunction && on_record){
+      if (static_cast<int32_t>(cursor.position - head_position) < 0){
+        return 0;
+      }
+
+      size_t const nbr_bytes = (cursor.remaining_bytes < buffer_length) ? cursor.remaining_bytes : buffer_length;
+      read_data(cursor.offset, buffer, nbr_bytes);
+
+      size_t position {0};
+      size_t nbr_read {0};
+      while (position + fram_log_record_overhead <= nbr_bytes){
+        size_t const record_bytes = buffer[position] | (static_cast<size_t>(buffer[position + 1]) << 8);
+        if (position + fram_log_record_overhead + record_bytes > nbr_bytes){
+          break;
+        }
+        on_record(buffer + position + fram_log_record_overhead, record_bytes);
+        position += fram_log_record_overhead + record_bytes;
+        nbr_read++;
+      }
+
+      cursor.offset = wrap(cursor.offset + position);
+      cursor.remaining_bytes -= position;
+      cursor.position += position;
+      return nbr_read;
+    }
+
+    // drop the committed records before cursor, e.g. once they were sent, and commit; the records
+    // committed after the cursor was taken are kept. Returns false, and drops nothing, if the cursor
+    // is before the oldest record, i.e. some of the records it went past were dropped since.
+    bool consume(FramLogCursor const & cursor){
+      uint32_t const consumed_bytes = cursor.position - head_position;
+      if ((static_cast<int32_t>(consumed_bytes) < 0) || (consumed_bytes > committed.used)){
+        return false;
+      }
+      if (consumed_bytes == 0){
+        return true;
+      }
+
+      // count the records dropped, from their lengths
+      uint32_t offset = committed.head;
+      uint32_t remaining = consumed_bytes;
+      while (remaining > 0){
+        uint32_t const record_bytes = stored_record_bytes(offset, remaining);
+        if (record_bytes == 0){
+          drop_corrupt_records(offset);
+          return true;
+        }
+        offset = wrap(offset + record_bytes);
+        remaining -= record_bytes;
+        committed.nbr_records--;
+      }
+
+      committed.head = offset;
+      committed.used -= consumed_bytes;
+      head_position += consumed_bytes;
+      commit_header();
+      return true;
+    }
+
+    FramLogCounters const & counters(void) const{
+      return crrt_counters;
+    }
+
+  private:
+    static constexpr uint8_t magic[4] {'F', 'L', 'O', 'G'};
+    static constexpr uint8_t header_version {1};
+
+    struct Header{
+      uint32_t sequence;
+      uint32_t head;
+      uint32_t used;
+      uint32_t nbr_records;
+    };
+
+    uint32_t wrap(uint32_t const offset) const{
+      return (offset >= data_length) ? offset - data_length : offset;
+    }
+
+    static void put_uint32(uint8_t * const buffer, uint32_t const value){
+      for (int ind=0; ind<4; ind++){
+        buffer[ind] = static_cast<uint8_t>(value >> (8 * ind));
+      }
+    }
+
+    static uint32_t get_uint32(uint8_t const * const buffer){
+      return static_cast<uint32_t>(buffer[0]) | (static_cast<uint32_t>(buffer[1]) << 8) |
+             (static_cast<uint32_t>(buffer[2]) << 16) | (static_cast<uint32_t>(buffer[3]) << 24);
+    }
+
+    void write_header(size_t const slot, Header const & header){
+      uint8_t image[fram_log_header_length] {};
+      memcpy(image, magic, 4);
+      image[4] = header_version;
+      put_uint32(image + 8, header.sequence);
+      put_uint32(image + 12, header.head);
+      put_uint32(image + 16, header.used);
+      put_uint32(image + 20, header.nbr_records);
+      put_uint32(image + 24, region_length);
+      put_uint32(image + 28, kiss_crc::crc32(image, 28));
+
+      storage.write(base_address + slot * fram_log_header_length, image, fram_log_header_length);
+      crrt_counters.storage_writes++;
+      crrt_counters.header_writes++;
+    }
+
+    bool read_header(size_t const slot, Header & header){
+      uint8_t image[fram_log_header_length];
+      storage.read(base_address + slot * fram_log_header_length, image, fram_log_header_length);
+
+      if ((memcmp(image, magic, 4) != 0) || (image[4] != header_version) ||
+          (get_uint32(image + 28) != kiss_crc::crc32(image, 28)) || (get_uint32(image + 24) != region_length)){
+        return false;
+      }
+
+      header.sequence = get_uint32(image + 8);
+      header.head = get_uint32(image + 12);
+      header.used = get_uint32(image + 16);
+      header.nbr_records = get_uint32(image + 20);
+      return (header.head < data_length) && (header.used <= data_length);
+    }
+
+    // the length, including the overhead, of the record stored at offset, or 0 if it is longer than
+    // the remaining_bytes of committed records from there (corrupted memory)
+    uint32_t stored_record_bytes(uint32_t const offset, uint32_t const remaining_bytes){
+      uint8_t length_bytes[fram_log_record_overhead];
+      read_data(offset, length_bytes, fram_log_record_overhead);
+      uint32_t const record_bytes = fram_log_record_overhead + (length_bytes[0] | (static_cast<uint32_t>(length_bytes[1]) << 8));
+      return (record_bytes <= remaining_bytes) ? record_bytes : 0;
+    }
+
+    // drop the records from offset on, and commit; the next records start over from offset
+    void drop_corrupt_records(uint32_t const offset){
+      crrt_counters.corruptions++;
+      // the cursors on the records dropped are invalid from now on
+      head_position += committed.used;
+      committed.head = offset;
+      committed.used = 0;
+      committed.nbr_records = 0;
+      commit_header();
+    }
+
+    // the next header into the other slot, so that the current one stays valid until it is written
+    void commit_header(void){
+      committed.sequence++;
+      committed_slot = 1 - committed_slot;
+      write_header(committed_slot, committed);
+    }
+
+    void read_data(uint32_t const offset, uint8_t * const buffer, size_t const nbr_bytes){
+      size_t const first_part = (nbr_bytes < data_length - offset) ? nbr_bytes : data_length - offset;
+      storage.read(data_address + offset, buffer, first_part);
+      if (nbr_bytes > first_part){
+        storage.read(data_address, buffer + first_part, nbr_bytes - first_part);
+      }
+    }
+
+    void write_data(uint32_t const offset, uint8_t const * const buffer, size_t const nbr_bytes){
+      size_t const first_part = (nbr_bytes < data_length - offset) ? nbr_bytes : data_length - offset;
+      storage.write(data_address + offset, buffer, first_part);
+      crrt_counters.storage_writes++;
+      if (nbr_bytes > first_part){
+        storage.write(data_address, buffer + first_part, nbr_bytes - first_part);
+        crrt_counters.storage_writes++;
+      }
+    }
+
+    Storage & storage;
+    uint32_t const base_address;
+    uint32_t const region_length;
+    uint32_t const data_address;
+    uint32_t const data_length;
+
+    Header committed {0, 0, 0, 0};
+    size_t committed_slot {0};
+    // the position of the head, see FramLogCursor
+    uint32_t head_position {0};
+
+    uint8_t batch[batch_length];
+    size_t batch_bytes {0};
+    size_t batch_records {0};
+
+    FramLogCounters crrt_counters {};
+};
+
+template <typename Storage, size_t batch_length>
+constexpr uint8_t FramLogStore<Storage, batch_length>::magic[4];
+
+#endif
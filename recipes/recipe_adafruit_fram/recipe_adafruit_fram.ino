@@ -1,6 +1,8 @@
 #include "Arduino.h"
 #include <SPI.h>
 #include "Adafruit_FRAM_SPI.h"
+#include "fram_log_store.h"
+#include "fram_capacity.h"
 
 // ---------------------------------------------------------------------------------
 
@@ -9,6 +11,11 @@
 see the readme.
 - heavily inspired from the examples for using SPI (from Sparkfun) and the example
 for using FRAM (from Adafruit).
+- the FRAM is accessed in bulk: one SPI transaction (and one writeEnable) per multi byte read / write,
+rather than per byte; after the first kB, it holds a log structured ring store of records, see
+fram_log_store.h (uses the kiss_crc library, under libraries).
+- the capacity is found by a binary search on the address wrap, optionally starting from the device
+ID, and cached in the FRAM, see fram_capacity.h.
 */
 
 // ---------------------------------------------------------------------------------
@@ -18,6 +25,10 @@ for using FRAM (from Adafruit).
 #define SPI_ORDER MSBFIRST
 #define SPI_MODE SPI_MODE0
 
+// set to 1 to use the capacity given by the device ID register as a first guess (Fujitsu FRAMs);
+// it is always confirmed by probing the memory
+#define USE_DEVICE_ID 1
+
 SPIClass my_spi(0); //This is default and automatically defined on RedBoard/ATP/Nano. Access using pins labeled SCK/MISO/MOSI (connects to pads 5/6/7 on module).
 // SPIClass my_spi(1); //Use IO Master 1 on pads 8/9/10. See schematic of your board for pin locations.
 // SPIClass mySPI(2); //Use IO Master 2 on pads 27/25/28
@@ -33,6 +44,45 @@ Adafruit_FRAM_SPI fram = Adafruit_FRAM_SPI(CS_PIN, &my_spi);
 uint8_t           addrSizeInBytes = 2; //Default to address size of two bytes
 uint32_t          memSize;
 
+// the storage interface of FramLogStore and FramCapacityDetector on top of the FRAM: one writeEnable
+// and one SPI transaction per call
+struct FramStorage{
+  void read(uint32_t address, uint8_t * buffer, size_t nbr_bytes){
+    fram.read(address, buffer, nbr_bytes);
+  }
+
+  void write(uint32_t address, uint8_t const * buffer, size_t nbr_bytes){
+    fram.writeEnable(true);
+    fram.write(address, const_cast<uint8_t *>(buffer), nbr_bytes);
+    fram.writeEnable(false);
+  }
+};
+
+FramStorage fram_storage;
+
+// the capacity found is cached in the last bytes of the first kB, which the capacity probes also use
+// as their only write location: the log after it is never written by the probes
+constexpr uint32_t capacity_metadata_address {0x3F0};
+FramCapacityDetector<FramStorage> capacity_detector(fram_storage, capacity_metadata_address);
+
+// the log store, after the first kB, over the rest of the FRAM once its size is known
+constexpr uint32_t log_base_address {0x400};
+FramLogStore<FramStorage, 256> * log_store {nullptr};
+
+// a record of the example log; committed to the FRAM every records_per_commit records
+struct __attribute__((packed)) LogRecord{
+  uint32_t boot;
+  uint32_t millis;
+  uint32_t index;
+};
+
+constexpr uint32_t records_per_commit {10};
+constexpr unsigned long log_period_ms {100};
+uint8_t boot_count {0};
+uint32_t log_index {0};
+unsigned long millis_last_log {0};
+unsigned long millis_last_stats {0};
+
 int32_t readBack(uint32_t addr, int32_t data) {
   int32_t check = !data;
   int32_t wrapCheck, backup;
@@ -86,13 +136,36 @@ void setup(){
     while (1);
   }
   
-  memSize = 256;
-  Serial.println(F("check how many blocks are available, this may take a few secs"));
-  while (readBack(memSize, memSize) == memSize) {
-    memSize += 256;
-    // Serial.print("Block: #"); Serial.println(memSize/256);  // disable the printing, as this is many lines...
+  uint32_t device_id_capacity {0};
+#if USE_DEVICE_ID
+  uint8_t manufacturer_id;
+  uint16_t product_id;
+  fram.getDeviceID(&manufacturer_id, &product_id);
+  device_id_capacity = fram_capacity_from_device_id(manufacturer_id, product_id);
+  Serial.print(F("device ID: manufacturer 0x")); Serial.print(manufacturer_id, HEX);
+  Serial.print(F(", product 0x")); Serial.print(product_id, HEX);
+  Serial.print(F(", capacity ")); Serial.println(device_id_capacity);
+#endif
+
+  // a few probes rather than one every 256 bytes
+  unsigned long const micros_start = micros();
+  FramCapacityResult const capacity = capacity_detector.detect(addrSizeInBytes, device_id_capacity);
+  unsigned long const micros_capacity = micros() - micros_start;
+  if (capacity.source == FramCapacitySource::none) {
+    Serial.println("SPI FRAM capacity could not be found\r\n");
+    while (1);
   }
-  
+  memSize = capacity.capacity;
+
+  Serial.print(F("capacity from "));
+  switch (capacity.source) {
+    case FramCapacitySource::cache: Serial.print(F("cache")); break;
+    case FramCapacitySource::device_id: Serial.print(F("device ID")); break;
+    default: Serial.print(F("search")); break;
+  }
+  Serial.print(F(", ")); Serial.print(capacity.nbr_probes); Serial.print(F(" probes, "));
+  Serial.print(capacity.nbr_transactions); Serial.print(F(" transactions, ")); Serial.print(micros_capacity); Serial.println(F(" us"));
+
   Serial.print("SPI FRAM address size is ");
   Serial.print(addrSizeInBytes);
   Serial.println(" bytes.");
@@ -112,26 +185,101 @@ void setup(){
   fram.writeEnable(true);
   fram.write8(0x0, test+1);
   fram.writeEnable(false);
+  boot_count = test + 1;
 
   fram.writeEnable(true);
   fram.write(0x1, (uint8_t *)"FTW!", 5);
   fram.writeEnable(false);
 
   // dump the entire 512K of memory!
-  uint8_t value;
-  // for (uint16_t a = 0; a < 524288; a++) {  // this is a lot...
-  for (uint16_t a = 0; a < 1024; a++) {  // let us dump a bit less!
-    value = fram.read8(a);
-    if ((a % 32) == 0) {
-      Serial.print("\n 0x"); Serial.print(a, HEX); Serial.print(": ");
+  // one read of a whole row of 32 bytes per SPI transaction, rather than one per byte
+  uint8_t row[32];
+  // for (uint32_t a = 0; a < 524288; a += sizeof(row)) {  // this is a lot...
+  for (uint32_t a = 0; a < 1024; a += sizeof(row)) {  // let us dump a bit less!
+    fram.read(a, row, sizeof(row));
+    Serial.print("\n 0x"); Serial.print(a, HEX); Serial.print(": ");
+    for (uint8_t value : row) {
+      Serial.print("0x");
+      if (value < 0x10)
+        Serial.print('0');
+      Serial.print(value, HEX); Serial.print(" ");
+    }
+  }
+  Serial.println();
+
+  setup_log_store();
+}
+
+// mount the log store, and read back all the records it holds, in bulk
+void setup_log_store(void){
+  if (memSize <= log_base_address + 1024) {
+    Serial.println(F("FRAM too small for the log store"));
+    return;
+  }
+
+  static FramLogStore<FramStorage, 256> store(fram_storage, log_base_address, memSize - log_base_address);
+  log_store = &store;
+
+  if (log_store->mount()) {
+    Serial.println(F("log store mounted"));
+  } else {
+    Serial.println(F("no valid log store, formatted"));
+  }
+
+  uint8_t buffer[256];
+  uint32_t nbr_read {0};
+  LogRecord last_record {0, 0, 0};
+  FramLogCursor cursor = log_store->begin();
+  unsigned long const micros_start = micros();
+  while (log_store->read(cursor, buffer, sizeof(buffer), [&](uint8_t const * data, size_t nbr_bytes){
+    if (nbr_bytes == sizeof(LogRecord)) {
+      memcpy(&last_record, data, sizeof(LogRecord));
     }
-    Serial.print("0x"); 
-    if (value < 0x1) 
-      Serial.print('0');
-    Serial.print(value, HEX); Serial.print(" ");
+    nbr_read++;
+  }) > 0) {}
+  unsigned long const micros_read = micros() - micros_start;
+
+  Serial.print(F("read back ")); Serial.print(nbr_read); Serial.print(F(" records, ")); Serial.print(log_store->used_bytes());
+  Serial.print(F(" bytes, in ")); Serial.print(micros_read); Serial.println(F(" us"));
+  if (nbr_read > 0) {
+    Serial.print(F("last record: boot ")); Serial.print(last_record.boot); Serial.print(F(", millis ")); Serial.print(last_record.millis);
+    Serial.print(F(", index ")); Serial.println(last_record.index);
   }
 }
 
+void log_store_stats(void){
+  FramLogCounters const & counters = log_store->counters();
+  Serial.print(F("records: ")); Serial.print(log_store->nbr_records());
+  Serial.print(F(" | used: ")); Serial.print(log_store->used_bytes()); Serial.print(F(" of ")); Serial.print(log_store->capacity());
+  Serial.print(F(" | appended: ")); Serial.print(counters.records_appended);
+  Serial.print(F(" | dropped: ")); Serial.print(counters.records_dropped);
+  Serial.print(F(" | batches: ")); Serial.print(counters.batches_committed);
+  Serial.print(F(" | write transactions: ")); Serial.print(counters.storage_writes);
+  Serial.print(F(" | corruptions: ")); Serial.println(counters.corruptions);
+}
+
 void loop(){
+  if (log_store == nullptr) {
+    return;
+  }
+
+  unsigned long const crrt_millis = millis();
+
+  if (crrt_millis - millis_last_log >= log_period_ms) {
+    millis_last_log = crrt_millis;
+
+    LogRecord const record {boot_count, static_cast<uint32_t>(crrt_millis), log_index++};
+    log_store->append(reinterpret_cast<uint8_t const *>(&record), sizeof(record));
 
+    // the records are only written to the FRAM, all at once, at the commit; a power loss loses at
+    // most the records appended since the last commit
+    if (log_index % records_per_commit == 0) {
+      log_store->commit();
+    }
+  }
+
+  if (crrt_millis - millis_last_stats >= 10000) {
+    millis_last_stats = crrt_millis;
+    log_store_stats();
+  }
 }
@@ -0,0 +1,184 @@
+#ifndef DRDY_ACQUISITION_H
+#define DRDY_ACQUISITION_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// interrupt driven sensor acquisition: the data ready (DRDY) interrupt of each sensor only takes a
+// micros() timestamp and queues a read request; a worker, in the loop, drains the requests and
+// performs the (slow, I2C) reads. The timestamp of each sample is then the time of the DRDY edge,
+// to a few us, rather than the time at which the loop got around to reading it.
+//
+// the DRDY lines are levels, which stay high until the data is read: an edge that happens before
+// the interrupt is attached, or while the line is still high from a previous sample, never comes.
+// The worker therefore also checks the level of the lines after draining, and calls on_level for
+// the ones still high, so that a request is never lost to a missing edge.
+//
+// the data registers of a sensor only hold its latest sample: a sample is captured as long as the
+// worker reads it within one sample period of its DRDY, and otherwise counted as missed in the
+// counters (for the accel / gyro, the FIFO of the ISM330DHCX holds the samples instead, so none is
+// lost).
+//
+// this does not depend on Arduino, so that it can be simulated on a computer, by calling on_drdy
+// with synthetic timestamps and giving drain a fake read function: see
+// extras/drdy_acquisition_sim.cpp.
+
+enum class DrdySource : uint8_t {
+  imu,  // accel and gyro: a single interrupt covers both (DRDY at the same data rate, or FIFO watermark)
+  mag,
+};
+
+constexpr size_t nbr_drdy_sources {2};
+
+//--------------------------------------------------------------------------------
+// lock free single producer (one DRDY interrupt) single consumer (the worker) queue of timestamps;
+// N must be a power of 2
+template <size_t N>
+class DrdyQueue{
+  static_assert((N != 0) && ((N & (N - 1)) == 0), "the queue size must be a power of 2");
+
+  public:
+    // producer side, in the interrupt; if the queue is full the request is lost and counted
+    bool push(uint32_t const timestamp_us){
+      uint32_t const crrt_head = head.load(std::memory_order_relaxed);
+      if (crrt_head - tail.load(std::memory_order_acquire) >= N){
+        nbr_overflows.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      buffer[crrt_head & mask] = timestamp_us;
+      head.store(crrt_head + 1, std::memory_order_release);
+      return true;
+    }
+
+    // consumer side
+    size_t size(void) const{
+      return head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed);
+    }
+
+    // the timestamp of the request at position offset from the oldest one; offset < size()
+    uint32_t peek(size_t const offset=0) const{
+      return buffer[(tail.load(std::memory_order_relaxed) + offset) & mask];
+    }
+
+    void consume(size_t const nbr_requests){
+      tail.store(tail.load(std::memory_order_relaxed) + nbr_requests, std::memory_order_release);
+    }
+
+    uint32_t overflows(void) const{
+      return nbr_overflows.load(std::memory_order_relaxed);
+    }
+
+  private:
+    static constexpr uint32_t mask {N - 1};
+
+    uint32_t buffer[N];
+    std::atomic<uint32_t> head {0};
+    std::atomic<uint32_t> tail {0};
+    std::atomic<uint32_t> nbr_overflows {0};
+};
+
+//--------------------------------------------------------------------------------
+struct DrdyCounters{
+  // DRDY edges seen
+  uint32_t requests {0};
+  // samples actually read
+  uint32_t samples_read {0};
+  // samples overwritten in the sensor before the worker could read them, i.e. the worker fell behind
+  uint32_t samples_missed {0};
+  // reads requested by on_level, i.e. the DRDY line was high without an edge seen
+  uint32_t level_requests {0};
+};
+
+template <size_t N>
+class DrdyAcquisition{
+  public:
+    // interrupt side: to call from the DRDY interrupt of the sensor, with micros()
+    void on_drdy(DrdySource const source, uint32_t const timestamp_us){
+      queues[static_cast<size_t>(source)].push(timestamp_us);
+    }
+
+    // worker side: the DRDY line of source was found high at timestamp_us (with digitalRead, after
+    // drain); a read is then requested as if an edge had come, unless one is already pending, in
+    // which case they are served together
+    void on_level(DrdySource const source, uint32_t const timestamp_us){
+      size_t const ind = static_cast<size_t>(source);
+      if (!level_pending[ind]){
+        level_pending[ind] = true;
+        level_timestamps[ind] = timestamp_us;
+      }
+    }
+
+    // worker side: serve all the pending requests, oldest first across the sources, calling
+    // read(DrdySource source, uint32_t timestamp_us) for each sample to read; returns the number of
+    // samples read. The data registers of the sensors only hold the latest sample, so when several
+    // requests are pending for the same source, only the latest is read, the others are counted as
+    // missed.
+    template <typename ReadFunction>
+    size_t drain(ReadFunction && read){
+      size_t nbr_samples_read {0};
+
+      while (true){
+        // the source with the oldest pending request
+        bool found {false};
+        size_t oldest_source {0};
+        uint32_t oldest_timestamp {0};
+
+        for (size_t ind=0; ind<nbr_drdy_sources; ind++){
+          if ((queues[ind].size() > 0) || level_pending[ind]){
+            uint32_t const timestamp = (queues[ind].size() > 0) ? queues[ind].peek() : level_timestamps[ind];
+            if (!found || static_cast<int32_t>(timestamp - oldest_timestamp) < 0){
+              found = true;
+              oldest_source = ind;
+              oldest_timestamp = timestamp;
+            }
+          }
+        }
+
+        if (!found){
+          break;
+        }
+
+        DrdyQueue<N> & queue = queues[oldest_source];
+        DrdyCounters & counters = crrt_counters[oldest_source];
+        size_t const nbr_pending = queue.size();
+        uint32_t latest_timestamp;
+        if (nbr_pending > 0){
+          latest_timestamp = queue.peek(nbr_pending - 1);
+          queue.consume(nbr_pending);
+          counters.requests += nbr_pending;
+          counters.samples_missed += nbr_pending - 1;
+        }
+        else{
+          latest_timestamp = level_timestamps[oldest_source];
+          counters.level_requests++;
+        }
+        level_pending[oldest_source] = false;
+        counters.samples_read++;
+        nbr_samples_read++;
+
+        read(static_cast<DrdySource>(oldest_source), latest_timestamp);
+      }
+
+      return nbr_samples_read;
+    }
+
+    DrdyCounters const & counters(DrdySource const source) const{
+      return crrt_counters[static_cast<size_t>(source)];
+    }
+
+    // requests lost because the queue was full; with N large enough, these are counted as missed
+    // samples in the counters instead
+    uint32_t queue_overflows(DrdySource const source) const{
+      return queues[static_cast<size_t>(source)].overflows();
+    }
+
+  private:
+    DrdyQueue<N> queues[nbr_drdy_sources];
+    DrdyCounters crrt_counters[nbr_drdy_sources];
+    // worker side only, see on_level
+    bool level_pending[nbr_drdy_sources] {};
+    uint32_t level_timestamps[nbr_drdy_sources] {};
+};
+
+#endif
@@ -0,0 +1,235 @@
+// drive the interrupt driven acquisition on a computer: the accel / gyro and mag DRDY edges come at
+// their data rates with some jitter, across the wrap around of micros(), a few edges are lost (as
+// before the interrupt is attached), and the worker runs every ms with now and then a long stall.
+// A reference model of the requests pending checks each drain:
+//
+//   g++ -O2 -std=c++11 -I.. drdy_acquisition_sim.cpp -o drdy_acquisition_sim
+//   ./drdy_acquisition_sim
+//
+// the sources must be served oldest first, each with the timestamp of its latest request, the
+// requests skipped counted as missed, and a sample with a lost edge must still be read thanks to the
+// level check. Returns non zero if any check fails.
+
+#include <cstdio>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <initializer_list>
+
+#include "drdy_acquisition.h"
+
+static constexpr size_t queue_size {16};
+
+static constexpr uint64_t time_start_us {0xFFF00000u};
+static constexpr uint64_t duration_us {20000000};
+static constexpr uint64_t period_us[nbr_drdy_sources] {9615, 6452};  // 104 Hz, 155 Hz
+static constexpr int64_t max_jitter_us {40};
+static constexpr uint64_t worker_period_us {1000};
+static constexpr uint64_t wrap_us {static_cast<uint64_t>(1) << 32};
+
+static unsigned long nbr_errors {0};
+
+static void expect(char const * what, bool const condition){
+  if (!condition){
+    nbr_errors++;
+    if (nbr_errors < 20){
+      printf("ERROR: %s\n", what);
+    }
+  }
+}
+
+struct Read{
+  size_t source;
+  uint32_t timestamp_us;
+};
+
+// what the acquisition should do, kept by the simulation
+struct ReferenceSource{
+  std::vector<uint32_t> pending;
+  bool level_pending {false};
+  uint32_t level_timestamp {0};
+  // the time of the last sample of the sensor, and of the last read of its data registers
+  uint64_t last_sample_us {0};
+  uint64_t last_read_us {0};
+  bool has_sample {false};
+  DrdyCounters counters;
+  uint32_t overflows {0};
+  uint32_t lost_edges {0};
+};
+
+// the oldest first order across the wrap around of micros(), one source on each side of it, with a
+// queued request and with a level request
+static void check_wrap_order(void){
+  for (size_t first=0; first<nbr_drdy_sources; first++){
+    for (bool const use_level : {false, true}){
+      DrdyAcquisition<queue_size> acquisition;
+      DrdySource const source_before = static_cast<DrdySource>(first);
+      DrdySource const source_after = static_cast<DrdySource>(1 - first);
+      acquisition.on_drdy(source_after, 0x00000100u);
+      if (use_level){
+        acquisition.on_level(source_before, 0xFFFFFF00u);
+      }
+      else{
+        acquisition.on_drdy(source_before, 0xFFFFFF00u);
+      }
+
+      std::vector<Read> reads;
+      acquisition.drain([&reads](DrdySource source, uint32_t timestamp_us){
+        reads.push_back({static_cast<size_t>(source), timestamp_us});
+      });
+      expect("across the wrap, number of reads", reads.size() == 2);
+      expect("across the wrap, oldest first", (reads.size() == 2) && (reads[0].source == first) && (reads[0].timestamp_us == 0xFFFFFF00u));
+    }
+  }
+}
+
+int main(){
+  check_wrap_order();
+
+  std::mt19937 generator {7};
+  std::uniform_int_distribution<int64_t> jitter(-max_jitter_us, max_jitter_us);
+
+  DrdyAcquisition<queue_size> acquisition;
+  ReferenceSource reference[nbr_drdy_sources];
+
+  uint64_t next_edge_us[nbr_drdy_sources];
+  for (size_t ind=0; ind<nbr_drdy_sources; ind++){
+    next_edge_us[ind] = time_start_us + 100 + 37 * ind;
+  }
+
+  unsigned long nbr_drains {0};
+  unsigned long nbr_stalls {0};
+  uint64_t now_us = time_start_us;
+
+  while (now_us < time_start_us + duration_us){
+    // the worker is late now and then: 30 ms (the requests pile up), or 150 ms (the queues overflow)
+    uint64_t worker_delay_us = worker_period_us;
+    uint32_t const draw = generator() % 1000;
+    if (draw < 4){
+      worker_delay_us = 30000;
+      nbr_stalls++;
+    }
+    else if (draw < 5){
+      worker_delay_us = 150000;
+      nbr_stalls++;
+    }
+    // and once across the wrap around of micros(), with requests on both sides of it
+    if ((now_us < wrap_us) && (now_us + worker_period_us >= wrap_us - 10000)){
+      worker_delay_us = 30000;
+      nbr_stalls++;
+    }
+    uint64_t const worker_us = now_us + worker_delay_us;
+
+    // the edges until the worker runs, in time order across the sources
+    while (true){
+      size_t source = (next_edge_us[0] <= next_edge_us[1]) ? 0 : 1;
+      uint64_t const edge_us = next_edge_us[source];
+      if (edge_us > worker_us){
+        break;
+      }
+      next_edge_us[source] = edge_us + period_us[source] + jitter(generator);
+
+      ReferenceSource & ref = reference[source];
+      ref.last_sample_us = edge_us;
+      ref.has_sample = true;
+
+      if (generator() % 300 == 0){
+        ref.lost_edges++;
+        continue;
+      }
+
+      uint32_t const timestamp = static_cast<uint32_t>(edge_us);
+      acquisition.on_drdy(static_cast<DrdySource>(source), timestamp);
+      if (ref.pending.size() >= queue_size){
+        ref.overflows++;
+      }
+      else{
+        ref.pending.push_back(timestamp);
+      }
+    }
+    now_us = worker_us;
+
+    // the expected drain: each source with a request, oldest first
+    std::vector<Read> expected_reads;
+    std::vector<std::pair<uint32_t, size_t>> oldest;
+    for (size_t ind=0; ind<nbr_drdy_sources; ind++){
+      ReferenceSource & ref = reference[ind];
+      if (!ref.pending.empty()){
+        oldest.push_back({ref.pending.front(), ind});
+      }
+      else if (ref.level_pending){
+        oldest.push_back({ref.level_timestamp, ind});
+      }
+    }
+    std::stable_sort(oldest.begin(), oldest.end(), [](std::pair<uint32_t, size_t> const & a, std::pair<uint32_t, size_t> const & b){
+      return static_cast<int32_t>(a.first - b.first) < 0;
+    });
+    for (auto const & crrt : oldest){
+      ReferenceSource & ref = reference[crrt.second];
+      if (!ref.pending.empty()){
+        expected_reads.push_back({crrt.second, ref.pending.back()});
+        ref.counters.requests += ref.pending.size();
+        ref.counters.samples_missed += ref.pending.size() - 1;
+      }
+      else{
+        expected_reads.push_back({crrt.second, ref.level_timestamp});
+        ref.counters.level_requests++;
+      }
+      ref.counters.samples_read++;
+      ref.pending.clear();
+      ref.level_pending = false;
+      ref.last_read_us = now_us;
+    }
+
+    std::vector<Read> reads;
+    size_t const nbr_read = acquisition.drain([&reads](DrdySource source, uint32_t timestamp_us){
+      reads.push_back({static_cast<size_t>(source), timestamp_us});
+    });
+    nbr_drains++;
+
+    expect("number of samples read by drain", nbr_read == reads.size());
+    expect("number of reads", reads.size() == expected_reads.size());
+    for (size_t ind=0; (ind<reads.size()) && (ind<expected_reads.size()); ind++){
+      expect("source served, oldest first", reads[ind].source == expected_reads[ind].source);
+      expect("timestamp of the latest request", reads[ind].timestamp_us == expected_reads[ind].timestamp_us);
+    }
+
+    // the level check after the drain: the DRDY line stays high while a sample is not read
+    for (size_t ind=0; ind<nbr_drdy_sources; ind++){
+      ReferenceSource & ref = reference[ind];
+      if (ref.has_sample && (ref.last_sample_us > ref.last_read_us) && ref.pending.empty()){
+        uint32_t const timestamp = static_cast<uint32_t>(now_us);
+        acquisition.on_level(static_cast<DrdySource>(ind), timestamp);
+        if (!ref.level_pending){
+          ref.level_pending = true;
+          ref.level_timestamp = timestamp;
+        }
+      }
+    }
+  }
+
+  char const * const names[nbr_drdy_sources] {"imu", "mag"};
+  for (size_t ind=0; ind<nbr_drdy_sources; ind++){
+    DrdyCounters const & counters = acquisition.counters(static_cast<DrdySource>(ind));
+    ReferenceSource const & ref = reference[ind];
+    printf("%s: requests %u, read %u, missed %u, level %u, queue overflows %u, edges lost %u\n", names[ind],
+           counters.requests, counters.samples_read, counters.samples_missed, counters.level_requests,
+           acquisition.queue_overflows(static_cast<DrdySource>(ind)), ref.lost_edges);
+
+    expect("requests", counters.requests == ref.counters.requests);
+    expect("samples read", counters.samples_read == ref.counters.samples_read);
+    expect("samples missed", counters.samples_missed == ref.counters.samples_missed);
+    expect("level requests", counters.level_requests == ref.counters.level_requests);
+    expect("queue overflows", acquisition.queue_overflows(static_cast<DrdySource>(ind)) == ref.overflows);
+    // every request is either read or counted as missed
+    expect("requests accounted", counters.samples_read + counters.samples_missed == counters.requests + counters.level_requests);
+    expect("missed samples exercised", counters.samples_missed > 0);
+    expect("level requests exercised", counters.level_requests > 0);
+  }
+  expect("queue overflows exercised", acquisition.queue_overflows(DrdySource::mag) > 0);
+
+  printf("%lu drains, %lu stalls of the worker\n", nbr_drains, nbr_stalls);
+  printf("%lu errors\n", nbr_errors);
+  return (nbr_errors == 0) ? 0 : 1;
+}
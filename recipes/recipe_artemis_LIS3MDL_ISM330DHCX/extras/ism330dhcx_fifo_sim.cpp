@@ -0,0 +1,328 @@
+// drive the ISM330DHCX FIFO driver on a computer, against a fake I2C bus that emulates the FIFO
+// registers of the sensor (FIFO_STATUS1/2 with the level and the overrun flag, FIFO_DATA_OUT_TAG with
+// the address wrap around every 7 bytes, and the 512 words of the FIFO in continuous mode):
+//
+//   g++ -O2 -std=c++11 -I.. ism330dhcx_fifo_sim.cpp -o ism330dhcx_fifo_sim
+//   ./ism330dhcx_fifo_sim
+//
+// checks the configuration written, the level and overrun flags, the reads longer than a burst, the
+// rejection of the words with a wrong tag parity, and that drain leaves the FIFO under the watermark
+// while the sensor keeps batching words during the reads, so that the watermark interrupt rises
+// again. Returns non zero if any check fails.
+
+#include <cstdio>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "ism330dhcx_fifo.h"
+
+static constexpr uint8_t i2c_address {0x6A};
+static constexpr size_t fifo_capacity_words {512};
+
+static unsigned long nbr_errors {0};
+
+static void expect(char const * what, bool const condition){
+  if (!condition){
+    nbr_errors++;
+    if (nbr_errors < 20){
+      printf("ERROR: %s\n", what);
+    }
+  }
+}
+
+// the tag byte of a FIFO word: sensor, 2 bits counter, and the odd parity bit
+static uint8_t make_tag_byte(Ism330dhcxTag const tag, uint8_t const counter, bool const wrong_parity=false){
+  uint8_t byte = static_cast<uint8_t>((static_cast<uint8_t>(tag) << 3) | ((counter & 0x03) << 1));
+  uint8_t parity = byte;
+  parity ^= parity >> 4;
+  parity ^= parity >> 2;
+  parity ^= parity >> 1;
+  if ((parity & 0x01) == 0){
+    byte |= 0x01;
+  }
+  return wrong_parity ? static_cast<uint8_t>(byte ^ 0x01) : byte;
+}
+
+struct RawWord{
+  uint8_t bytes[ism330dhcx_fifo_word_length];
+};
+
+// the sensor side of the I2C bus, with the interface of TwoWire used by the driver
+struct FakeBus{
+  uint8_t registers[128] {};
+  std::deque<RawWord> fifo;
+  bool overrun {false};
+
+  // words batched by the sensor at each I2C transaction, as the time goes during the reads
+  size_t words_per_transaction {0};
+  uint16_t sample_counter {0};
+  unsigned long nbr_batched {0};
+
+  // the bytes of the FIFO word being read, as the address wraps around every 7 bytes
+  RawWord crrt_word {};
+  size_t crrt_word_offset {ism330dhcx_fifo_word_length};
+
+  uint8_t crrt_register {0};
+  bool register_set {false};
+  std::vector<uint8_t> rx;
+  size_t rx_position {0};
+
+  unsigned long nbr_transactions {0};
+  size_t max_request_bytes {0};
+  std::vector<size_t> data_request_bytes;
+
+  // batch a sample: alternately gyro and accel words, with the sample counter in the axes
+  void batch_word(bool const wrong_parity=false){
+    Ism330dhcxTag const tag = (sample_counter % 2 == 0) ? Ism330dhcxTag::gyro : Ism330dhcxTag::accel;
+    RawWord word;
+    word.bytes[0] = make_tag_byte(tag, static_cast<uint8_t>(sample_counter / 2), wrong_parity);
+    int16_t const values[3] {static_cast<int16_t>(sample_counter), static_cast<int16_t>(-sample_counter), 1000};
+    for (size_t ind=0; ind<3; ind++){
+      word.bytes[1 + 2 * ind] = static_cast<uint8_t>(values[ind] & 0xFF);
+      word.bytes[2 + 2 * ind] = static_cast<uint8_t>(static_cast<uint16_t>(values[ind]) >> 8);
+    }
+    sample_counter++;
+    nbr_batched++;
+
+    fifo.push_back(word);
+    if (fifo.size() > fifo_capacity_words){
+      fifo.pop_front();
+      overrun = true;
+    }
+  }
+
+  void beginTransmission(uint8_t const address){
+    expect("I2C address", address == i2c_address);
+    register_set = false;
+    rx.clear();
+  }
+
+  size_t write(uint8_t const value){
+    if (!register_set){
+      crrt_register = value;
+      register_set = true;
+    }
+    else{
+      registers[crrt_register & 0x7F] = value;
+      crrt_register++;
+    }
+    return 1;
+  }
+
+  uint8_t endTransmission(bool const stop=true){
+    (void)stop;
+    nbr_transactions++;
+    for (size_t ind=0; ind<words_per_transaction; ind++){
+      batch_word();
+    }
+    return 0;
+  }
+
+  uint8_t requestFrom(uint8_t const address, uint8_t const nbr_bytes){
+    expect("I2C address", address == i2c_address);
+    nbr_transactions++;
+    max_request_bytes = (nbr_bytes > max_request_bytes) ? nbr_bytes : max_request_bytes;
+
+    rx.clear();
+    rx_position = 0;
+    if (crrt_register == 0x3A){
+      // FIFO_STATUS1: level low byte; FIFO_STATUS2: level high bits, overrun flag (cleared by the read)
+      size_t const level = fifo.size();
+      rx.push_back(static_cast<uint8_t>(level & 0xFF));
+      rx.push_back(static_cast<uint8_t>(((level >> 8) & 0x03) | (overrun ? 0x40 : 0x00)));
+      overrun = false;
+    }
+    else if (crrt_register == 0x78){
+      data_request_bytes.push_back(nbr_bytes);
+      for (size_t ind=0; ind<nbr_bytes; ind++){
+        if (crrt_word_offset == ism330dhcx_fifo_word_length){
+          if (fifo.empty()){
+            crrt_word = RawWord{};
+          }
+          else{
+            crrt_word = fifo.front();
+            fifo.pop_front();
+          }
+          crrt_word_offset = 0;
+        }
+        rx.push_back(crrt_word.bytes[crrt_word_offset++]);
+      }
+    }
+    else{
+      for (size_t ind=0; ind<nbr_bytes; ind++){
+        rx.push_back(registers[(crrt_register + ind) & 0x7F]);
+      }
+    }
+    rx.resize(nbr_bytes);
+    return nbr_bytes;
+  }
+
+  int read(void){
+    return (rx_position < rx.size()) ? rx[rx_position++] : -1;
+  }
+};
+
+// the words must be the ones batched, in order: the sample counter is in x
+static bool check_sequence(Ism330dhcxFifoWord const * words, size_t const nbr_words, uint16_t & next_counter){
+  bool ok {true};
+  for (size_t ind=0; ind<nbr_words; ind++){
+    Ism330dhcxTag const expected_tag = (next_counter % 2 == 0) ? Ism330dhcxTag::gyro : Ism330dhcxTag::accel;
+    ok = ok && (words[ind].tag == expected_tag) && (words[ind].x == static_cast<int16_t>(next_counter)) &&
+         (words[ind].y == static_cast<int16_t>(-next_counter)) && (words[ind].z == 1000);
+    next_counter++;
+  }
+  return ok;
+}
+
+static void check_configure(void){
+  FakeBus bus;
+  Ism330dhcxFifo<FakeBus> fifo{bus, i2c_address};
+  fifo.configure(300, Ism330dhcxBatchRate::rate_104_hz);
+
+  expect("watermark low byte", bus.registers[0x07] == (300 & 0xFF));
+  expect("watermark high bit", bus.registers[0x08] == 0x01);
+  expect("batch rates", bus.registers[0x09] == 0x44);
+  expect("watermark on INT1", bus.registers[0x0D] == 0x08);
+  expect("continuous mode, temperature batched", bus.registers[0x0A] == 0x16);
+}
+
+static void check_level_and_bursts(void){
+  FakeBus bus;
+  Ism330dhcxFifo<FakeBus> fifo{bus, i2c_address};
+  Ism330dhcxFifoWord words[fifo_capacity_words];
+
+  // a level above 255, and reads longer than a burst
+  for (size_t ind=0; ind<300; ind++){
+    bus.batch_word();
+  }
+  expect("level above 255", fifo.words_available() == 300);
+  expect("no overrun yet", fifo.counters().overruns == 0);
+
+  uint16_t next_counter {0};
+  size_t const nbr_read = fifo.read_words(words, 100);
+  expect("read of 100 words", nbr_read == 100);
+  expect("words in order, across bursts", check_sequence(words, nbr_read, next_counter));
+  expect("bursts of 32 words", (bus.data_request_bytes.size() == 4) && (bus.max_request_bytes == 32 * ism330dhcx_fifo_word_length));
+  expect("level after the read", fifo.words_available() == 200);
+
+  size_t const nbr_rest = fifo.read_words(words, fifo_capacity_words);
+  expect("read of the rest", (nbr_rest == 200) && check_sequence(words, nbr_rest, next_counter));
+  expect("FIFO empty", fifo.words_available() == 0);
+  expect("empty read", fifo.read_words(words, fifo_capacity_words) == 0);
+  expect("words counted", fifo.counters().words_read == 300);
+
+  // overrun: the oldest words are lost, the flag is counted once
+  for (size_t ind=0; ind<fifo_capacity_words + 50; ind++){
+    bus.batch_word();
+  }
+  expect("level when full", fifo.words_available() == fifo_capacity_words);
+  expect("overrun counted", fifo.counters().overruns == 1);
+  expect("overrun flag cleared", (fifo.words_available() == fifo_capacity_words) && (fifo.counters().overruns == 1));
+  next_counter = static_cast<uint16_t>(next_counter + 50);
+  size_t const nbr_after_overrun = fifo.read_words(words, fifo_capacity_words);
+  expect("read after the overrun", (nbr_after_overrun == fifo_capacity_words) && check_sequence(words, nbr_after_overrun, next_counter));
+
+  printf("level and bursts: %lu transactions, largest read %zu bytes, overruns %u\n", bus.nbr_transactions,
+         bus.max_request_bytes, fifo.counters().overruns);
+}
+
+static void check_parity(void){
+  FakeBus bus;
+  Ism330dhcxFifo<FakeBus> fifo{bus, i2c_address};
+  Ism330dhcxFifoWord words[64];
+
+  for (size_t ind=0; ind<64; ind++){
+    bus.batch_word(ind % 10 == 3);
+  }
+
+  size_t const nbr_read = fifo.read_words(words, 64);
+  expect("words with a wrong parity dropped", nbr_read == 64 - 7);
+  expect("parity errors counted", fifo.counters().parity_errors == 7);
+  expect("all the words read", fifo.counters().words_read == 64);
+
+  // the valid words are the others, in order
+  bool ok {true};
+  size_t crrt {0};
+  for (uint16_t counter=0; counter<64; counter++){
+    if (counter % 10 == 3){
+      continue;
+    }
+    ok = ok && (crrt < nbr_read) && (words[crrt].x == static_cast<int16_t>(counter));
+    crrt++;
+  }
+  expect("valid words kept, in order", ok);
+}
+
+// the worker serves the watermark edge late, and the sensor batches words during the reads: a single
+// read_words of max_words_per_read then leaves the FIFO over the watermark, and the watermark
+// interrupt, on a rising edge, would never come again; drain must go under it
+static void check_drain_below_watermark(void){
+  uint16_t const watermark {8};
+  size_t const max_words_per_read {16};
+  size_t const max_latency_words {40};
+
+  FakeBus bus;
+  Ism330dhcxFifo<FakeBus> fifo{bus, i2c_address};
+  Ism330dhcxFifoWord words[max_words_per_read];
+
+  uint16_t next_counter {0};
+  bool in_order {true};
+  unsigned long nbr_edges {0};
+  unsigned long nbr_words_seen {0};
+  bool int1_high {false};
+
+  // the time goes by steps of one batched word between the drains
+  for (unsigned long step=0; step<20000; step++){
+    bus.batch_word();
+
+    bool const level = bus.fifo.size() >= watermark;
+    bool const edge = level && !int1_high;
+    int1_high = level;
+    if (!edge){
+      continue;
+    }
+
+    // the loop gets to the request later, and the reads take time
+    nbr_edges++;
+    for (size_t ind=0; ind<(nbr_edges * 7) % (max_latency_words + 1); ind++){
+      bus.batch_word();
+    }
+    bus.words_per_transaction = 1;
+    fifo.drain(words, max_words_per_read, watermark, 8 * max_words_per_read,
+               [&](Ism330dhcxFifoWord const * words_read, size_t nbr_words){
+      in_order = in_order && check_sequence(words_read, nbr_words, next_counter);
+      nbr_words_seen += nbr_words;
+    });
+    bus.words_per_transaction = 0;
+
+    expect("drained under the watermark", bus.fifo.size() < watermark);
+    int1_high = bus.fifo.size() >= watermark;
+  }
+
+  printf("drain: %lu watermark edges, %lu words read, %zu left, overruns %u\n", nbr_edges, nbr_words_seen,
+         bus.fifo.size(), fifo.counters().overruns);
+  expect("drained words in order", in_order);
+  expect("no overrun", fifo.counters().overruns == 0);
+  expect("every word read", nbr_words_seen + bus.fifo.size() == bus.nbr_batched);
+  expect("the watermark keeps rising", nbr_edges > 1000);
+
+  // bounded by max_nbr_words: the rest is left for the next drain
+  FakeBus bus_full;
+  Ism330dhcxFifo<FakeBus> fifo_full{bus_full, i2c_address};
+  for (size_t ind=0; ind<200; ind++){
+    bus_full.batch_word();
+  }
+  size_t const nbr_bounded = fifo_full.drain(words, max_words_per_read, watermark, 40, [](Ism330dhcxFifoWord const *, size_t){});
+  expect("drain bounded by max_nbr_words", (nbr_bounded == 40) && (bus_full.fifo.size() == 160));
+}
+
+int main(){
+  check_configure();
+  check_level_and_bursts();
+  check_parity();
+  check_drain_below_watermark();
+
+  printf("%lu errors\n", nbr_errors);
+  return (nbr_errors == 0) ? 0 : 1;
+}
@@ -0,0 +1,215 @@
+#ifndef ISM330DHCX_FIFO_H
+#define ISM330DHCX_FIFO_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// FIFO mode driver for the ISM330DHCX: the accel, gyro (and temperature) samples are batched in the
+// on chip FIFO (up to 512 words), the watermark interrupt is routed to INT1, and the FIFO is drained
+// with burst reads of many words in a single I2C transaction, rather than one transaction per sample.
+//
+// each FIFO word is 7 bytes: a tag (sensor in bits 7..3, a 2 bits counter in bits 2..1, odd parity
+// in bit 0) and the 3 int16 little endian axes. When reading from FIFO_DATA_OUT_TAG, the register
+// address wraps around from FIFO_DATA_OUT_Z_H back to FIFO_DATA_OUT_TAG, so that any number of words
+// can be read in one burst.
+//
+// the driver is templated on the I2C bus (TwoWire on the Artemis), so that it can be simulated on a
+// computer with a fake bus, see extras/ism330dhcx_fifo_sim.cpp.
+
+enum class Ism330dhcxTag : uint8_t {
+  gyro = 0x01,
+  accel = 0x02,
+  temperature = 0x03,
+  timestamp = 0x04,
+  config_change = 0x05,
+};
+
+struct Ism330dhcxFifoWord{
+  Ism330dhcxTag tag;
+  int16_t x;
+  int16_t y;
+  int16_t z;
+};
+
+struct Ism330dhcxFifoCounters{
+  // words read from the FIFO
+  uint32_t words_read {0};
+  // words with a wrong tag parity, dropped
+  uint32_t parity_errors {0};
+  // times the FIFO was found overrun, i.e. samples were lost since it was not drained fast enough
+  uint32_t overruns {0};
+};
+
+// batch data rates, same codes as the output data rates (FIFO_CTRL3)
+enum class Ism330dhcxBatchRate : uint8_t {
+  rate_104_hz = 0x04,
+  rate_208_hz = 0x05,
+  rate_416_hz = 0x06,
+  rate_833_hz = 0x07,
+  rate_1666_hz = 0x08,
+};
+
+constexpr size_t ism330dhcx_fifo_word_length {7};
+
+// decode nbr_words raw FIFO words from raw_bytes into words_out; the words with a wrong parity are
+// dropped. Returns the number of words written to words_out.
+inline size_t ism330dhcx_decode_fifo_words(uint8_t const * raw_bytes, size_t const nbr_words,
+                                           Ism330dhcxFifoWord * words_out, uint32_t & parity_errors){
+  size_t nbr_decoded {0};
+
+  for (size_t ind=0; ind<nbr_words; ind++){
+    uint8_t const * word = raw_bytes + ind * ism330dhcx_fifo_word_length;
+    uint8_t const tag_byte = word[0];
+
+    // odd parity over the whole tag byte
+    uint8_t parity = tag_byte;
+    parity ^= parity >> 4;
+    parity ^= parity >> 2;
+    parity ^= parity >> 1;
+    if ((parity & 0x01) == 0){
+      parity_errors++;
+      continue;
+    }
+
+    Ism330dhcxFifoWord & out = words_out[nbr_decoded];
+    out.tag = static_cast<Ism330dhcxTag>(tag_byte >> 3);
+    out.x = static_cast<int16_t>(static_cast<uint16_t>(word[1]) | (static_cast<uint16_t>(word[2]) << 8));
+    out.y = static_cast<int16_t>(static_cast<uint16_t>(word[3]) | (static_cast<uint16_t>(word[4]) << 8));
+    out.z = static_cast<int16_t>(static_cast<uint16_t>(word[5]) | (static_cast<uint16_t>(word[6]) << 8));
+    nbr_decoded++;
+  }
+
+  return nbr_decoded;
+}
+
+// temperature word to deg C
+inline float ism330dhcx_temperature_deg_c(int16_t const raw){
+  return 25.0f + raw / 256.0f;
+}
+
+//--------------------------------------------------------------------------------
+// max_words_per_burst is limited by the receive buffer of the I2C driver (256 bytes on the Artemis)
+template <typename Bus, size_t max_words_per_burst=32>
+class Ism330dhcxFifo{
+  public:
+    Ism330dhcxFifo(Bus & bus, uint8_t const i2c_address): bus(bus), i2c_address(i2c_address) {}
+
+    // batch accel and gyro at batch_rate, and the temperature at 1.6 Hz, in continuous mode (when
+    // full, the oldest words are overwritten); the watermark interrupt, on INT1, is raised when at
+    // least watermark_words words are in the FIFO. This replaces any DRDY routed to INT1.
+    void configure(uint16_t const watermark_words, Ism330dhcxBatchRate const batch_rate){
+      // bypass mode first, to empty the FIFO
+      write_register(reg_fifo_ctrl4, fifo_mode_bypass);
+
+      write_register(reg_fifo_ctrl1, static_cast<uint8_t>(watermark_words & 0xFF));
+      write_register(reg_fifo_ctrl2, static_cast<uint8_t>((watermark_words >> 8) & 0x01));
+      write_register(reg_fifo_ctrl3, static_cast<uint8_t>((static_cast<uint8_t>(batch_rate) << 4) | static_cast<uint8_t>(batch_rate)));
+      write_register(reg_int1_ctrl, int1_fifo_th);
+      write_register(reg_fifo_ctrl4, odr_t_batch_1_6_hz | fifo_mode_continuous);
+    }
+
+    // number of words in the FIFO; also checks, and counts, overruns
+    uint16_t words_available(void){
+      uint8_t status[2];
+      read_registers(reg_fifo_status1, status, 2);
+
+      if (status[1] & fifo_ovr_ia){
+        crrt_counters.overruns++;
+      }
+
+      return static_cast<uint16_t>(status[0] | ((status[1] & 0x03) << 8));
+    }
+
+    // read and decode up to max_nbr_words words in bursts of max_words_per_burst words; returns the
+    // number of valid words written to words_out
+    size_t read_words(Ism330dhcxFifoWord * const words_out, size_t const max_nbr_words){
+      size_t nbr_to_read = words_available();
+      if (nbr_to_read > max_nbr_words){
+        nbr_to_read = max_nbr_words;
+      }
+
+      size_t nbr_decoded {0};
+      while (nbr_to_read > 0){
+        size_t const nbr_in_burst = (nbr_to_read < max_words_per_burst) ? nbr_to_read : max_words_per_burst;
+        read_registers(reg_fifo_data_out_tag, raw_bytes, nbr_in_burst * ism330dhcx_fifo_word_length);
+        nbr_decoded += ism330dhcx_decode_fifo_words(raw_bytes, nbr_in_burst, words_out + nbr_decoded, crrt_counters.parity_errors);
+        crrt_counters.words_read += nbr_in_burst;
+        nbr_to_read -= nbr_in_burst;
+      }
+
+      return nbr_decoded;
+    }
+
+    // read words with read_words, max_nbr_words_per_read at a time into words, and pass each read
+    // to on_words(Ism330dhcxFifoWord const * words, size_t nbr_words), until fewer than
+    // watermark_words words are left in the FIFO or max_nbr_words were read. The FIFO must be drained
+    // below the watermark for the watermark interrupt to rise again: words keep coming during the
+    // reads, and a FIFO left over the watermark would never raise a new edge. Returns the number of
+    // valid words read.
+    template <typename WordsFunction>
+    size_t drain(Ism330dhcxFifoWord * const words, size_t const max_nbr_words_per_read, uint16_t const watermark_words,
+                 size_t const max_nbr_words, WordsFunction && on_words){
+      size_t nbr_words_read {0};
+      size_t nbr_words_left {max_nbr_words};
+
+      while (nbr_words_left > 0){
+        uint32_t const words_read_before = crrt_counters.words_read;
+        size_t const nbr_words = read_words(words, (max_nbr_words_per_read < nbr_words_left) ? max_nbr_words_per_read : nbr_words_left);
+        size_t const nbr_taken = crrt_counters.words_read - words_read_before;
+        on_words(words, nbr_words);
+        nbr_words_read += nbr_words;
+        nbr_words_left -= nbr_taken;
+
+        if ((nbr_taken == 0) || (words_available() < watermark_words)){
+          break;
+        }
+      }
+
+      return nbr_words_read;
+    }
+
+    Ism330dhcxFifoCounters const & counters(void) const{
+      return crrt_counters;
+    }
+
+  private:
+    static constexpr uint8_t reg_fifo_ctrl1 {0x07};
+    static constexpr uint8_t reg_fifo_ctrl2 {0x08};
+    static constexpr uint8_t reg_fifo_ctrl3 {0x09};
+    static constexpr uint8_t reg_fifo_ctrl4 {0x0A};
+    static constexpr uint8_t reg_int1_ctrl {0x0D};
+    static constexpr uint8_t reg_fifo_status1 {0x3A};
+    static constexpr uint8_t reg_fifo_data_out_tag {0x78};
+
+    static constexpr uint8_t fifo_mode_bypass {0x00};
+    static constexpr uint8_t fifo_mode_continuous {0x06};
+    static constexpr uint8_t odr_t_batch_1_6_hz {0x10};
+    static constexpr uint8_t int1_fifo_th {0x08};
+    static constexpr uint8_t fifo_ovr_ia {0x40};
+
+    void write_register(uint8_t const reg, uint8_t const value){
+      bus.beginTransmission(i2c_address);
+      bus.write(reg);
+      bus.write(value);
+      bus.endTransmission();
+    }
+
+    void read_registers(uint8_t const reg, uint8_t * const buffer, size_t const nbr_bytes){
+      bus.beginTransmission(i2c_address);
+      bus.write(reg);
+      bus.endTransmission(false);
+      bus.requestFrom(i2c_address, static_cast<uint8_t>(nbr_bytes));
+      for (size_t ind=0; ind<nbr_bytes; ind++){
+        buffer[ind] = bus.read();
+      }
+    }
+
+    static_assert(max_words_per_burst * ism330dhcx_fifo_word_length <= 255, "a burst must fit in a single requestFrom");
+
+    Bus & bus;
+    uint8_t const i2c_address;
+    uint8_t raw_bytes[max_words_per_burst * ism330dhcx_fifo_word_length];
+    Ism330dhcxFifoCounters crrt_counters {};
+};
+
+#endif
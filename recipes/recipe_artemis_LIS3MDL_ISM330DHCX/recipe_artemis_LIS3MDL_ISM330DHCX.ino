@@ -14,7 +14,11 @@
 // #include <Adafruit_Sensor_Calibration.h>
 
 #include <Adafruit_AHRS.h>
-#include "kiss_clang_3d.h"
+#include <kiss_clang_3d.h>
+#include <kiss_ahrs.h>
+#include <telemetry_frame.h>
+#include "drdy_acquisition.h"
+#include "ism330dhcx_fifo.h"
 
 // this is the broken out Qwiic
 TwoWire ArtemisWire(4);
@@ -27,11 +31,32 @@ Adafruit_LIS3MDL lis3mdl;
 // a true Kalman filter; slow but good
 Adafruit_NXPSensorFusion filter;
 
-// our frequency params
-static constexpr unsigned long filter_update_rate_hz {100};
-static constexpr unsigned long filter_update_interval_ms = 1000 / filter_update_rate_hz;
+// lightweight filters, updated on the same samples as the Kalman filter, to compare their cost and
+// output to it; see kiss_ahrs.h
+mahony mahony_filter;
+madgwick madgwick_filter;
+unsigned long micros_nxp_update;
+unsigned long micros_mahony_update;
+unsigned long micros_madgwick_update;
+
+// set to true to print, at each filter update, a line with the raw samples and the output of the
+// Kalman filter, that can be replayed on a computer through the lightweight filters with the
+// ahrs_log_replay tool in the extras of kiss_clang_3d
+static constexpr bool log_imu_samples {false};
+
+// set to true to send, at each filter update, a binary telemetry frame (type id 1: accel, gyro, mag,
+// quaternion, 13 floats) instead of the text output, which takes most of the CPU time at 1 Mbaud;
+// decode it with the extras/telemetry_decode.py script of the telemetry library
+static constexpr bool binary_telemetry {false};
+static constexpr uint8_t telemetry_type_imu {1};
+TelemetryWriter<13 * sizeof(float)> telemetry_writer;
+static_assert(sizeof(vec3) == 3 * sizeof(float), "the imu telemetry frame layout assumes F_TYPE float");
+
+// our frequency params: the filters are updated on every accel / gyro sample batched in the FIFO,
+// i.e. at the batch data rate of the FIFO (104 Hz), which is also the fixed timestep they are set up for
+static constexpr unsigned long filter_update_rate_hz {104};
+static constexpr unsigned long filter_update_interval_us = 1000000 / filter_update_rate_hz;
 static constexpr unsigned long printing_interval_ms = 200;
-unsigned long timestamp_sensors_filter;
 unsigned long timestamp_printing;
 unsigned long micros_timing;
 
@@ -48,6 +73,246 @@ sensors_event_t gyro;
 sensors_event_t temp;
 sensors_event_t mag; 
 
+// the last 2 outputs of the filter, and the timestamps of the samples they correspond to; the
+// magnetometer (560 Hz) and the accel / gyro and the filter (104 Hz) run at different rates, so
+// rather than reusing the last quaternion, the orientation is interpolated at the timestamp of each
+// sample
+quat quat_filter_previous {1, 0, 0, 0};
+quat quat_filter_current {1, 0, 0, 0};
+unsigned long micros_filter_previous;
+unsigned long micros_filter_current;
+unsigned long micros_accel_sample;
+unsigned long micros_mag_sample;
+
+// the mag samples not yet resampled, with their timestamps, as structures of arrays: once the filter
+// has an output after them, they are rotated to the earth frame at their own timestamps, with the
+// orientation interpolated between the 2 filter outputs around them
+static constexpr size_t max_nbr_mag_samples {32};
+uint32_t mag_timestamps[max_nbr_mag_samples];
+F_TYPE mag_i[max_nbr_mag_samples];
+F_TYPE mag_j[max_nbr_mag_samples];
+F_TYPE mag_k[max_nbr_mag_samples];
+size_t nbr_mag_samples {0};
+unsigned long nbr_mag_samples_dropped {0};
+F_TYPE mag_fractions[max_nbr_mag_samples];
+F_TYPE mag_q_r[max_nbr_mag_samples];
+F_TYPE mag_q_i[max_nbr_mag_samples];
+F_TYPE mag_q_j[max_nbr_mag_samples];
+F_TYPE mag_q_k[max_nbr_mag_samples];
+// the latest mag sample in the earth frame, and its timestamp
+vec3 mag_earth;
+unsigned long micros_mag_earth;
+
+// the DRDY lines, adapt to the wiring: INT1 of the ISM330DHCX (FIFO watermark, see under), and DRDY
+// of the LIS3MDL
+static constexpr int pin_imu_drdy {4};
+static constexpr int pin_mag_drdy {5};
+
+// the accel and gyro run at 104 Hz, the rate of the filters, and every sample is batched in the FIFO
+// of the ISM330DHCX at the same rate (so that their digital low pass filters are also set for it);
+// the FIFO is read in bursts when the watermark is reached: 8 words is 4 accel + gyro samples, i.e.
+// one burst about every 38 ms instead of one I2C transaction per sample. Every sample batched is fed
+// to the filters.
+static constexpr Ism330dhcxBatchRate fifo_batch_rate {Ism330dhcxBatchRate::rate_104_hz};
+static constexpr uint16_t fifo_watermark_words {8};
+static constexpr size_t max_nbr_fifo_words {64};
+Ism330dhcxFifo<TwoWire> ism330dhcx_fifo{ArtemisWire, LSM6DS_I2CADDR_DEFAULT};
+Ism330dhcxFifoWord fifo_words[max_nbr_fifo_words];
+
+// the accel + gyro samples of a drain of the FIFO, before they are fed to the filters; what does not
+// fit is left in the FIFO, which then stays over the watermark and is drained at the next loop
+struct ImuSample{
+  vec3 gyr;  // rad/s
+  vec3 acc;  // m/s^2
+};
+static constexpr size_t max_nbr_imu_samples {64};
+ImuSample imu_samples[max_nbr_imu_samples];
+// the gyro and accel words of a sample may come in 2 different bursts
+ImuSample imu_sample_in_progress;
+bool has_fifo_gyro {false};
+bool has_fifo_accel {false};
+
+// sensitivities, for the ranges set in setup: 2 G, 125 dps
+static constexpr float accel_ms2_per_lsb {0.061e-3f * SENSORS_GRAVITY_STANDARD};
+static constexpr float gyro_rads_per_lsb {4.375e-3f * SENSORS_DPS_TO_RADS};
+
+// the DRDY interrupts only timestamp and queue a read request, the loop performs the reads
+DrdyAcquisition<16> acquisition;
+
+void isr_imu_drdy(void){
+  acquisition.on_drdy(DrdySource::imu, micros());
+}
+
+void isr_mag_drdy(void){
+  acquisition.on_drdy(DrdySource::mag, micros());
+}
+
+// drain the FIFO of the ISM330DHCX in bursts, until it is under the watermark (or imu_samples is full),
+// pairing the accel and gyro words into imu_samples; keeps the latest values in accel, gyro and
+// temp for the printing. Returns the number of samples.
+size_t read_ism330dhcx_fifo(void){
+  size_t nbr_samples {0};
+
+  // at most 2 words per sample
+  ism330dhcx_fifo.drain(fifo_words, max_nbr_fifo_words, fifo_watermark_words, 2 * max_nbr_imu_samples,
+                        [&nbr_samples](Ism330dhcxFifoWord const * words, size_t nbr_words){
+    for (size_t ind=0; ind<nbr_words; ind++){
+      Ism330dhcxFifoWord const & word = words[ind];
+      switch (word.tag){
+        case Ism330dhcxTag::accel:
+          vec3_setter(&imu_sample_in_progress.acc, accel_ms2_per_lsb * word.x, accel_ms2_per_lsb * word.y, accel_ms2_per_lsb * word.z);
+          has_fifo_accel = true;
+          break;
+        case Ism330dhcxTag::gyro:
+          vec3_setter(&imu_sample_in_progress.gyr, gyro_rads_per_lsb * word.x, gyro_rads_per_lsb * word.y, gyro_rads_per_lsb * word.z);
+          has_fifo_gyro = true;
+          break;
+        case Ism330dhcxTag::temperature:
+          temp.temperature = ism330dhcx_temperature_deg_c(word.x);
+          break;
+        default:
+          break;
+      }
+
+      if (has_fifo_accel && has_fifo_gyro){
+        imu_samples[nbr_samples++] = imu_sample_in_progress;
+        has_fifo_accel = false;
+        has_fifo_gyro = false;
+      }
+    }
+  });
+
+  if (nbr_samples > 0){
+    ImuSample const & latest = imu_samples[nbr_samples - 1];
+    accel.acceleration.x = latest.acc.i; accel.acceleration.y = latest.acc.j; accel.acceleration.z = latest.acc.k;
+    gyro.gyro.x = latest.gyr.i; gyro.gyro.y = latest.gyr.j; gyro.gyro.z = latest.gyr.k;
+  }
+
+  return nbr_samples;
+}
+
+// rotate the mag samples up to the current filter output to the earth frame, each with the
+// orientation at its own timestamp; nlerp is enough here, as the orientation changes little in one
+// filter period, see extras/interpolation_check.cpp in kiss_clang_3d
+void resample_mag_samples(void){
+  size_t nbr_ready {0};
+  while ((nbr_ready < nbr_mag_samples) && (static_cast<int32_t>(mag_timestamps[nbr_ready] - micros_filter_current) <= 0)){
+    nbr_ready++;
+  }
+  if (nbr_ready == 0){
+    return;
+  }
+
+  interpolation_fractions_batch(micros_filter_previous, micros_filter_current, mag_timestamps, nbr_ready, mag_fractions);
+  quat_nlerp_batch(&quat_filter_previous, &quat_filter_current, mag_fractions, nbr_ready, mag_q_r, mag_q_i, mag_q_j, mag_q_k);
+  rotate_by_quats_R_batch(mag_i, mag_j, mag_k, mag_q_r, mag_q_i, mag_q_j, mag_q_k, nbr_ready, mag_i, mag_j, mag_k);
+
+  vec3_setter(&mag_earth, mag_i[nbr_ready - 1], mag_j[nbr_ready - 1], mag_k[nbr_ready - 1]);
+  micros_mag_earth = mag_timestamps[nbr_ready - 1];
+
+  nbr_mag_samples -= nbr_ready;
+  for (size_t ind=0; ind<nbr_mag_samples; ind++){
+    mag_timestamps[ind] = mag_timestamps[ind + nbr_ready];
+    mag_i[ind] = mag_i[ind + nbr_ready];
+    mag_j[ind] = mag_j[ind + nbr_ready];
+    mag_k[ind] = mag_k[ind + nbr_ready];
+  }
+}
+
+// one update of all the filters, with one accel + gyro sample from the FIFO and the latest mag sample
+void update_filters(ImuSample const & sample, uint32_t timestamp_us){
+  enableBurstMode();
+
+  // Update the SensorFusion filter
+  micros_timing = micros();
+  filter.update(sample.gyr.i * SENSORS_RADS_TO_DPS, sample.gyr.j * SENSORS_RADS_TO_DPS, sample.gyr.k * SENSORS_RADS_TO_DPS,
+                sample.acc.i, sample.acc.j, sample.acc.k,
+                mag.magnetic.x, mag.magnetic.y, mag.magnetic.z);
+  micros_nxp_update = micros() - micros_timing;
+
+  // and the lightweight filters, gyro in rad/s
+  vec3 const & gyr_sample = sample.gyr;
+  vec3 const & acc_sample = sample.acc;
+  vec3 mag_sample;
+  vec3_setter(&mag_sample, mag.magnetic.x, mag.magnetic.y, mag.magnetic.z);
+
+  micros_timing = micros();
+  mahony_update(&mahony_filter, &gyr_sample, &acc_sample, &mag_sample);
+  micros_mahony_update = micros() - micros_timing;
+
+  micros_timing = micros();
+  madgwick_update(&madgwick_filter, &gyr_sample, &acc_sample, &mag_sample);
+  micros_madgwick_update = micros() - micros_timing;
+  disableBurstMode();
+
+  // keep track of the last 2 filter outputs for interpolation
+  quat_copy(&quat_filter_current, &quat_filter_previous);
+  micros_filter_previous = micros_filter_current;
+  filter.getQuaternion(&quat_filter_current.r, &quat_filter_current.i, &quat_filter_current.j, &quat_filter_current.k);
+  micros_filter_current = timestamp_us;
+  resample_mag_samples();
+
+  if (log_imu_samples){
+    Serial.print(F("IMU,")); Serial.print(timestamp_us);
+    Serial.print(','); Serial.print(gyr_sample.i, 6); Serial.print(','); Serial.print(gyr_sample.j, 6); Serial.print(','); Serial.print(gyr_sample.k, 6);
+    Serial.print(','); Serial.print(acc_sample.i, 6); Serial.print(','); Serial.print(acc_sample.j, 6); Serial.print(','); Serial.print(acc_sample.k, 6);
+    Serial.print(','); Serial.print(mag_sample.i, 6); Serial.print(','); Serial.print(mag_sample.j, 6); Serial.print(','); Serial.print(mag_sample.k, 6);
+    Serial.print(','); Serial.print(quat_filter_current.r, 6); Serial.print(','); Serial.print(quat_filter_current.i, 6);
+    Serial.print(','); Serial.print(quat_filter_current.j, 6); Serial.print(','); Serial.println(quat_filter_current.k, 6);
+  }
+
+  if (binary_telemetry){
+    telemetry_writer.begin(telemetry_type_imu, timestamp_us);
+    telemetry_writer.put(acc_sample);
+    telemetry_writer.put(gyr_sample);
+    telemetry_writer.put(mag_sample);
+    telemetry_writer.put(quat_filter_current);
+    size_t const frame_length = telemetry_writer.finish();
+    Serial.write(telemetry_writer.frame(), frame_length);
+  }
+
+  micros_accel_sample = timestamp_us;
+}
+
+// the I2C reads, called by the worker for each request, with the timestamp of its edge; for the IMU,
+// this is the FIFO watermark, taken as the timestamp of the latest sample read, the previous ones
+// being one batch period apart
+void read_sensor(DrdySource source, uint32_t timestamp_us){
+  if (source == DrdySource::imu){
+    size_t const nbr_samples = read_ism330dhcx_fifo();
+    for (size_t ind=0; ind<nbr_samples; ind++){
+      update_filters(imu_samples[ind], timestamp_us - (nbr_samples - 1 - ind) * filter_update_interval_us);
+    }
+  }
+  else{
+    lis3mdl.getEvent(&mag);
+    micros_mag_sample = timestamp_us;
+
+    // if the filter falls behind, the oldest samples go
+    if (nbr_mag_samples == max_nbr_mag_samples){
+      nbr_mag_samples_dropped++;
+      nbr_mag_samples--;
+      for (size_t ind=0; ind<nbr_mag_samples; ind++){
+        mag_timestamps[ind] = mag_timestamps[ind + 1];
+        mag_i[ind] = mag_i[ind + 1];
+        mag_j[ind] = mag_j[ind + 1];
+        mag_k[ind] = mag_k[ind + 1];
+      }
+    }
+    mag_timestamps[nbr_mag_samples] = timestamp_us;
+    mag_i[nbr_mag_samples] = mag.magnetic.x;
+    mag_j[nbr_mag_samples] = mag.magnetic.y;
+    mag_k[nbr_mag_samples] = mag.magnetic.z;
+    nbr_mag_samples++;
+  }
+}
+
+// rotation angle between 2 unit quaternions
+float angle_between(quat const * q_1, quat const * q_2){
+  float const crrt_cos = fabsf(quat_dot(q_1, q_2));
+  return 2.0f * acosf((crrt_cos < 1.0f) ? crrt_cos : 1.0f);
+}
+
 void setup(void) {
 
   Serial.begin(1000000);
@@ -112,10 +377,10 @@ void setup(void) {
   // set the accel gyro properties
   ism330dhcx.setAccelRange(LSM6DS_ACCEL_RANGE_2_G);
   ism330dhcx.setGyroRange(LSM6DS_GYRO_RANGE_125_DPS);
-  ism330dhcx.setAccelDataRate(LSM6DS_RATE_833_HZ);
-  ism330dhcx.setGyroDataRate(LSM6DS_RATE_833_HZ);
-  ism330dhcx.configInt1(false, false, true); // accelerometer DRDY on INT1
-  ism330dhcx.configInt2(false, true, false); // gyro DRDY on INT2
+  // same rate as the FIFO batching, fifo_batch_rate
+  ism330dhcx.setAccelDataRate(LSM6DS_RATE_104_HZ);
+  ism330dhcx.setGyroDataRate(LSM6DS_RATE_104_HZ);
+  ism330dhcx_fifo.configure(fifo_watermark_words, fifo_batch_rate); // FIFO watermark on INT1
   delay(500);
 
   // set the magnetometer properties
@@ -289,33 +554,46 @@ void setup(void) {
 
   // initialize the filter
   filter.begin(filter_update_rate_hz);
-  timestamp_sensors_filter = millis();
+  mahony_init(&mahony_filter, filter_update_rate_hz);
+  madgwick_init(&madgwick_filter, filter_update_rate_hz);
   timestamp_printing = millis();
+  micros_filter_current = micros();
+  micros_filter_previous = micros_filter_current - filter_update_interval_us;
+
+  // start the interrupt driven acquisition
+  pinMode(pin_imu_drdy, INPUT);
+  pinMode(pin_mag_drdy, INPUT);
+  attachInterrupt(digitalPinToInterrupt(pin_imu_drdy), isr_imu_drdy, RISING);
+  attachInterrupt(digitalPinToInterrupt(pin_mag_drdy), isr_mag_drdy, RISING);
+
+  // both sensors are already running, so their DRDY lines may be high already: no edge would come,
+  // read them once; from there on, the loop checks the levels after each drain
+  acquisition.on_level(DrdySource::imu, micros());
+  acquisition.on_level(DrdySource::mag, micros());
+
+  // a lone frame delimiter, so that the decoder drops the text printed so far
+  if (binary_telemetry){
+    Serial.write(static_cast<uint8_t>(0x00));
+  }
 }
 
 void loop() {
-  // should we update the measurement and filter?
-  if (millis() - timestamp_sensors_filter >= filter_update_interval_ms){
-    timestamp_sensors_filter += filter_update_interval_ms;
-
-    enableBurstMode();
-    micros_timing = micros();
-    ism330dhcx.getEvent(&accel, &gyro, &temp);
-    lis3mdl.getEvent(&mag);
-    micros_timing = micros() - micros_timing;
-    //Serial.print(F("getEvents took [us]: ")); Serial.println(micros_timing);
-
-    // Update the SensorFusion filter
-    micros_timing = micros();
-    filter.update(gyro.gyro.x * SENSORS_RADS_TO_DPS, gyro.gyro.y * SENSORS_RADS_TO_DPS, gyro.gyro.z * SENSORS_RADS_TO_DPS, 
-                  accel.acceleration.x, accel.acceleration.y, accel.acceleration.z, 
-                  mag.magnetic.x, mag.magnetic.y, mag.magnetic.z);
-    micros_timing = micros() - micros_timing;
-    //Serial.print(F("Kalman filtering took [us]: ")); Serial.println(micros_timing);
-    disableBurstMode();
+  // serve the pending read requests
+  micros_timing = micros();
+  acquisition.drain(read_sensor);
+  micros_timing = micros() - micros_timing;
+  //Serial.print(F("reads took [us]: ")); Serial.println(micros_timing);
+
+  // the DRDY lines stay high until the data is read, so a line already high when its interrupt was
+  // attached, or high again right after a read, gives no edge: request the read from the level
+  if (digitalRead(pin_imu_drdy) == HIGH){
+    acquisition.on_level(DrdySource::imu, micros());
+  }
+  if (digitalRead(pin_mag_drdy) == HIGH){
+    acquisition.on_level(DrdySource::mag, micros());
   }
 
-  if (millis() - timestamp_printing >= printing_interval_ms){
+  if (!binary_telemetry && (millis() - timestamp_printing >= printing_interval_ms)){
     timestamp_printing += printing_interval_ms;
 
     Serial.print("\t\tTemperature ");
@@ -369,21 +647,49 @@ void loop() {
     Serial.print(", ");
     Serial.println(qk, 4);  
 
-    // perform the quaternion transform to go into a NED or similar referential
+    // the lightweight filters: cost of the last update, and angle to the Kalman filter output; the
+    // conventions of the filters may differ by a fixed rotation, so look at the variations
+    Serial.print(F("filter update [us] NXP: ")); Serial.print(micros_nxp_update);
+    Serial.print(F(", Mahony: ")); Serial.print(micros_mahony_update);
+    Serial.print(F(", Madgwick: ")); Serial.println(micros_madgwick_update);
+    Serial.print(F("angle to NXP [deg] Mahony: ")); Serial.print(angle_between(&mahony_filter.q, &quat_filter_current) * SENSORS_RADS_TO_DPS, 3);
+    Serial.print(F(", Madgwick: ")); Serial.println(angle_between(&madgwick_filter.q, &quat_filter_current) * SENSORS_RADS_TO_DPS, 3);
+
+    // perform the quaternion transform to go into a NED or similar referential: the accel comes with
+    // the filter output, while the mag runs at its own rate, and is rotated with the orientation
+    // interpolated at its own timestamp (see resample_mag_samples)
     vec3 accel_raw;
     vec3 accel_NED;
-    quat quat_rotation;
     
     vec3_setter(&accel_raw, accel.acceleration.x, accel.acceleration.y, accel.acceleration.z);
-    quat_setter(&quat_rotation, qr, qi, qj, qk);
-    rotate_by_quat_R(&accel_raw, &quat_rotation, &accel_NED);
+    rotate_by_quat_R(&accel_raw, &quat_filter_current, &accel_NED);
     
+    Serial.print(F("rotated mag at ")); Serial.print(micros_mag_earth); Serial.print(F(" us: "));
+    Serial.print(mag_earth.i, 4); Serial.print(", ");
+    Serial.print(mag_earth.j, 4); Serial.print(", ");
+    Serial.print(mag_earth.k, 4);
+    Serial.print(F(" uTesla, dropped: ")); Serial.println(nbr_mag_samples_dropped);
+
     Serial.print("rotated acc: ");
     Serial.print(accel_NED.i, 4); Serial.print(", ");
     Serial.print(accel_NED.j, 4); Serial.print(", ");
     Serial.print(accel_NED.k, 4); Serial.print(", ");
     Serial.println();
 
+    DrdyCounters const & imu_counters = acquisition.counters(DrdySource::imu);
+    DrdyCounters const & mag_counters = acquisition.counters(DrdySource::mag);
+    Serial.print(F("imu samples read: ")); Serial.print(imu_counters.samples_read);
+    Serial.print(F(", missed: ")); Serial.print(imu_counters.samples_missed);
+    Serial.print(F(", from level: ")); Serial.print(imu_counters.level_requests);
+    Serial.print(F(" | mag samples read: ")); Serial.print(mag_counters.samples_read);
+    Serial.print(F(", missed: ")); Serial.print(mag_counters.samples_missed);
+    Serial.print(F(", from level: ")); Serial.println(mag_counters.level_requests);
+
+    Ism330dhcxFifoCounters const & fifo_counters = ism330dhcx_fifo.counters();
+    Serial.print(F("FIFO words read: ")); Serial.print(fifo_counters.words_read);
+    Serial.print(F(", parity errors: ")); Serial.print(fifo_counters.parity_errors);
+    Serial.print(F(", overruns: ")); Serial.println(fifo_counters.overruns);
+
     Serial.println();
   }
 
@@ -1,8 +1,8 @@
 #include "Arduino.h"
 #include "kiss_fft.h"
 
-// on my Artemis board with core 1.2.1
-#include "ard_supers/avr/dtostrf.h"
+// fast float to text, from the telemetry library; dtostrf goes through the soft double printf
+#include <float_format.h>
 
 // time base properties
 // the highest frequency for which get some information is the Nyquist frequency, i.e. df_hz / 2
@@ -33,7 +33,7 @@ kiss_fft_cpx * data_freq_domain;
 
 // a bit of tooling
 void print_vect(kiss_fft_cpx * data, size_t data_len, byte type, bool flag_pure_csv=false);
-constexpr size_t format_buff_len {16};
+constexpr size_t format_buff_len {64};
 char format_buff[format_buff_len];
 float hamming_coeff_amplitude_compensated(size_t crrt_ind, size_t total_fft_len);
 float energy_content(kiss_fft_cpx data, size_t data_len);
@@ -173,35 +173,26 @@ void print_vect(kiss_fft_cpx * data, size_t data_len, byte type, bool flag_pure_
         axis_coord = (-(float)data_len + (float)ind) * df_hz / data_len;
       }
     }
-    if (!flag_pure_csv){
-        Serial.print(F("ind : "));
+    if (flag_pure_csv){
+      // the whole line in the buffer, and a single print
+      size_t const len_ind = snprintf(format_buff, format_buff_len, "%04i, ", ind);
+      float const line_values[3] {axis_coord, data[ind].r, data[ind].i};
+      format_floats_csv(format_buff + len_ind, format_buff_len - len_ind, line_values, 3, 12, 4);
+      Serial.println(format_buff);
+      continue;
     }
+
+    Serial.print(F("ind : "));
     snprintf(format_buff, format_buff_len, "%04i", ind);
     Serial.print(format_buff);
-    if (!flag_pure_csv){
-      Serial.print(axis_label);
-    }
-    else{
-      Serial.print(F(", "));
-    }
-    //snprintf(format_buff, format_buff_len, "%+05.2f", axis_coord);  // no snprintf for %f in arduino...
-    dtostrf(axis_coord, 12, 4, format_buff);
+    Serial.print(axis_label);
+    format_float(format_buff, format_buff_len, axis_coord, 12, 4);
     Serial.print(format_buff);
-    if (!flag_pure_csv){
-      Serial.print(F(" | f.r = "));
-    }
-    else{
-      Serial.print(F(", "));
-    }
-    dtostrf(data[ind].r, 12, 4, format_buff);
+    Serial.print(F(" | f.r = "));
+    format_float(format_buff, format_buff_len, data[ind].r, 12, 4);
     Serial.print(format_buff);
-    if (!flag_pure_csv){
-      Serial.print(F(" | f.i = "));
-    }
-    else{
-      Serial.print(F(", "));
-    }
-    dtostrf(data[ind].i, 12, 4, format_buff);
+    Serial.print(F(" | f.i = "));
+    format_float(format_buff, format_buff_len, data[ind].i, 12, 4);
     Serial.print(format_buff);
     Serial.println();
   }
@@ -0,0 +1,209 @@
+// fuzz the integer n-sigma filter (accurate_sigma_filter_int) on a computer, against a long double
+// reference, on the cases where the 64 bits overflow guarantees matter: values at the INT32 extremes,
+// constant inputs, and spreads large enough that the squared deviations need the adaptive shift.
+// Returns non zero if any check fails:
+//
+//   g++ -O2 -std=c++11 -I.. -I<path to the ETL>/include nsigma_int_fuzz.cpp -o nsigma_int_fuzz
+//   ./nsigma_int_fuzz
+//
+// (the ETL is the Embedded Template Library, https://github.com/ETLCPP/etl, header only)
+
+#include <cstdio>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include "statistical_processing.h"
+
+static constexpr size_t max_size {4096};
+static constexpr uint16_t n_sigma_tenths {20};
+
+static unsigned long nbr_errors {0};
+static unsigned long nbr_checked {0};
+static unsigned long nbr_skipped {0};
+static unsigned long nbr_shifted {0};
+
+// the shift chosen by accurate_sigma_filter_int for these values, computed the same way
+template <typename T>
+static unsigned shift_for(etl::ivector<T> const & values){
+  int64_t sum {0};
+  for (T const value : values){
+    sum += value;
+  }
+  int64_t const mean = sum / static_cast<int64_t>(values.size());
+  uint64_t max_abs_deviation {0};
+  for (T const value : values){
+    int64_t const deviation = static_cast<int64_t>(value) - mean;
+    uint64_t const abs_deviation = static_cast<uint64_t>(deviation < 0 ? -deviation : deviation);
+    max_abs_deviation = (abs_deviation > max_abs_deviation) ? abs_deviation : max_abs_deviation;
+  }
+  unsigned shift {0};
+  while ((max_abs_deviation >> shift) != 0 &&
+         (max_abs_deviation >> shift) > UINT64_MAX / values.size() / (max_abs_deviation >> shift)){
+    shift++;
+  }
+  return shift;
+}
+
+// compare with the reference; the cases with a value close to the n-sigma bound are skipped, as the
+// integer mean and std are rounded down and may then keep or drop it differently
+template <typename T>
+static void check_against_reference(etl::ivector<T> const & values, char const * what){
+  T const result = accurate_sigma_filter_int(values, n_sigma_tenths);
+
+  long double mean {0};
+  for (T const value : values){
+    mean += value;
+  }
+  mean /= values.size();
+  long double variance {0};
+  for (T const value : values){
+    variance += (value - mean) * (value - mean);
+  }
+  variance /= values.size();
+  long double const max_distance = n_sigma_tenths / 10.0L * sqrtl(variance);
+
+  unsigned const shift = shift_for(values);
+  if (shift > 0){
+    nbr_shifted++;
+  }
+  long double const tolerance = 4.0L + n_sigma_tenths / 10.0L * 2.0L * ldexpl(1.0L, shift) + 1.0e-9L * max_distance;
+
+  long double sum_kept {0};
+  unsigned long nbr_kept {0};
+  for (T const value : values){
+    long double const distance = fabsl(value - mean);
+    if (fabsl(distance - max_distance) <= tolerance){
+      nbr_skipped++;
+      return;
+    }
+    if (distance <= max_distance){
+      sum_kept += value;
+      nbr_kept++;
+    }
+  }
+  long double const reference = sum_kept / nbr_kept;
+
+  nbr_checked++;
+  if (fabsl(result - reference) > 1.0L){
+    nbr_errors++;
+    if (nbr_errors < 10){
+      printf("ERROR %s: size %zu, result %ld, reference %.3Lf, shift %u\n", what, values.size(), static_cast<long>(result), reference, shift);
+    }
+  }
+}
+
+static void check_isqrt(void){
+  std::mt19937_64 generator {5};
+
+  auto check_one = [](uint64_t const value){
+    uint64_t const root = isqrt_u64(value);
+    bool const below = (root <= 0xFFFFFFFFu) && (root * root <= value);
+    bool const above = (root == 0xFFFFFFFFu) || ((root + 1) * (root + 1) > value);
+    if (!below || !above){
+      nbr_errors++;
+      printf("ERROR isqrt_u64(%llu) = %llu\n", static_cast<unsigned long long>(value), static_cast<unsigned long long>(root));
+    }
+  };
+
+  for (uint64_t value=0; value<100000; value++){
+    check_one(value);
+  }
+  for (int ind=0; ind<100000; ind++){
+    uint64_t const root = generator() >> 32;
+    uint64_t const square = root * root;
+    check_one(square);
+    check_one(square - 1);
+    check_one(square + 1);
+    check_one(generator());
+  }
+  check_one(UINT64_MAX);
+  check_one(UINT64_MAX - 1);
+}
+
+template <typename T>
+static void check_constant(std::mt19937 & generator){
+  etl::vector<T, max_size> values;
+  T const list_constants[] {std::numeric_limits<T>::min(), static_cast<T>(std::numeric_limits<T>::min() + 1),
+                            static_cast<T>(-1), 0, 1, static_cast<T>(std::numeric_limits<T>::max() - 1), std::numeric_limits<T>::max()};
+
+  for (T const constant : list_constants){
+    for (size_t size : {static_cast<size_t>(1), static_cast<size_t>(2), static_cast<size_t>(1 + generator() % max_size), max_size}){
+      values.clear();
+      for (size_t ind=0; ind<size; ind++){
+        values.push_back(constant);
+      }
+      T const result = accurate_sigma_filter_int(values, n_sigma_tenths);
+      nbr_checked++;
+      if (result != constant){
+        nbr_errors++;
+        printf("ERROR constant %ld, size %zu: result %ld\n", static_cast<long>(constant), size, static_cast<long>(result));
+      }
+    }
+  }
+}
+
+// values at and near the extremes of T, in random proportions
+template <typename T>
+static void check_extremes(std::mt19937 & generator, int const nbr_of_cases){
+  etl::vector<T, max_size> values;
+  for (int crrt_case=0; crrt_case<nbr_of_cases; crrt_case++){
+    size_t const size = 1 + generator() % max_size;
+    unsigned const proportion_max = generator() % 101;
+    values.clear();
+    for (size_t ind=0; ind<size; ind++){
+      bool const at_max = (generator() % 100) < proportion_max;
+      T const offset = static_cast<T>(generator() % 4);
+      values.push_back(at_max ? static_cast<T>(std::numeric_limits<T>::max() - offset) : static_cast<T>(std::numeric_limits<T>::min() + offset));
+    }
+    check_against_reference(values, "extremes");
+  }
+}
+
+// a cluster around a random center, with a few outliers anywhere in the range of T: the spread is then
+// large enough for the adaptive shift with the larger sizes
+template <typename T>
+static void check_outliers(std::mt19937 & generator, int const nbr_of_cases){
+  etl::vector<T, max_size> values;
+  std::uniform_int_distribution<int64_t> any_value(std::numeric_limits<T>::min(), std::numeric_limits<T>::max());
+  for (int crrt_case=0; crrt_case<nbr_of_cases; crrt_case++){
+    size_t const size = 1 + generator() % max_size;
+    int64_t const center = any_value(generator) / 2;
+    int64_t const spread = 1 + generator() % 1000;
+    values.clear();
+    for (size_t ind=0; ind<size; ind++){
+      int64_t value = center + static_cast<int64_t>(generator() % (2 * spread + 1)) - spread;
+      if (generator() % 50 == 0){
+        value = any_value(generator);
+      }
+      values.push_back(static_cast<T>(value));
+    }
+    check_against_reference(values, "outliers");
+  }
+}
+
+int main(){
+  std::mt19937 generator {3};
+
+  check_isqrt();
+
+  check_constant<int8_t>(generator);
+  check_constant<int16_t>(generator);
+  check_constant<int32_t>(generator);
+
+  check_extremes<int8_t>(generator, 2000);
+  check_extremes<int16_t>(generator, 2000);
+  check_extremes<int32_t>(generator, 5000);
+
+  check_outliers<int16_t>(generator, 2000);
+  check_outliers<int32_t>(generator, 10000);
+
+  printf("checked %lu cases (%lu with the adaptive shift), skipped %lu close to the bound\n", nbr_checked, nbr_shifted, nbr_skipped);
+  if (nbr_shifted == 0){
+    printf("ERROR the adaptive shift was never exercised\n");
+    nbr_errors++;
+  }
+  printf("%lu errors\n", nbr_errors);
+  return (nbr_errors == 0) ? 0 : 1;
+}
@@ -108,6 +108,140 @@ void setup(){
   Serial.print(F("val_out=")); Serial.println(val_out);
   }
 
+  {
+  Serial.println();
+  // lat, lon in 1e-7 deg, alt in mm, as we would get from a GNSS; the 3rd fix is off in altitude only, and the 5th in lat only
+  Serial.println(F("test multi channel lat / lon / alt with outliers: "));
+  etl::vector<long, 6> vec_lat;
+  etl::vector<long, 6> vec_lon;
+  etl::vector<long, 6> vec_alt;
+  long lat_values[6] {598765430, 598765435, 598765428, 598765432, 598799999, 598765431};
+  long lon_values[6] {107654320, 107654325, 107654318, 107654322, 107654321, 107654319};
+  long alt_values[6] {    12000,     12010,     95000,     11990,     12005,     11995};
+  for (int ind=0; ind<6; ind++){
+    vec_lat.push_back(lat_values[ind]);
+    vec_lon.push_back(lon_values[ind]);
+    vec_alt.push_back(alt_values[ind]);
+  }
+  etl::ivector<long> const * channels[3] {&vec_lat, &vec_lon, &vec_alt};
+  long means_out[3];
+
+  bool valid = accurate_multi_sigma_filter(channels, means_out, 2.0, SigmaRejection::any_channel_out);
+  Serial.print(F("any channel out: valid=")); Serial.print(valid);
+  Serial.print(F(" lat=")); Serial.print(means_out[0]);
+  Serial.print(F(" lon=")); Serial.print(means_out[1]);
+  Serial.print(F(" alt=")); Serial.println(means_out[2]);
+
+  valid = accurate_multi_sigma_filter(channels, means_out, 2.0, SigmaRejection::normalized_distance);
+  Serial.print(F("normalized distance: valid=")); Serial.print(valid);
+  Serial.print(F(" lat=")); Serial.print(means_out[0]);
+  Serial.print(F(" lon=")); Serial.print(means_out[1]);
+  Serial.print(F(" alt=")); Serial.println(means_out[2]);
+  }
+
+  {
+  Serial.println();
+  Serial.println(F("test multi channel with channels of different lengths: "));
+  etl::vector<long, 5> vec_1;
+  etl::vector<long, 5> vec_2;
+  vec_1.push_back(1);
+  vec_1.push_back(2);
+  vec_2.push_back(1);
+  etl::ivector<long> const * channels[2] {&vec_1, &vec_2};
+  long means_out[2];
+  bool valid = accurate_multi_sigma_filter(channels, means_out);
+  Serial.print(F("valid=")); Serial.println(valid);
+  }
+
+  {
+  Serial.println();
+  Serial.println(F("test integer only filter against the double filter, random data and extreme values: "));
+  constexpr int nbr_of_trials {200};
+  int nbr_of_mismatches {0};
+  etl::vector<long, 64> vec_in;
+  for (int trial=0; trial<nbr_of_trials; trial++){
+    vec_in.clear();
+    int crrt_size = random(1, 65);
+    for (int ind=0; ind<crrt_size; ind++){
+      if (trial % 2 == 0){
+        // lat-like data with a few outliers
+        vec_in.push_back(598765430L + random(-50, 50) + ((random(0, 20) == 0) ? 100000L : 0L));
+      }
+      else{
+        // values close to the extremes of the long range, to check for overflows
+        vec_in.push_back((random(0, 2) == 0) ? (2147483647L - random(0, 5)) : (-2147483647L + random(0, 5)));
+      }
+    }
+    long val_double = accurate_sigma_filter(vec_in, 2.0);
+    long val_int = accurate_sigma_filter_int(vec_in, 20);
+    // the 2 paths can differ by 1 from the rounding, or by a bit more when a point is on the n-sigma boundary
+    if (abs(val_double - val_int) > 1){
+      nbr_of_mismatches++;
+    }
+  }
+  Serial.print(F("nbr of mismatches: ")); Serial.print(nbr_of_mismatches); Serial.print(F(" out of ")); Serial.println(nbr_of_trials);
+  }
+
+  {
+  Serial.println();
+  Serial.println(F("benchmark integer only filter against the double filter: "));
+  constexpr int nbr_of_repeats {100};
+  etl::vector<long, 64> vec_in;
+  for (int ind=0; ind<64; ind++){
+    vec_in.push_back(598765430L + random(-50, 50) + ((ind % 16 == 0) ? 100000L : 0L));
+  }
+
+  volatile long val_out;
+  unsigned long micros_start = micros();
+  for (int repeat=0; repeat<nbr_of_repeats; repeat++){
+    val_out = accurate_sigma_filter(vec_in, 2.0);
+  }
+  unsigned long micros_double = micros() - micros_start;
+
+  micros_start = micros();
+  for (int repeat=0; repeat<nbr_of_repeats; repeat++){
+    val_out = accurate_sigma_filter_int(vec_in, 20);
+  }
+  unsigned long micros_int = micros() - micros_start;
+
+  Serial.print(F("64 samples, double path [us per call]: ")); Serial.print(micros_double / nbr_of_repeats);
+  Serial.print(F(" | int path [us per call]: ")); Serial.println(micros_int / nbr_of_repeats);
+  }
+
+  {
+  Serial.println();
+  Serial.println(F("test float kernel against the double path, and benchmark: "));
+  // static, these are large
+  static etl::vector<float, 10000> vec_float;
+  static etl::vector<double, 10000> vec_double;
+  for (size_t ind=0; ind<vec_float.capacity(); ind++){
+    float crrt_value = 1234.5f + static_cast<float>(random(-3000, 3000)) / 1000.0f + ((ind % 97 == 0) ? 500.0f : 0.0f);
+    vec_float.push_back(crrt_value);
+    vec_double.push_back(static_cast<double>(crrt_value));
+  }
+
+  unsigned long micros_start = micros();
+  float val_float = accurate_sigma_filter(vec_float, 2.0);
+  unsigned long micros_float = micros() - micros_start;
+
+  micros_start = micros();
+  double val_double = accurate_sigma_filter(vec_double, 2.0);
+  unsigned long micros_double = micros() - micros_start;
+
+  // the compensated sums should keep the relative error within a few float epsilons
+  double relative_error = fabs(static_cast<double>(val_float) - val_double) / fabs(val_double);
+  Serial.print(F("relative error float vs double: ")); Serial.print(relative_error * 1.0e6, 4); Serial.print(F(" ppm"));
+  if (relative_error < 1.0e-6){
+    Serial.println(F(" OK"));
+  }
+  else{
+    Serial.println(F(" ERROR: too large"));
+  }
+
+  Serial.print(F("10000 samples, float kernel [us]: ")); Serial.print(micros_float);
+  Serial.print(F(" | double path [us]: ")); Serial.println(micros_double);
+  }
+
 }
 
 void loop(){
@@ -1,9 +1,15 @@
 #ifndef STAT_PROCESSING
 #define STAT_PROCESSING
 
-#include "Arduino.h"
+// on a computer (see extras/), only the ETL include directory is needed
+#ifdef ARDUINO
+  #include "Arduino.h"
+  #include "etl.h"
+#endif
+
+#include <stdint.h>
+#include <type_traits>
 
-#include "etl.h"
 #include "etl/vector.h"
 
 #include "math.h"
@@ -138,6 +144,395 @@ T accurate_sigma_filter(etl::ivector<T> const & vec_in, double n_sigma=2.0, bool
   return (coarse_mean + fine_mean);
 }
 
+// float kernels: on the Apollo3 (Cortex-M4F) the FPU is single precision only, so for float inputs we want to stay in float
+// all the way. To keep the accuracy, the sums are computed by blocks: inside a block, the values are accumulated in
+// stat_float_lanes independent partial sums (which the compiler can map to SIMD registers on the host) that are then
+// reduced pairwise, and the block sums are accumulated with Kahan compensation. The relative error of the sums is then
+// about (stat_float_block_size / stat_float_lanes + 2) * FLT_EPSILON, independently of the number of samples.
+// NOTE: do not compile with -ffast-math, this would optimize the Kahan compensation away.
+constexpr size_t stat_float_lanes {8};
+constexpr size_t stat_float_block_size {128};
+
+template <typename Transform>
+float block_compensated_sum(float const * data, size_t size, Transform transform){
+  float total {0.0f};
+  float compensation {0.0f};
+
+  size_t ind {0};
+  while (ind < size){
+    size_t block_end = (size - ind > stat_float_block_size) ? ind + stat_float_block_size : size;
+    size_t lanes_end = ind + ((block_end - ind) / stat_float_lanes) * stat_float_lanes;
+
+    float lanes[stat_float_lanes] {};
+    for (; ind<lanes_end; ind+=stat_float_lanes){
+      for (size_t crrt_lane=0; crrt_lane<stat_float_lanes; crrt_lane++){
+        lanes[crrt_lane] += transform(data[ind + crrt_lane]);
+      }
+    }
+    for (; ind<block_end; ind++){
+      lanes[0] += transform(data[ind]);
+    }
+
+    for (size_t width=stat_float_lanes/2; width>0; width/=2){
+      for (size_t crrt_lane=0; crrt_lane<width; crrt_lane++){
+        lanes[crrt_lane] += lanes[crrt_lane + width];
+      }
+    }
+
+    float compensated_block_sum = lanes[0] - compensation;
+    float new_total = total + compensated_block_sum;
+    compensation = (new_total - total) - compensated_block_sum;
+    total = new_total;
+  }
+
+  return total;
+}
+
+// the n-sigma filter on raw float data, in float arithmetics only; the kept points are accumulated as deviations to the
+// mean, with a branchless select, so that this loop can be vectorized too
+inline float float_sigma_filter_kernel(float const * data, size_t size, float n_sigma=2.0f){
+  if (n_sigma < 1.5f){
+    n_sigma = 1.5f;
+    #if STAT_PROCESSING_VERBOSE
+      Serial.println(F("we were using unsafe small n_sigma; set it to 1.5"));
+    #endif
+  }
+
+  if (size == 0){
+    #if STAT_PROCESSING_VERBOSE
+      Serial.println(F("empty vector, return 0"));
+    #endif
+    return 0.0f;
+  }
+
+  float const size_as_float = static_cast<float>(size);
+
+  float const mean = block_compensated_sum(data, size, [](float value){return value;}) / size_as_float;
+
+  float const variance = block_compensated_sum(data, size, [mean](float value){
+    return (value - mean) * (value - mean);
+  }) / size_as_float;
+
+  float const max_distance = n_sigma * sqrtf(variance);
+
+  float const sum_valid_deviations = block_compensated_sum(data, size, [mean, max_distance](float value){
+    return (fabsf(value - mean) <= max_distance) ? (value - mean) : 0.0f;
+  });
+
+  size_t nbr_of_valid_points {0};
+  for (size_t ind=0; ind<size; ind++){
+    nbr_of_valid_points += (fabsf(data[ind] - mean) <= max_distance) ? 1 : 0;
+  }
+
+  #if STAT_PROCESSING_VERBOSE
+    Serial.print(F("float mean = ")); Serial.println(mean);
+    Serial.print(F("float max_distance = ")); Serial.println(max_distance);
+    Serial.print(F("nbr_of_valid_points ")); Serial.println(nbr_of_valid_points);
+  #endif
+
+  return mean + sum_valid_deviations / static_cast<float>(nbr_of_valid_points);
+}
+
+// float inputs use the float kernel rather than promoting everything to double
+template <>
+inline float accurate_sigma_filter<float>(etl::ivector<float> const & vec_in, double n_sigma, bool verbose){
+  return float_sigma_filter_kernel(vec_in.data(), vec_in.size(), static_cast<float>(n_sigma));
+}
+
+// integer square root, rounded down, i.e. the largest r such that r * r <= value; bit by bit method, no floating point
+inline uint64_t isqrt_u64(uint64_t value){
+  uint64_t res {0};
+  uint64_t bit = static_cast<uint64_t>(1) << 62;
+
+  while (bit > value){
+    bit >>= 2;
+  }
+
+  while (bit != 0){
+    if (value >= res + bit){
+      value -= res + bit;
+      res = (res >> 1) + bit;
+    }
+    else{
+      res >>= 1;
+    }
+    bit >>= 2;
+  }
+
+  return res;
+}
+
+// the same n-sigma filter as accurate_sigma_filter, but in integer arithmetics only, without any double operation; on the
+// Apollo3 the FPU is single precision only, so all double operations are emulated in software and are slow.
+// n_sigma is given in tenths, i.e. n_sigma_tenths=20 is a 2.0 sigma filter.
+// overflow guarantees: T is at most 32 bits, so that 1) the sums of up to 2^32 values fit in int64_t, and 2) the deviations
+// to the mean fit in 33 bits; the squared deviations are right shifted by a common number of bits chosen from the largest
+// deviation and the number of samples so that their sum always fits in uint64_t (this only loses precision on the std when
+// the spread of the data is larger than about 2^31 / sqrt(size)).
+template <typename T>
+T accurate_sigma_filter_int(etl::ivector<T> const & vec_in, uint16_t n_sigma_tenths=20){
+  static_assert(std::is_signed<T>::value, "signed values only");
+  static_assert(std::is_integral<T>::value, "integral values only; use accurate_sigma_filter for floating points");
+  static_assert(sizeof(T) <= 4, "at most 32 bits values, so that the 64 bits accumulators cannot overflow");
+
+  // same lower bound on n_sigma as in accurate_sigma_filter
+  if (n_sigma_tenths < 15){
+    n_sigma_tenths = 15;
+    #if STAT_PROCESSING_VERBOSE
+      Serial.println(F("we were using unsafe small n_sigma; set it to 1.5"));
+    #endif
+  }
+
+  size_t const nbr_of_samples = vec_in.size();
+
+  if (nbr_of_samples == 0){
+    #if STAT_PROCESSING_VERBOSE
+      Serial.println(F("empty vector, return 0"));
+    #endif
+    return 0;
+  }
+
+  // the mean, in 64 bits
+  int64_t sum {0};
+  for (T const & crrt_value : vec_in){
+    sum += static_cast<int64_t>(crrt_value);
+  }
+  int64_t const mean = sum / static_cast<int64_t>(nbr_of_samples);
+
+  // the largest deviation to the mean; if it is 0, all elements are equal
+  uint64_t max_abs_deviation {0};
+  for (T const & crrt_value : vec_in){
+    int64_t crrt_deviation = static_cast<int64_t>(crrt_value) - mean;
+    uint64_t crrt_abs_deviation = static_cast<uint64_t>(crrt_deviation < 0 ? -crrt_deviation : crrt_deviation);
+    if (crrt_abs_deviation > max_abs_deviation){
+      max_abs_deviation = crrt_abs_deviation;
+    }
+  }
+
+  if (max_abs_deviation == 0){
+    #if STAT_PROCESSING_VERBOSE
+      Serial.println(F("all elements equal, use the first element"));
+    #endif
+    return vec_in[0];
+  }
+
+  // choose the shift so that nbr_of_samples * (max_abs_deviation >> shift)^2 fits in a uint64_t
+  uint8_t shift {0};
+  while ((max_abs_deviation >> shift) > UINT64_MAX / static_cast<uint64_t>(nbr_of_samples) / (max_abs_deviation >> shift)){
+    shift++;
+  }
+
+  uint64_t sum_square_deviations {0};
+  for (T const & crrt_value : vec_in){
+    int64_t crrt_deviation = static_cast<int64_t>(crrt_value) - mean;
+    uint64_t crrt_abs_deviation = static_cast<uint64_t>(crrt_deviation < 0 ? -crrt_deviation : crrt_deviation) >> shift;
+    sum_square_deviations += crrt_abs_deviation * crrt_abs_deviation;
+  }
+
+  // std < 2^33, n_sigma_tenths < 2^16, so the max distance fits comfortably
+  uint64_t const std_dev = isqrt_u64(sum_square_deviations / static_cast<uint64_t>(nbr_of_samples)) << shift;
+  uint64_t const max_distance = std_dev * n_sigma_tenths / 10;
+
+  #if STAT_PROCESSING_VERBOSE
+    Serial.print(F("int mean = ")); Serial.println(static_cast<long>(mean));
+    Serial.print(F("int std = ")); Serial.println(static_cast<unsigned long>(std_dev));
+    Serial.print(F("int max_distance = ")); Serial.println(static_cast<unsigned long>(max_distance));
+  #endif
+
+  // the mean of the kept points; the 64 bits sum is exact, so no need for the coarse / fine split
+  int64_t sum_valid {0};
+  int64_t nbr_of_valid_points {0};
+  for (T const & crrt_value : vec_in){
+    int64_t crrt_deviation = static_cast<int64_t>(crrt_value) - mean;
+    uint64_t crrt_abs_deviation = static_cast<uint64_t>(crrt_deviation < 0 ? -crrt_deviation : crrt_deviation);
+    if (crrt_abs_deviation <= max_distance){
+      sum_valid += static_cast<int64_t>(crrt_value);
+      nbr_of_valid_points++;
+    }
+  }
+
+  #if STAT_PROCESSING_VERBOSE
+    Serial.print(F("nbr_of_valid_points ")); Serial.println(static_cast<long>(nbr_of_valid_points));
+  #endif
+
+  return static_cast<T>(sum_valid / nbr_of_valid_points);
+}
+
+// how to decide, in the multi channel n-sigma filter, if a sample (i.e. a tuple of values taken at the same index
+// in all channels) is an outlier
+enum class SigmaRejection{
+  // reject the sample if any of its channels is further away than n_sigma std from the mean of this channel
+  any_channel_out,
+  // reject the sample if its distance to the mean, normalized by the std of each channel, is larger than n_sigma;
+  // this is the Mahalanobis distance when neglecting the covariance between channels
+  normalized_distance
+};
+
+// is the sample at index ind within the n_sigma bound, given the per channel means and max distances
+// (i.e. n_sigma * std) computed by the multi channel n-sigma filter
+template <typename T, size_t K>
+bool multi_sigma_keep_sample(etl::ivector<T> const * const (& channels)[K], size_t ind,
+                             double const (& double_means)[K], double const (& double_max_distances)[K],
+                             SigmaRejection rejection){
+  if (rejection == SigmaRejection::any_channel_out){
+    for (size_t crrt_channel=0; crrt_channel<K; crrt_channel++){
+      double crrt_value = static_cast<double>((*channels[crrt_channel])[ind]);
+      if (fabs(crrt_value - double_means[crrt_channel]) > double_max_distances[crrt_channel]){
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // normalized distance: compare sum((x - mean)^2 / std^2) to n_sigma^2, i.e. sum((x - mean)^2 / max_distance^2) to 1;
+  // a channel with 0 std is constant, and always exactly at its mean, so it does not contribute
+  double normalized_distance_square {0.0};
+  for (size_t crrt_channel=0; crrt_channel<K; crrt_channel++){
+    if (double_max_distances[crrt_channel] > 0.0){
+      double crrt_value = static_cast<double>((*channels[crrt_channel])[ind]);
+      double crrt_distance = (crrt_value - double_means[crrt_channel]) / double_max_distances[crrt_channel];
+      normalized_distance_square += crrt_distance * crrt_distance;
+    }
+  }
+  return (normalized_distance_square <= 1.0);
+}
+
+// a multi channel n-sigma filter: the channels (for example lat, lon, alt) are provided as a structure of arrays,
+// i.e. one vector per channel, all with the same length; a sample (i.e. the values at a given index in all channels)
+// is either kept or rejected jointly, so that the means we get for the different channels are computed on the same
+// set of samples and are coherent with each other; all channel means are computed in a shared pass over the data.
+// the same care as in accurate_sigma_filter is taken to avoid overflows and keep accuracy.
+// return false if the input is not valid (no sample, or channels with different lengths); in this case, means_out
+// is filled with 0s.
+template <typename T, size_t K>
+bool accurate_multi_sigma_filter(etl::ivector<T> const * const (& channels)[K], T (& means_out)[K],
+                                 double n_sigma=2.0, SigmaRejection rejection=SigmaRejection::any_channel_out){
+  static_assert(std::is_signed<T>::value, "signed values only; we rely on signed arithmetics to compute the mean while avoiding overflows");
+  static_assert(K > 0, "need at least one channel");
+
+  for (size_t crrt_channel=0; crrt_channel<K; crrt_channel++){
+    means_out[crrt_channel] = 0;
+  }
+
+  // same lower bound as for the single channel filter; in the normalized_distance case, the bound on the number of
+  // kept samples is even more generous
+  if (n_sigma < 1.5){
+    n_sigma = 1.5;
+    #if STAT_PROCESSING_VERBOSE
+      Serial.println(F("we were using unsafe small n_sigma; set it to 1.5"));
+    #endif
+  }
+
+  size_t const nbr_of_samples = channels[0]->size();
+
+  for (size_t crrt_channel=1; crrt_channel<K; crrt_channel++){
+    if (channels[crrt_channel]->size() != nbr_of_samples){
+      #if STAT_PROCESSING_VERBOSE
+        Serial.println(F("channels with different lengths, return 0s"));
+      #endif
+      return false;
+    }
+  }
+
+  if (nbr_of_samples == 0){
+    #if STAT_PROCESSING_VERBOSE
+      Serial.println(F("empty vectors, return 0s"));
+    #endif
+    return false;
+  }
+
+  double const vec_len_as_double = static_cast<double>(nbr_of_samples);
+
+  // calculate the double means of all channels in a shared pass
+  double double_means[K] {};
+  for (size_t ind=0; ind<nbr_of_samples; ind++){
+    for (size_t crrt_channel=0; crrt_channel<K; crrt_channel++){
+      double crrt_value = static_cast<double>((*channels[crrt_channel])[ind]);
+      double_means[crrt_channel] += crrt_value / vec_len_as_double;
+    }
+  }
+
+  // calculate the double rms of all channels in a shared pass
+  double double_rms[K] {};
+  for (size_t ind=0; ind<nbr_of_samples; ind++){
+    for (size_t crrt_channel=0; crrt_channel<K; crrt_channel++){
+      double crrt_value = static_cast<double>((*channels[crrt_channel])[ind]);
+      double crrt_deviation = crrt_value - double_means[crrt_channel];
+      double_rms[crrt_channel] += crrt_deviation * crrt_deviation / vec_len_as_double;
+    }
+  }
+
+  // calculate the max distances
+  double double_max_distances[K];
+  for (size_t crrt_channel=0; crrt_channel<K; crrt_channel++){
+    double_max_distances[crrt_channel] = n_sigma * sqrt(double_rms[crrt_channel]);
+
+    #if STAT_PROCESSING_VERBOSE
+      Serial.print(F("channel ")); Serial.print(crrt_channel);
+      Serial.print(F(" double_mean = ")); Serial.print(double_means[crrt_channel]);
+      Serial.print(F(" double_max_distance = ")); Serial.println(double_max_distances[crrt_channel]);
+    #endif
+  }
+
+  // coarse means over the jointly kept samples; compute in double first and divide after, to avoid overflows
+  double double_coarse_means[K] {};
+  size_t nbr_of_valid_points {0};
+
+  for (size_t ind=0; ind<nbr_of_samples; ind++){
+    if (multi_sigma_keep_sample(channels, ind, double_means, double_max_distances, rejection)){
+      for (size_t crrt_channel=0; crrt_channel<K; crrt_channel++){
+        double_coarse_means[crrt_channel] += static_cast<double>((*channels[crrt_channel])[ind]);
+      }
+      nbr_of_valid_points ++;
+    }
+  }
+
+  // in the normalized_distance case with a tiny n_sigma we could in theory reject all samples; fall back on the
+  // plain means in this case rather than dividing by 0
+  if (nbr_of_valid_points == 0){
+    #if STAT_PROCESSING_VERBOSE
+      Serial.println(F("no valid point, use the plain means"));
+    #endif
+    for (size_t crrt_channel=0; crrt_channel<K; crrt_channel++){
+      means_out[crrt_channel] = static_cast<T>(double_means[crrt_channel]);
+    }
+    return true;
+  }
+
+  T coarse_means[K];
+  for (size_t crrt_channel=0; crrt_channel<K; crrt_channel++){
+    coarse_means[crrt_channel] = static_cast<T>(double_coarse_means[crrt_channel] / static_cast<double>(nbr_of_valid_points));
+  }
+
+  #if STAT_PROCESSING_VERBOSE
+    Serial.print(F("nbr_of_valid_points ")); Serial.println(nbr_of_valid_points);
+  #endif
+
+  // fine means (relative to the coarse means), on exactly the same set of samples
+  T fine_means[K] {};
+
+  for (size_t ind=0; ind<nbr_of_samples; ind++){
+    if (multi_sigma_keep_sample(channels, ind, double_means, double_max_distances, rejection)){
+      for (size_t crrt_channel=0; crrt_channel<K; crrt_channel++){
+        fine_means[crrt_channel] += (*channels[crrt_channel])[ind] - coarse_means[crrt_channel];
+      }
+    }
+  }
+
+  for (size_t crrt_channel=0; crrt_channel<K; crrt_channel++){
+    fine_means[crrt_channel] /= static_cast<T>(nbr_of_valid_points);
+    means_out[crrt_channel] = coarse_means[crrt_channel] + fine_means[crrt_channel];
+
+    #if STAT_PROCESSING_VERBOSE
+      Serial.print(F("channel ")); Serial.print(crrt_channel);
+      Serial.print(F(" coarse_mean = ")); Serial.print(coarse_means[crrt_channel]);
+      Serial.print(F(" fine_mean = ")); Serial.println(fine_means[crrt_channel]);
+    #endif
+  }
+
+  return true;
+}
+
 // TODO: change to modern looping
 // TODO: provide also the std in the same way
 
@@ -0,0 +1,97 @@
+#ifndef DS18B20_CALIBRATION_H
+#define DS18B20_CALIBRATION_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+#include "ds18b20_string.h"
+
+// batched decode of the temperatures of a thermistor string: the raw readings of a whole conversion
+// (int16, 1/16 deg C, see Ds18b20String::raw_temperatures) are converted in a single pass, with a
+// calibration per sensor:
+//   T = gain * raw / 16 + offset
+// either to float deg C, or to int16 centi deg C (integer arithmetic only, rounded to nearest), which
+// is exact to the resolution of the sensors and half the size for logging.
+//
+// the calibration table is given per sensor ID, so that it does not depend on the order along the
+// string; it is resolved once, when the IDs are known, into coefficients in sensor order, so that the
+// decode itself is one multiply add per sensor. The sensors without an entry get gain 1, offset 0.
+// extras/ds18b20_string_sim.cpp checks both decodes against a double reference.
+
+// the centi deg C given for a sensor with an invalid scratchpad
+constexpr int16_t ds18b20_invalid_centi {INT16_MIN};
+
+struct Ds18b20CalibrationEntry{
+  uint64_t id;
+  float offset_celsius;
+  float gain;
+};
+
+template <size_t max_nbr_sensors>
+class Ds18b20Calibration{
+  public:
+    // the coefficients for the sensors ids, in this order (the order of the measurements), from
+    // the nbr_entries entries of table; returns the number of sensors that have an entry
+    size_t resolve(uint64_t const * ids, size_t const nbr_ids, Ds18b20CalibrationEntry const * table, size_t const nbr_entries){
+      nbr_sensors = (nbr_ids < max_nbr_sensors) ? nbr_ids : max_nbr_sensors;
+      size_t nbr_calibrated {0};
+
+      for (size_t ind=0; ind<nbr_sensors; ind++){
+        float offset_celsius {0.0f};
+        float gain {1.0f};
+        for (size_t entry=0; entry<nbr_entries; entry++){
+          if (table[entry].id == ids[ind]){
+            offset_celsius = table[entry].offset_celsius;
+            gain = table[entry].gain;
+            nbr_calibrated++;
+            break;
+          }
+        }
+
+        scale[ind] = gain / 16.0f;
+        offset[ind] = offset_celsius;
+        // centi deg C in Q16: raw * gain * 100 / 16 * 2^16 + offset * 100 * 2^16; the offset must be
+        // within the int16 centi deg C range, +-327 deg C, to fit in the int32
+        scale_centi_q16[ind] = static_cast<int32_t>(lround(gain * (100.0 / 16.0) * 65536.0));
+        offset_centi_q16[ind] = static_cast<int32_t>(lround(offset_celsius * 100.0 * 65536.0));
+      }
+
+      return nbr_calibrated;
+    }
+
+    size_t size(void) const{
+      return nbr_sensors;
+    }
+
+    // decode the size() raw readings to deg C; NAN for the invalid ones
+    void decode(int16_t const * const raw, float * const celsius_out) const{
+      for (size_t ind=0; ind<nbr_sensors; ind++){
+        celsius_out[ind] = (raw[ind] == ds18b20_invalid_raw) ? NAN : raw[ind] * scale[ind] + offset[ind];
+      }
+    }
+
+    // decode the size() raw readings to centi deg C; ds18b20_invalid_centi for the invalid ones, and
+    // saturated to the int16 range otherwise
+    void decode_centi(int16_t const * const raw, int16_t * const centi_out) const{
+      for (size_t ind=0; ind<nbr_sensors; ind++){
+        if (raw[ind] == ds18b20_invalid_raw){
+          centi_out[ind] = ds18b20_invalid_centi;
+          continue;
+        }
+
+        int64_t const centi_q16 = static_cast<int64_t>(raw[ind]) * scale_centi_q16[ind] + offset_centi_q16[ind] + (1 << 15);
+        int64_t const centi = centi_q16 >> 16;
+        centi_out[ind] = static_cast<int16_t>((centi > INT16_MAX) ? INT16_MAX : ((centi <= INT16_MIN) ? INT16_MIN + 1 : centi));
+      }
+    }
+
+  private:
+    float scale[max_nbr_sensors];
+    float offset[max_nbr_sensors];
+    int32_t scale_centi_q16[max_nbr_sensors];
+    int32_t offset_centi_q16[max_nbr_sensors];
+    size_t nbr_sensors {0};
+};
+
+#endif
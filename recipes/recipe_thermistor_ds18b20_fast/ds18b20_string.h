@@ -0,0 +1,336 @@
+#ifndef DS18B20_STRING_H
+#define DS18B20_STRING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <kiss_crc.h>
+
+// non blocking driver for a string of DS18B20 sensors on a single 1-Wire bus:
+// - a single Skip ROM + Convert T broadcast starts the conversion on all the sensors at once, so
+//   that a full string is sampled in one conversion time rather than one per sensor;
+// - the end of the conversion is detected either with read slots (the DS18B20 answers 0 while
+//   converting, 1 when done; only with an external power supply) or with a timer matched to the
+//   conversion time (parasite power: the bus must then be held high during the conversion);
+// - the scratchpads are then read one sensor per call, each in a single 9 bytes burst;
+// - the resolution (9 to 12 bits) can be written to all the sensors at once, and optionally
+//   persisted to their EEPROM, and the conversion time follows from it.
+//
+// poll() never waits: each call does at most one short bus transaction (a read slot, or one
+// scratchpad read, a few ms) and returns, so that the loop can do other work in between.
+//
+// the driver is templated on the bus (OneWire on the Artemis), so that it can be simulated on a
+// computer with a fake bus, see extras/ds18b20_string_sim.cpp. The CRCs are checked with the table
+// driven CRC8 of libraries/kiss_crc.
+
+constexpr uint8_t ds18b20_family_code {0x28};
+constexpr size_t ds18b20_scratchpad_length {9};
+// the raw temperature given for a sensor with an invalid scratchpad; out of the range of the sensor
+constexpr int16_t ds18b20_invalid_raw {INT16_MIN};
+
+// the 1-Wire commands used
+constexpr uint8_t one_wire_skip_rom {0xCC};
+constexpr uint8_t ds18b20_convert_t {0x44};
+constexpr uint8_t ds18b20_read_scratchpad {0xBE};
+constexpr uint8_t ds18b20_write_scratchpad {0x4E};
+constexpr uint8_t ds18b20_copy_scratchpad {0x48};
+
+// the values of the configuration register; lower resolutions convert faster, each bit less halves
+// the conversion time
+enum class Ds18b20Resolution : uint8_t {
+  bits_9 = 0x1F,   // 0.5 deg C, 93.75 ms
+  bits_10 = 0x3F,  // 0.25 deg C, 187.5 ms
+  bits_11 = 0x5F,  // 0.125 deg C, 375 ms
+  bits_12 = 0x7F,  // 0.0625 deg C, 750 ms
+};
+
+// the max conversion time from the datasheet, rounded up to the ms
+constexpr uint32_t ds18b20_conversion_time_ms(Ds18b20Resolution const resolution){
+  return (resolution == Ds18b20Resolution::bits_9) ? 94 :
+         (resolution == Ds18b20Resolution::bits_10) ? 188 :
+         (resolution == Ds18b20Resolution::bits_11) ? 375 : 750;
+}
+
+// the factory values of the alarm registers, that are written together with the configuration
+constexpr uint8_t ds18b20_default_alarm_high {0x4B};
+constexpr uint8_t ds18b20_default_alarm_low {0x46};
+
+enum class Ds18b20Completion : uint8_t {
+  read_slot,  // poll the bus; needs an external power supply
+  timer,      // wait for the conversion time; works also with parasite power
+};
+
+enum class Ds18b20State : uint8_t {
+  idle,
+  converting,
+  reading,
+  copying,  // copying the scratchpad to the EEPROM
+};
+
+struct Ds18b20Counters{
+  uint32_t conversions {0};
+  uint32_t scratchpads_read {0};
+  // scratchpads with a wrong CRC, usually a bad contact or a too long / unterminated cable
+  uint32_t crc_errors {0};
+  // no presence pulse answered to a reset, i.e. nothing on the bus anymore
+  uint32_t presence_errors {0};
+  // conversions that did not report done in time when polling with read slots
+  uint32_t timeouts {0};
+};
+
+// the 1-Wire address (ROM code) from the uint64_t ID, with the same layout as in the recipe: the
+// first ROM byte (the family code) is the most significant byte of the ID
+inline void ds18b20_id_to_address(uint64_t const id, uint8_t address[8]){
+  for (int ind=0; ind<8; ind++){
+    address[ind] = static_cast<uint8_t>(id >> (8 * (7 - ind)));
+  }
+}
+
+// the temperature, in 1/16 deg C, of a scratchpad; the undefined low bits at the resolutions lower
+// than 12 bits are cleared
+inline int16_t ds18b20_raw_temperature(uint8_t const scratchpad[ds18b20_scratchpad_length]){
+  int16_t raw = static_cast<int16_t>((static_cast<uint16_t>(scratchpad[1]) << 8) | scratchpad[0]);
+  switch (scratchpad[4] & 0x60){
+    case 0x00: raw &= ~7; break;  // 9 bits
+    case 0x20: raw &= ~3; break;  // 10 bits
+    case 0x40: raw &= ~1; break;  // 11 bits
+    default: break;               // 12 bits
+  }
+  return raw;
+}
+
+inline float ds18b20_temperature_celsius(uint8_t const scratchpad[ds18b20_scratchpad_length]){
+  return ds18b20_raw_temperature(scratchpad) / 16.0f;
+}
+
+//--------------------------------------------------------------------------------
+template <typename Bus, size_t max_nbr_sensors>
+class Ds18b20String{
+  public:
+    Ds18b20String(Bus & bus, Ds18b20Completion const completion): bus(bus), completion(completion) {}
+
+    // the sensors to read, as uint64_t IDs, in the order in which they should be reported; returns
+    // false (and keeps only the first ones) if there are more than max_nbr_sensors
+    bool set_sensors(uint64_t const * ids, size_t const nbr_ids){
+      nbr_sensors = (nbr_ids < max_nbr_sensors) ? nbr_ids : max_nbr_sensors;
+      for (size_t ind=0; ind<nbr_sensors; ind++){
+        ds18b20_id_to_address(ids[ind], addresses[ind]);
+        valid_scratchpad[ind] = false;
+      }
+      return nbr_ids <= max_nbr_sensors;
+    }
+
+    // start a conversion on all the sensors at once; returns false if busy with the previous one,
+    // or if no sensor answered the reset
+    bool start_conversion(uint32_t const now_ms){
+      if (state != Ds18b20State::idle){
+        return false;
+      }
+
+      if (!bus.reset()){
+        crrt_counters.presence_errors++;
+        return false;
+      }
+      bus.skip();
+      // with parasite power the bus must stay strongly pulled up during the conversion
+      bus.write(ds18b20_convert_t, (completion == Ds18b20Completion::timer) ? 1 : 0);
+
+      crrt_counters.conversions++;
+      conversion_start_ms = now_ms;
+      state = Ds18b20State::converting;
+      return true;
+    }
+
+    // advance the state machine; returns true once, when all the scratchpads of the conversion
+    // have been read (valid(ind) tells which ones have a good CRC)
+    bool poll(uint32_t const now_ms){
+      switch (state){
+        case Ds18b20State::idle:
+          return false;
+
+        case Ds18b20State::converting:{
+          uint32_t const elapsed_ms = now_ms - conversion_start_ms;
+          bool done {false};
+
+          if (completion == Ds18b20Completion::timer){
+            done = elapsed_ms >= conversion_time_ms;
+          }
+          else if (bus.read_bit()){
+            done = true;
+          }
+          else if (elapsed_ms >= conversion_time_ms + conversion_time_ms / 2){
+            crrt_counters.timeouts++;
+            done = true;
+          }
+
+          if (done){
+            crrt_sensor = 0;
+            state = Ds18b20State::reading;
+          }
+          return false;
+        }
+
+        case Ds18b20State::reading:
+          if (crrt_sensor < nbr_sensors){
+            read_scratchpad(crrt_sensor);
+            crrt_sensor++;
+          }
+          if (crrt_sensor < nbr_sensors){
+            return false;
+          }
+          update_conversion_time();
+          state = Ds18b20State::idle;
+          return true;
+
+        case Ds18b20State::copying:
+          if (now_ms - copy_start_ms >= copy_time_ms){
+            bus.reset();
+            state = Ds18b20State::idle;
+          }
+          return false;
+      }
+
+      return false;
+    }
+
+    // write the resolution to all the sensors at once; if persist, also copy it to their EEPROM so
+    // that it survives a power cycle (the EEPROM is rated for 50k writes, so only persist when it
+    // changes, not at each boot), which keeps the bus busy for 18 ms. Returns false if busy, or if no
+    // sensor answered the reset.
+    bool set_resolution(uint32_t const now_ms, Ds18b20Resolution const resolution, bool const persist=false,
+                        uint8_t const alarm_high=ds18b20_default_alarm_high, uint8_t const alarm_low=ds18b20_default_alarm_low){
+      if (state != Ds18b20State::idle){
+        return false;
+      }
+
+      if (!bus.reset()){
+        crrt_counters.presence_errors++;
+        return false;
+      }
+      bus.skip();
+      bus.write(ds18b20_write_scratchpad);
+      bus.write(alarm_high);
+      bus.write(alarm_low);
+      bus.write(static_cast<uint8_t>(resolution));
+
+      conversion_time_ms = ds18b20_conversion_time_ms(resolution);
+
+      if (persist){
+        if (!bus.reset()){
+          crrt_counters.presence_errors++;
+          return false;
+        }
+        bus.skip();
+        // with parasite power the bus must stay strongly pulled up during the copy
+        bus.write(ds18b20_copy_scratchpad, 1);
+        copy_start_ms = now_ms;
+        state = Ds18b20State::copying;
+      }
+
+      return true;
+    }
+
+    // the time the conversions are given; follows the resolution set, or read from the sensors
+    uint32_t conversion_time(void) const{
+      return conversion_time_ms;
+    }
+
+    bool busy(void) const{
+      return state != Ds18b20State::idle;
+    }
+
+    size_t size(void) const{
+      return nbr_sensors;
+    }
+
+    // the result of the last conversion, for the sensor at index ind (in the order given to
+    // set_sensors)
+    bool valid(size_t const ind) const{
+      return valid_scratchpad[ind];
+    }
+
+    uint8_t const * scratchpad(size_t const ind) const{
+      return scratchpads[ind];
+    }
+
+    float temperature_celsius(size_t const ind) const{
+      return ds18b20_temperature_celsius(scratchpads[ind]);
+    }
+
+    // the raw temperatures (1/16 deg C) of all the sensors, in the order given to set_sensors, in
+    // one pass, for a batched decode (see ds18b20_calibration.h); ds18b20_invalid_raw for the
+    // invalid scratchpads. Returns the number of sensors.
+    size_t raw_temperatures(int16_t * const raw_out) const{
+      for (size_t ind=0; ind<nbr_sensors; ind++){
+        raw_out[ind] = valid_scratchpad[ind] ? ds18b20_raw_temperature(scratchpads[ind]) : ds18b20_invalid_raw;
+      }
+      return nbr_sensors;
+    }
+
+    Ds18b20Counters const & counters(void) const{
+      return crrt_counters;
+    }
+
+  private:
+    // the copy takes 10 ms from the end of the Copy Scratchpad command, which comes about 6 ms after
+    // the now_ms given to set_resolution (2 resets and 7 bytes at the standard speed), itself
+    // truncated to the ms; a reset before the end would abort the copy
+    static constexpr uint32_t copy_time_ms {10 + 6 + 2};
+
+    // the conversion time of the highest resolution found in the scratchpads just read, so that the
+    // timing also follows a resolution persisted earlier, or changed by another program
+    void update_conversion_time(void){
+      uint32_t max_conversion_time_ms {0};
+      for (size_t ind=0; ind<nbr_sensors; ind++){
+        if (valid_scratchpad[ind]){
+          uint32_t const crrt_conversion_time_ms = ds18b20_conversion_time_ms(static_cast<Ds18b20Resolution>(scratchpads[ind][4]));
+          if (crrt_conversion_time_ms > max_conversion_time_ms){
+            max_conversion_time_ms = crrt_conversion_time_ms;
+          }
+        }
+      }
+      if (max_conversion_time_ms > 0){
+        conversion_time_ms = max_conversion_time_ms;
+      }
+    }
+
+    void read_scratchpad(size_t const ind){
+      valid_scratchpad[ind] = false;
+
+      if (!bus.reset()){
+        crrt_counters.presence_errors++;
+        return;
+      }
+      bus.select(addresses[ind]);
+      bus.write(ds18b20_read_scratchpad);
+      bus.read_bytes(scratchpads[ind], ds18b20_scratchpad_length);
+      crrt_counters.scratchpads_read++;
+
+      // the fixed bits of the configuration register also catch an all zeros scratchpad (bus
+      // stuck low), which has a valid CRC
+      if ((kiss_crc::crc8_dallas(scratchpads[ind], ds18b20_scratchpad_length - 1) != scratchpads[ind][ds18b20_scratchpad_length - 1]) ||
+          ((scratchpads[ind][4] & 0x9F) != 0x1F)){
+        crrt_counters.crc_errors++;
+        return;
+      }
+      valid_scratchpad[ind] = true;
+    }
+
+    Bus & bus;
+    Ds18b20Completion const completion;
+
+    uint8_t addresses[max_nbr_sensors][8];
+    uint8_t scratchpads[max_nbr_sensors][ds18b20_scratchpad_length];
+    bool valid_scratchpad[max_nbr_sensors] {};
+    size_t nbr_sensors {0};
+
+    Ds18b20State state {Ds18b20State::idle};
+    uint32_t conversion_start_ms {0};
+    uint32_t copy_start_ms {0};
+    // until the resolution is set or read, assume the slowest
+    uint32_t conversion_time_ms {ds18b20_conversion_time_ms(Ds18b20Resolution::bits_12)};
+    size_t crrt_sensor {0};
+    Ds18b20Counters crrt_counters {};
+};
+
+#endif
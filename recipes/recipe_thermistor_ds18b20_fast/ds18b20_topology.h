@@ -0,0 +1,188 @@
+#ifndef DS18B20_TOPOLOGY_H
+#define DS18B20_TOPOLOGY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "ds18b20_string.h"
+
+// cache of the 1-Wire topology, i.e. the IDs of the sensors of the thermistor string, in the order
+// in which they are mounted along the string: a full search of the bus, at each boot, takes a while
+// for a long string, while the string itself never changes once deployed. The IDs are stored in a
+// non volatile memory (FRAM, flash) together with their sort keys, and at boot it is enough to check
+// that each of the cached sensors answers.
+//
+// the order along the string is given by the sort key: the 6 low bits of the first serial number
+// byte (the ones that change fastest between sensors), greater first; the sensors are labelled with
+// these when the string is built.
+//
+// the storage is a template parameter, with:
+//   void read(uint32_t address, uint8_t * buffer, size_t nbr_bytes);
+//   void write(uint32_t address, uint8_t const * buffer, size_t nbr_bytes);
+// so that this can be tested on a computer with an array, see extras/ds18b20_string_sim.cpp.
+
+// the sort key of an ID (same layout as in the recipe: the family code is the most significant byte,
+// the first serial number byte the next one)
+constexpr uint8_t ds18b20_sort_key(uint64_t const id){
+  return static_cast<uint8_t>((id >> 48) & 0x3F);
+}
+
+struct Ds18b20TopologyEntry{
+  uint64_t id;
+  uint8_t sort_key;
+};
+
+template <size_t max_nbr_sensors>
+class Ds18b20Topology{
+  public:
+    // set from the IDs found by a bus search, and sort them along the string: the keys are computed
+    // once, and the entries sorted on them (insertion sort, stable, a few entries); equal keys are
+    // ordered by full ID, greater first, so that the order is always the same
+    void set(uint64_t const * ids, size_t const nbr_ids){
+      nbr_entries = (nbr_ids < max_nbr_sensors) ? nbr_ids : max_nbr_sensors;
+
+      for (size_t ind=0; ind<nbr_entries; ind++){
+        Ds18b20TopologyEntry const crrt_entry {ids[ind], ds18b20_sort_key(ids[ind])};
+
+        size_t position = ind;
+        while ((position > 0) && goes_before(crrt_entry, entries[position - 1])){
+          entries[position] = entries[position - 1];
+          position--;
+        }
+        entries[position] = crrt_entry;
+      }
+    }
+
+    size_t size(void) const{
+      return nbr_entries;
+    }
+
+    uint64_t id(size_t const ind) const{
+      return entries[ind].id;
+    }
+
+    uint8_t sort_key(size_t const ind) const{
+      return entries[ind].sort_key;
+    }
+
+    // copy the sorted IDs out, returns the number of IDs
+    size_t ids(uint64_t * ids_out, size_t const max_nbr_ids) const{
+      size_t const nbr_out = (nbr_entries < max_nbr_ids) ? nbr_entries : max_nbr_ids;
+      for (size_t ind=0; ind<nbr_out; ind++){
+        ids_out[ind] = entries[ind].id;
+      }
+      return nbr_out;
+    }
+
+    // non volatile image: magic, version, number of entries, then each ID (little endian) and its
+    // key, then a CRC8 over all the previous bytes
+    static constexpr size_t max_image_length {4 + 1 + 1 + max_nbr_sensors * 9 + 1};
+
+    template <typename Storage>
+    void store(Storage & storage, uint32_t const address) const{
+      uint8_t image[max_image_length];
+      size_t position {0};
+
+      for (uint8_t const crrt_byte : magic){
+        image[position++] = crrt_byte;
+      }
+      image[position++] = image_version;
+      image[position++] = static_cast<uint8_t>(nbr_entries);
+      for (size_t ind=0; ind<nbr_entries; ind++){
+        for (int byte_ind=0; byte_ind<8; byte_ind++){
+          image[position++] = static_cast<uint8_t>(entries[ind].id >> (8 * byte_ind));
+        }
+        image[position++] = entries[ind].sort_key;
+      }
+      image[position] = kiss_crc::crc8_dallas(image, position);
+      position++;
+
+      storage.write(address, image, position);
+    }
+
+    // load from the storage; returns false, and leaves the topology empty, if there is no valid
+    // image there
+    template <typename Storage>
+    bool load(Storage & storage, uint32_t const address){
+      uint8_t image[max_image_length];
+      nbr_entries = 0;
+
+      storage.read(address, image, 6);
+      for (size_t ind=0; ind<4; ind++){
+        if (image[ind] != magic[ind]){
+          return false;
+        }
+      }
+      if ((image[4] != image_version) || (image[5] > max_nbr_sensors)){
+        return false;
+      }
+
+      size_t const nbr_stored = image[5];
+      size_t const image_length = 6 + nbr_stored * 9 + 1;
+      storage.read(address + 6, image + 6, image_length - 6);
+      if (kiss_crc::crc8_dallas(image, image_length - 1) != image[image_length - 1]){
+        return false;
+      }
+
+      size_t position {6};
+      for (size_t ind=0; ind<nbr_stored; ind++){
+        uint64_t crrt_id {0};
+        for (int byte_ind=0; byte_ind<8; byte_ind++){
+          crrt_id |= static_cast<uint64_t>(image[position++]) << (8 * byte_ind);
+        }
+        entries[ind].id = crrt_id;
+        entries[ind].sort_key = image[position++];
+      }
+      nbr_entries = nbr_stored;
+      return true;
+    }
+
+    // quick presence check: each cached sensor is addressed directly and must return a valid
+    // scratchpad; this is much faster than a full search, but does not detect sensors added to the
+    // bus since the cache was written (search again and store in that case)
+    template <typename Bus>
+    bool verify(Bus & bus) const{
+      if (nbr_entries == 0){
+        return false;
+      }
+
+      for (size_t ind=0; ind<nbr_entries; ind++){
+        uint8_t address[8];
+        uint8_t scratchpad[ds18b20_scratchpad_length];
+        ds18b20_id_to_address(entries[ind].id, address);
+
+        if (!bus.reset()){
+          return false;
+        }
+        bus.select(address);
+        bus.write(ds18b20_read_scratchpad);
+        bus.read_bytes(scratchpad, ds18b20_scratchpad_length);
+
+        if ((kiss_crc::crc8_dallas(scratchpad, ds18b20_scratchpad_length - 1) != scratchpad[ds18b20_scratchpad_length - 1]) ||
+            ((scratchpad[4] & 0x9F) != 0x1F)){
+          return false;
+        }
+      }
+
+      return true;
+    }
+
+  private:
+    static constexpr uint8_t magic[4] {'D', 'S', '1', '8'};
+    static constexpr uint8_t image_version {1};
+
+    static bool goes_before(Ds18b20TopologyEntry const & entry_1, Ds18b20TopologyEntry const & entry_2){
+      if (entry_1.sort_key != entry_2.sort_key){
+        return entry_1.sort_key > entry_2.sort_key;
+      }
+      return entry_1.id > entry_2.id;
+    }
+
+    Ds18b20TopologyEntry entries[max_nbr_sensors];
+    size_t nbr_entries {0};
+};
+
+template <size_t max_nbr_sensors>
+constexpr uint8_t Ds18b20Topology<max_nbr_sensors>::magic[4];
+
+#endif
@@ -0,0 +1,984 @@
+// drive the DS18B20 string driver on a computer, against a simulated 1-Wire bus with a string of
+// DS18B20s, and check the readings of each conversion:
+//
+//   g++ -O2 -std=c++11 -I.. -I../../../libraries/kiss_crc/src ds18b20_string_sim.cpp -o ds18b20_string_sim
+//   ./ds18b20_string_sim
+//
+// the simulated sensors take a random fraction of the datasheet max to convert (up to the max
+// itself), only update their temperature register at the end of the conversion, and fill the
+// undefined low bits with garbage at the resolutions below 12 bits; they answer 0 to the read slots
+// while converting, and can be made to never finish, to corrupt their scratchpad on the bus, or to
+// be missing. Write Scratchpad sets TH, TL and the writable bits of the configuration, and Copy
+// Scratchpad writes them to an EEPROM in 10 ms, unless a reset comes before; the EEPROM is recalled
+// at a power cycle. Each bus operation takes its time at the standard speed (reset 1 ms, 560 us per byte),
+// so that the sampling rates of a 12 sensors string are printed for each resolution.
+//
+// the topology cache (ds18b20_topology.h) is checked on the same bus and on a simulated non volatile
+// memory: the sort order, the round trip through the storage, the rejection of corrupted or
+// oversized images, and the presence check. The batched decode (ds18b20_calibration.h) is checked
+// against a double reference over the whole range of the sensors, with random calibrations. Returns
+// non zero if any check fails.
+
+#include <cstdio>
+#include <cstdint>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include "ds18b20_string.h"
+#include "ds18b20_topology.h"
+#include "ds18b20_calibration.h"
+
+static constexpr size_t max_nbr_sensors {12};
+
+// across the wrap around of the uint32_t ms
+static constexpr uint64_t time_start_us {(static_cast<uint64_t>(UINT32_MAX) - 20000) * 1000};
+static constexpr uint64_t reset_us {1000};
+static constexpr uint64_t slot_us {70};
+static constexpr uint64_t byte_us {8 * slot_us};
+// the loop does other work between the calls to poll
+static constexpr uint64_t loop_period_us {500};
+static constexpr uint64_t max_cycle_us {5000000};
+
+static unsigned long nbr_errors {0};
+
+static void expect(char const * what, bool const condition){
+  if (!condition){
+    nbr_errors++;
+    if (nbr_errors < 20){
+      printf("ERROR: %s\n", what);
+    }
+  }
+}
+
+static uint64_t datasheet_conversion_us(uint8_t const configuration){
+  switch (configuration & 0x60){
+    case 0x00: return 93750;
+    case 0x20: return 187500;
+    case 0x40: return 375000;
+    default: return 750000;
+  }
+}
+
+// the temperature register as the driver should report it, without the undefined low bits
+static int16_t masked_temperature(int16_t const temperature, uint8_t const configuration){
+  unsigned const nbr_undefined_bits = 3 - ((configuration >> 5) & 0x03);
+  return static_cast<int16_t>(temperature & ~((1 << nbr_undefined_bits) - 1));
+}
+
+struct SimulatedDs18b20{
+  uint8_t address[8];
+  // the scratchpad without its CRC: temperature (LSB, MSB), TH, TL, configuration, reserved
+  uint8_t registers[8] {0x50, 0x05, ds18b20_default_alarm_high, ds18b20_default_alarm_low, 0x7F, 0xFF, 0x0C, 0x10};
+  // TH, TL, configuration
+  uint8_t eeprom[3] {ds18b20_default_alarm_high, ds18b20_default_alarm_low, 0x7F};
+  bool copying {false};
+  uint64_t copy_end_us {0};
+  // the temperature measured by the next conversions, 1/16 deg C
+  int16_t temperature {0};
+  // the conversion time, as a fraction of the datasheet max
+  double conversion_speed {1.0};
+  bool converting {false};
+  uint64_t conversion_end_us {0};
+
+  // faults
+  bool present {true};
+  bool stuck_converting {false};
+  // a bit flipped on the bus after the CRC
+  bool bad_crc {false};
+  // a configuration byte with a wrong fixed bit, and a CRC that matches it
+  bool bad_configuration {false};
+  // the data line held low during the read: all zeros, with a valid CRC
+  bool zeros {false};
+
+  void power_cycle(void){
+    registers[0] = 0x50;
+    registers[1] = 0x05;
+    for (size_t ind=0; ind<3; ind++){
+      registers[2 + ind] = eeprom[ind];
+    }
+    converting = false;
+    copying = false;
+  }
+
+  uint8_t scratchpad_byte(size_t const position) const{
+    uint8_t scratchpad[ds18b20_scratchpad_length];
+    for (size_t ind=0; ind<8; ind++){
+      scratchpad[ind] = registers[ind];
+    }
+    if (bad_configuration){
+      scratchpad[4] |= 0x80;
+    }
+    scratchpad[8] = kiss_crc::crc8_dallas(scratchpad, 8);
+    if (bad_crc){
+      scratchpad[2] ^= 0x01;
+    }
+    return zeros ? 0 : scratchpad[position];
+  }
+};
+
+static uint64_t address_to_id(uint8_t const address[8]){
+  uint64_t id {0};
+  for (int ind=0; ind<8; ind++){
+    id |= static_cast<uint64_t>(address[ind]) << (8 * (7 - ind));
+  }
+  return id;
+}
+
+// the 1-Wire bus, with the interface of OneWire used by the driver
+class SimulatedOneWire{
+  public:
+    std::vector<SimulatedDs18b20> sensors;
+    uint64_t now_us {time_start_us};
+    std::mt19937 generator {11};
+
+    // what the driver did
+    uint8_t convert_power {0xFF};
+    uint8_t copy_power {0xFF};
+    unsigned long nbr_read_slots {0};
+    unsigned long nbr_copies {0};
+    // the resets before the end of a copy, that abort it
+    unsigned long nbr_copies_aborted {0};
+    // the end of the last Convert T, and of the first Read Scratchpad after it
+    uint64_t convert_us {0};
+    uint64_t first_read_us {0};
+
+    uint32_t now_ms(void) const{
+      return static_cast<uint32_t>(now_us / 1000);
+    }
+
+    uint8_t reset(void){
+      for (SimulatedDs18b20 & sensor : sensors){
+        if (sensor.copying && (now_us < sensor.copy_end_us)){
+          sensor.copying = false;
+          nbr_copies_aborted++;
+        }
+      }
+      advance(reset_us);
+      selected.assign(sensors.size(), false);
+      function = Function::none;
+      for (SimulatedDs18b20 const & sensor : sensors){
+        if (sensor.present){
+          return 1;
+        }
+      }
+      return 0;
+    }
+
+    void skip(void){
+      advance(byte_us);
+      for (size_t ind=0; ind<sensors.size(); ind++){
+        selected[ind] = sensors[ind].present;
+      }
+    }
+
+    void select(uint8_t const address[8]){
+      advance(9 * byte_us);
+      for (size_t ind=0; ind<sensors.size(); ind++){
+        bool same_address {true};
+        for (int byte_ind=0; byte_ind<8; byte_ind++){
+          same_address = same_address && (sensors[ind].address[byte_ind] == address[byte_ind]);
+        }
+        selected[ind] = sensors[ind].present && same_address;
+      }
+    }
+
+    void write(uint8_t const value, uint8_t const power=0){
+      advance(byte_us);
+
+      if (function == Function::write_scratchpad){
+        // TH, TL, then the configuration, of which only the resolution bits can be written
+        for (size_t ind=0; ind<sensors.size(); ind++){
+          if (selected[ind] && (position < 3)){
+            sensors[ind].registers[2 + position] = (position < 2) ? value : static_cast<uint8_t>((value & 0x60) | 0x1F);
+          }
+        }
+        position++;
+      }
+      else if (function == Function::none){
+        if (value == ds18b20_convert_t){
+          convert_power = power;
+          convert_us = now_us;
+          first_read_us = 0;
+          for (size_t ind=0; ind<sensors.size(); ind++){
+            if (selected[ind]){
+              SimulatedDs18b20 & sensor = sensors[ind];
+              sensor.converting = true;
+              sensor.conversion_end_us = sensor.stuck_converting ? UINT64_MAX :
+                now_us + static_cast<uint64_t>(sensor.conversion_speed * datasheet_conversion_us(sensor.registers[4]));
+            }
+          }
+        }
+        else if (value == ds18b20_write_scratchpad){
+          function = Function::write_scratchpad;
+          position = 0;
+        }
+        else if (value == ds18b20_copy_scratchpad){
+          copy_power = power;
+          nbr_copies++;
+          for (size_t ind=0; ind<sensors.size(); ind++){
+            if (selected[ind]){
+              sensors[ind].copying = true;
+              sensors[ind].copy_end_us = now_us + 10000;
+            }
+          }
+        }
+        else if (value == ds18b20_read_scratchpad){
+          function = Function::read_scratchpad;
+          position = 0;
+          if (first_read_us == 0){
+            first_read_us = now_us;
+          }
+        }
+      }
+    }
+
+    uint8_t read_bit(void){
+      advance(slot_us);
+      nbr_read_slots++;
+      for (size_t ind=0; ind<sensors.size(); ind++){
+        if (selected[ind] && sensors[ind].converting){
+          return 0;
+        }
+      }
+      return 1;
+    }
+
+    void read_bytes(uint8_t * const buffer, uint16_t const nbr_bytes){
+      for (uint16_t ind=0; ind<nbr_bytes; ind++){
+        advance(byte_us);
+        // the line is pulled high, and each selected sensor can pull it low
+        uint8_t crrt_byte {0xFF};
+        if ((function == Function::read_scratchpad) && (position < ds18b20_scratchpad_length)){
+          for (size_t sensor_ind=0; sensor_ind<sensors.size(); sensor_ind++){
+            if (selected[sensor_ind]){
+              crrt_byte &= sensors[sensor_ind].scratchpad_byte(position);
+            }
+          }
+          position++;
+        }
+        buffer[ind] = crrt_byte;
+      }
+    }
+
+  private:
+    enum class Function : uint8_t {
+      none,
+      write_scratchpad,
+      read_scratchpad,
+    };
+
+    void advance(uint64_t const duration_us){
+      now_us += duration_us;
+
+      for (SimulatedDs18b20 & sensor : sensors){
+        if (sensor.converting && (now_us >= sensor.conversion_end_us)){
+          int16_t const garbage = static_cast<int16_t>(generator() & 0x07);
+          int16_t const temperature = static_cast<int16_t>(masked_temperature(sensor.temperature, sensor.registers[4]) |
+                                                           (garbage & ~masked_temperature(-1, sensor.registers[4])));
+          sensor.registers[0] = static_cast<uint8_t>(temperature);
+          sensor.registers[1] = static_cast<uint8_t>(static_cast<uint16_t>(temperature) >> 8);
+          sensor.converting = false;
+        }
+        if (sensor.copying && (now_us >= sensor.copy_end_us)){
+          for (size_t ind=0; ind<3; ind++){
+            sensor.eeprom[ind] = sensor.registers[2 + ind];
+          }
+          sensor.copying = false;
+        }
+      }
+    }
+
+    std::vector<bool> selected;
+    Function function {Function::none};
+    size_t position {0};
+};
+
+using ThermistorString = Ds18b20String<SimulatedOneWire, max_nbr_sensors>;
+
+// a string of nbr_sensors sensors, with the configurations cycling over the 4 resolutions from
+// first_configuration, converting in max_speed down to half of it of the datasheet max
+static void make_string(SimulatedOneWire & bus, ThermistorString & thermistor_string, size_t const nbr_sensors,
+                        uint8_t const first_configuration, double const max_speed){
+  bus.sensors.assign(nbr_sensors, SimulatedDs18b20{});
+  std::vector<uint64_t> ids;
+
+  for (size_t ind=0; ind<nbr_sensors; ind++){
+    SimulatedDs18b20 & sensor = bus.sensors[ind];
+    sensor.address[0] = ds18b20_family_code;
+    for (int byte_ind=1; byte_ind<7; byte_ind++){
+      sensor.address[byte_ind] = static_cast<uint8_t>(bus.generator());
+    }
+    sensor.address[7] = kiss_crc::crc8_dallas(sensor.address, 7);
+    sensor.registers[4] = static_cast<uint8_t>(((first_configuration + 0x20 * ind) & 0x60) | 0x1F);
+    sensor.eeprom[2] = sensor.registers[4];
+    // the first sensor at the max, the others faster
+    sensor.conversion_speed = (ind == 0) ? max_speed : max_speed * (0.5 + 0.5 * (bus.generator() % 1000) / 1000.0);
+    ids.push_back(address_to_id(sensor.address));
+  }
+
+  thermistor_string.set_sensors(ids.data(), ids.size());
+}
+
+// start a conversion and poll until all the scratchpads are read, as the loop of the recipe does,
+// with new temperatures for the sensors; returns the duration of the cycle, 0 if it did not complete
+static uint64_t run_cycle(SimulatedOneWire & bus, ThermistorString & thermistor_string){
+  for (SimulatedDs18b20 & sensor : bus.sensors){
+    sensor.temperature = static_cast<int16_t>(-55 * 16 + static_cast<int>(bus.generator() % (180 * 16 + 1)));
+  }
+
+  uint64_t const start_us = bus.now_us;
+  if (!thermistor_string.start_conversion(bus.now_ms())){
+    return 0;
+  }
+  while (bus.now_us - start_us < max_cycle_us){
+    bus.now_us += loop_period_us;
+    if (thermistor_string.poll(bus.now_ms())){
+      return bus.now_us - start_us;
+    }
+  }
+  return 0;
+}
+
+// the readings of the last cycle: valid for the sensors that answer with a good scratchpad, and
+// the temperature of this conversion, without the undefined bits (except for a sensor that never
+// finished, that still gives the previous one)
+static void check_readings(SimulatedOneWire const & bus, ThermistorString const & thermistor_string){
+  int16_t raw[max_nbr_sensors];
+  expect("number of raw temperatures", thermistor_string.raw_temperatures(raw) == bus.sensors.size());
+
+  for (size_t ind=0; ind<bus.sensors.size(); ind++){
+    SimulatedDs18b20 const & sensor = bus.sensors[ind];
+    bool const expected_valid = sensor.present && !sensor.bad_crc && !sensor.bad_configuration && !sensor.zeros;
+    expect("valid scratchpad", thermistor_string.valid(ind) == expected_valid);
+
+    if (!expected_valid){
+      expect("invalid raw temperature", raw[ind] == ds18b20_invalid_raw);
+    }
+    else if (!sensor.stuck_converting){
+      int16_t const expected_raw = masked_temperature(sensor.temperature, sensor.registers[4]);
+      expect("raw temperature of the conversion", raw[ind] == expected_raw);
+      expect("temperature in deg C", thermistor_string.temperature_celsius(ind) == expected_raw / 16.0f);
+    }
+  }
+}
+
+// the undefined low bits cleared at each resolution, over the whole range of the sensor and all
+// the patterns of the low bits
+static void check_masking(void){
+  for (uint8_t const configuration : {0x1F, 0x3F, 0x5F, 0x7F}){
+    for (int temperature=-55*16; temperature<=125*16; temperature++){
+      uint8_t scratchpad[ds18b20_scratchpad_length] {static_cast<uint8_t>(temperature), static_cast<uint8_t>(static_cast<uint16_t>(temperature) >> 8),
+                                                     0x4B, 0x46, configuration, 0xFF, 0x0C, 0x10, 0x00};
+      int16_t const expected = masked_temperature(static_cast<int16_t>(temperature), configuration);
+      expect("low bits cleared", ds18b20_raw_temperature(scratchpad) == expected);
+      expect("defined bits kept", (configuration != 0x7F) || (ds18b20_raw_temperature(scratchpad) == temperature));
+    }
+  }
+}
+
+// externally powered: the end of the conversion is seen on the read slots, soon after the slowest
+// sensor is done, and well before the datasheet max for faster sensors
+static void check_read_slot_completion(void){
+  SimulatedOneWire bus;
+  ThermistorString thermistor_string {bus, Ds18b20Completion::read_slot};
+  make_string(bus, thermistor_string, max_nbr_sensors, 0x1F, 0.9);
+
+  unsigned long const nbr_cycles {40};
+  for (unsigned long cycle=0; cycle<nbr_cycles; cycle++){
+    expect("read slot cycle completed", run_cycle(bus, thermistor_string) != 0);
+    check_readings(bus, thermistor_string);
+
+    uint64_t last_end_us {0};
+    for (SimulatedDs18b20 const & sensor : bus.sensors){
+      last_end_us = (sensor.conversion_end_us > last_end_us) ? sensor.conversion_end_us : last_end_us;
+    }
+    expect("read slot, no strong pullup", bus.convert_power == 0);
+    expect("read slot, read soon after the end of the conversions", bus.first_read_us <= last_end_us + 2 * loop_period_us + slot_us + reset_us + 10 * byte_us);
+  }
+
+  Ds18b20Counters const & counters = thermistor_string.counters();
+  expect("read slot, conversions", counters.conversions == nbr_cycles);
+  expect("read slot, scratchpads read", counters.scratchpads_read == nbr_cycles * max_nbr_sensors);
+  expect("read slot, no crc errors", counters.crc_errors == 0);
+  expect("read slot, no timeouts", counters.timeouts == 0);
+  expect("read slot, no presence errors", counters.presence_errors == 0);
+}
+
+// parasite power: the bus is held high during the conversion, never polled, and the scratchpads
+// are read only once the slowest sensor is done, even at the datasheet max
+static void check_timer_completion(void){
+  for (uint8_t const configuration : {0x1F, 0x3F, 0x5F, 0x7F}){
+    SimulatedOneWire bus;
+    ThermistorString thermistor_string {bus, Ds18b20Completion::timer};
+    make_string(bus, thermistor_string, max_nbr_sensors, configuration, 1.0);
+    for (SimulatedDs18b20 & sensor : bus.sensors){
+      sensor.registers[4] = configuration;
+    }
+
+    for (unsigned long cycle=0; cycle<20; cycle++){
+      uint32_t const conversion_time_ms = thermistor_string.conversion_time();
+      uint64_t const cycle_us = run_cycle(bus, thermistor_string);
+      expect("timer cycle completed", cycle_us != 0);
+      expect("timer, waits for the conversion time", cycle_us >= 1000 * conversion_time_ms);
+      expect("timer, read after the end of the conversion", bus.first_read_us >= bus.convert_us + datasheet_conversion_us(configuration));
+      check_readings(bus, thermistor_string);
+    }
+
+    expect("timer, strong pullup", bus.convert_power == 1);
+    expect("timer, no read slots", bus.nbr_read_slots == 0);
+    expect("timer, no crc errors", thermistor_string.counters().crc_errors == 0);
+  }
+}
+
+// a sensor that never reports done: the conversion is given up after 1.5 times the conversion time,
+// the other sensors are read, and the polling is back to normal once the sensor recovers
+static void check_timeout(void){
+  SimulatedOneWire bus;
+  ThermistorString thermistor_string {bus, Ds18b20Completion::read_slot};
+  make_string(bus, thermistor_string, 4, 0x3F, 0.9);
+  for (SimulatedDs18b20 & sensor : bus.sensors){
+    sensor.registers[4] = 0x3F;
+  }
+  bus.sensors[2].stuck_converting = true;
+
+  unsigned long const nbr_cycles {10};
+  for (unsigned long cycle=0; cycle<nbr_cycles; cycle++){
+    uint32_t const conversion_time_ms = thermistor_string.conversion_time();
+    uint64_t const cycle_us = run_cycle(bus, thermistor_string);
+    expect("timeout cycle completed", cycle_us != 0);
+    expect("timeout after 1.5 conversion times", cycle_us + 1000 >= 1500 * conversion_time_ms);
+    expect("timeout not much later", cycle_us <= 1500 * conversion_time_ms + 2 * loop_period_us + 5 * (reset_us + 19 * byte_us));
+    check_readings(bus, thermistor_string);
+  }
+  expect("timeouts counted", thermistor_string.counters().timeouts == nbr_cycles);
+
+  bus.sensors[2].stuck_converting = false;
+  bus.sensors[2].converting = false;
+  expect("recovered cycle completed", run_cycle(bus, thermistor_string) != 0);
+  check_readings(bus, thermistor_string);
+  expect("no timeout once recovered", thermistor_string.counters().timeouts == nbr_cycles);
+}
+
+// the scratchpads with a wrong CRC, a wrong fixed bit in the configuration, all zeros, or from a
+// missing sensor, are rejected and counted; a bus without any sensor fails to start
+static void check_rejection(void){
+  SimulatedOneWire bus;
+  ThermistorString thermistor_string {bus, Ds18b20Completion::read_slot};
+  make_string(bus, thermistor_string, 6, 0x7F, 0.5);
+  bus.sensors[1].bad_crc = true;
+  bus.sensors[2].bad_configuration = true;
+  bus.sensors[3].zeros = true;
+  bus.sensors[4].present = false;
+
+  unsigned long const nbr_cycles {5};
+  for (unsigned long cycle=0; cycle<nbr_cycles; cycle++){
+    expect("rejection cycle completed", run_cycle(bus, thermistor_string) != 0);
+    check_readings(bus, thermistor_string);
+  }
+
+  Ds18b20Counters const & counters = thermistor_string.counters();
+  expect("rejection, scratchpads read", counters.scratchpads_read == 6 * nbr_cycles);
+  expect("rejection, crc errors", counters.crc_errors == 4 * nbr_cycles);
+
+  for (SimulatedDs18b20 & sensor : bus.sensors){
+    sensor.present = false;
+  }
+  expect("no conversion without sensors", !thermistor_string.start_conversion(bus.now_ms()));
+  expect("presence error counted", thermistor_string.counters().presence_errors == 1);
+  expect("not busy without sensors", !thermistor_string.busy());
+}
+
+// poll until the copy to the EEPROM is over; returns its duration, 0 if it did not end
+static uint64_t wait_copy(SimulatedOneWire & bus, ThermistorString & thermistor_string, uint64_t const start_us){
+  while (bus.now_us - start_us < max_cycle_us){
+    bus.now_us += loop_period_us;
+    expect("nothing read while copying", !thermistor_string.poll(bus.now_ms()));
+    if (!thermistor_string.busy()){
+      return bus.now_us - start_us;
+    }
+  }
+  return 0;
+}
+
+// the resolution written to all the sensors at once, with the alarm registers, and the conversion
+// time that follows: the next conversions are given the datasheet max, and read at the new
+// resolution
+static void check_set_resolution(void){
+  Ds18b20Resolution const resolutions[] {Ds18b20Resolution::bits_9, Ds18b20Resolution::bits_10, Ds18b20Resolution::bits_11, Ds18b20Resolution::bits_12};
+  uint32_t const expected_conversion_time_ms[] {94, 188, 375, 750};
+
+  SimulatedOneWire bus;
+  ThermistorString thermistor_string {bus, Ds18b20Completion::timer};
+  make_string(bus, thermistor_string, max_nbr_sensors, 0x1F, 1.0);
+  for (SimulatedDs18b20 & sensor : bus.sensors){
+    sensor.registers[4] = 0x1F;
+    sensor.eeprom[2] = 0x1F;
+  }
+
+  // down and up again, so that each change is seen both ways
+  for (size_t const ind : {3, 0, 2, 1, 3, 1, 0}){
+    uint8_t const configuration = static_cast<uint8_t>(resolutions[ind]);
+    uint8_t const alarm_high = static_cast<uint8_t>(0x50 + ind);
+    uint8_t const alarm_low = static_cast<uint8_t>(0x10 + ind);
+
+    expect("set resolution", thermistor_string.set_resolution(bus.now_ms(), resolutions[ind], false, alarm_high, alarm_low));
+    expect("not busy without persist", !thermistor_string.busy());
+    expect("conversion time of the resolution written", thermistor_string.conversion_time() == expected_conversion_time_ms[ind]);
+    expect("datasheet conversion time", ds18b20_conversion_time_ms(resolutions[ind]) == expected_conversion_time_ms[ind]);
+
+    for (SimulatedDs18b20 const & sensor : bus.sensors){
+      expect("alarm high written", sensor.registers[2] == alarm_high);
+      expect("alarm low written", sensor.registers[3] == alarm_low);
+      expect("configuration written", sensor.registers[4] == configuration);
+      expect("EEPROM untouched without persist", sensor.eeprom[2] == 0x1F);
+    }
+
+    for (unsigned long cycle=0; cycle<3; cycle++){
+      uint64_t const cycle_us = run_cycle(bus, thermistor_string);
+      expect("cycle at the resolution written", cycle_us != 0);
+      expect("waits for the conversion time", cycle_us >= 1000 * expected_conversion_time_ms[ind]);
+      expect("read after the end of the conversion", bus.first_read_us >= bus.convert_us + datasheet_conversion_us(configuration));
+      expect("conversion time kept after the read back", thermistor_string.conversion_time() == expected_conversion_time_ms[ind]);
+      check_readings(bus, thermistor_string);
+    }
+  }
+
+  expect("no copy without persist", bus.nbr_copies == 0);
+  expect("set resolution, no crc errors", thermistor_string.counters().crc_errors == 0);
+}
+
+// persist: Copy Scratchpad with the strong pullup, the bus left alone for the 10 ms of the copy, no
+// conversion started meanwhile, and the resolution recalled at the next power up
+static void check_persist(void){
+  SimulatedOneWire bus;
+  ThermistorString thermistor_string {bus, Ds18b20Completion::read_slot};
+  make_string(bus, thermistor_string, max_nbr_sensors, 0x7F, 0.9);
+
+  for (Ds18b20Resolution const resolution : {Ds18b20Resolution::bits_9, Ds18b20Resolution::bits_11}){
+    uint8_t const configuration = static_cast<uint8_t>(resolution);
+    uint64_t const start_us = bus.now_us;
+
+    expect("set and persist resolution", thermistor_string.set_resolution(bus.now_ms(), resolution, true));
+    expect("copy with strong pullup", bus.copy_power == 1);
+    expect("busy while copying", thermistor_string.busy());
+    expect("no conversion while copying", !thermistor_string.start_conversion(bus.now_ms()));
+    expect("no resolution while copying", !thermistor_string.set_resolution(bus.now_ms(), Ds18b20Resolution::bits_12));
+
+    uint64_t const copy_us = wait_copy(bus, thermistor_string, start_us);
+    expect("copy over", copy_us != 0);
+    expect("copy not aborted", bus.nbr_copies_aborted == 0);
+    for (SimulatedDs18b20 const & sensor : bus.sensors){
+      expect("resolution persisted", sensor.eeprom[2] == configuration);
+      expect("alarms persisted", (sensor.eeprom[0] == ds18b20_default_alarm_high) && (sensor.eeprom[1] == ds18b20_default_alarm_low));
+    }
+
+    for (SimulatedDs18b20 & sensor : bus.sensors){
+      sensor.power_cycle();
+    }
+    expect("cycle after the power cycle", run_cycle(bus, thermistor_string) != 0);
+    check_readings(bus, thermistor_string);
+    expect("conversion time of the resolution persisted", thermistor_string.conversion_time() == ds18b20_conversion_time_ms(resolution));
+    for (SimulatedDs18b20 const & sensor : bus.sensors){
+      expect("resolution recalled", sensor.registers[4] == configuration);
+    }
+  }
+
+  expect("one copy per persist", bus.nbr_copies == 2);
+}
+
+// the conversion time also follows the configuration bytes read back, whatever the resolution
+// written: the slowest sensor sets it
+static void check_resolution_read_back(void){
+  SimulatedOneWire bus;
+  ThermistorString thermistor_string {bus, Ds18b20Completion::read_slot};
+  make_string(bus, thermistor_string, 6, 0x1F, 0.9);
+
+  // persisted at 9 bits earlier, while the driver assumes 12 bits until it reads them
+  for (SimulatedDs18b20 & sensor : bus.sensors){
+    sensor.registers[4] = 0x1F;
+  }
+  expect("slowest until read", thermistor_string.conversion_time() == 750);
+  expect("cycle at 9 bits", run_cycle(bus, thermistor_string) != 0);
+  check_readings(bus, thermistor_string);
+  expect("9 bits read back", thermistor_string.conversion_time() == 94);
+
+  // 9 bits written but not persisted, and one sensor back to its 12 bits EEPROM after a brown out
+  expect("set 9 bits", thermistor_string.set_resolution(bus.now_ms(), Ds18b20Resolution::bits_9));
+  bus.sensors[3].eeprom[2] = 0x7F;
+  bus.sensors[3].power_cycle();
+  expect("cycle with a 12 bits sensor", run_cycle(bus, thermistor_string) != 0);
+  expect("12 bits read back", thermistor_string.conversion_time() == 750);
+  // this first cycle was given up at 1.5 times the 9 bits time, before the end of the 12 bits one
+  expect("timeout at the resolution written", thermistor_string.counters().timeouts == 1);
+  expect("cycle at the resolution read back", run_cycle(bus, thermistor_string) != 0);
+  check_readings(bus, thermistor_string);
+  expect("no timeout at the resolution read back", thermistor_string.counters().timeouts == 1);
+
+  // all the resolutions at once
+  for (size_t ind=0; ind<bus.sensors.size(); ind++){
+    bus.sensors[ind].registers[4] = static_cast<uint8_t>(((0x20 * ind) & 0x60) | 0x1F);
+  }
+  bus.sensors[3].registers[4] = 0x1F;
+  bus.sensors[5].registers[4] = 0x1F;
+  expect("cycle at mixed resolutions", run_cycle(bus, thermistor_string) != 0);
+  check_readings(bus, thermistor_string);
+  expect("slowest read back", thermistor_string.conversion_time() == 375);
+
+  // the invalid scratchpads are not used
+  bus.sensors[2].bad_crc = true;
+  expect("cycle with a bad sensor", run_cycle(bus, thermistor_string) != 0);
+  check_readings(bus, thermistor_string);
+  expect("invalid configuration not used", thermistor_string.conversion_time() == 188);
+}
+
+// the sampling rate of a full string at each resolution, with sensors converting in up to 80 % of
+// the datasheet max
+static void print_sampling_rates(void){
+  printf("%u sensors, sampling rate (Hz): resolution, read slots, timer\n", static_cast<unsigned>(max_nbr_sensors));
+
+  for (uint8_t const configuration : {0x1F, 0x3F, 0x5F, 0x7F}){
+    double rate_hz[2];
+    for (Ds18b20Completion const completion : {Ds18b20Completion::read_slot, Ds18b20Completion::timer}){
+      SimulatedOneWire bus;
+      ThermistorString thermistor_string {bus, completion};
+      make_string(bus, thermistor_string, max_nbr_sensors, configuration, 0.8);
+      for (SimulatedDs18b20 & sensor : bus.sensors){
+        sensor.registers[4] = configuration;
+      }
+
+      // the first cycle finds the resolution
+      run_cycle(bus, thermistor_string);
+      unsigned long const nbr_cycles {20};
+      uint64_t total_us {0};
+      for (unsigned long cycle=0; cycle<nbr_cycles; cycle++){
+        total_us += run_cycle(bus, thermistor_string);
+      }
+      rate_hz[(completion == Ds18b20Completion::timer) ? 1 : 0] = nbr_cycles * 1e6 / total_us;
+    }
+    printf("  %d bits: %.1f, %.1f\n", 9 + ((configuration >> 5) & 0x03), rate_hz[0], rate_hz[1]);
+  }
+}
+
+// the non volatile memory of the topology, as an array
+struct SimulatedStorage{
+  std::vector<uint8_t> memory;
+
+  explicit SimulatedStorage(size_t const size): memory(size, 0xFF) {}
+
+  void read(uint32_t address, uint8_t * buffer, size_t nbr_bytes){
+    for (size_t ind=0; ind<nbr_bytes; ind++){
+      buffer[ind] = memory[address + ind];
+    }
+  }
+
+  void write(uint32_t address, uint8_t const * buffer, size_t nbr_bytes){
+    for (size_t ind=0; ind<nbr_bytes; ind++){
+      memory[address + ind] = buffer[ind];
+    }
+  }
+};
+
+using Topology = Ds18b20Topology<max_nbr_sensors>;
+
+static constexpr uint32_t topology_address {100};
+
+// IDs with only a few different sort keys, so that there are ties
+static std::vector<uint64_t> random_ids(std::mt19937 & generator, size_t const nbr_ids){
+  std::vector<uint64_t> ids;
+  for (size_t ind=0; ind<nbr_ids; ind++){
+    uint64_t id {ds18b20_family_code};
+    for (int byte_ind=1; byte_ind<8; byte_ind++){
+      uint8_t crrt_byte = static_cast<uint8_t>(generator());
+      if (byte_ind == 1){
+        crrt_byte = static_cast<uint8_t>((crrt_byte & 0xC0) | (generator() % 5));
+      }
+      id = (id << 8) | crrt_byte;
+    }
+    ids.push_back(id);
+  }
+  return ids;
+}
+
+static bool same_topology(Topology const & topology_1, Topology const & topology_2){
+  if (topology_1.size() != topology_2.size()){
+    return false;
+  }
+  for (size_t ind=0; ind<topology_1.size(); ind++){
+    if ((topology_1.id(ind) != topology_2.id(ind)) || (topology_1.sort_key(ind) != topology_2.sort_key(ind))){
+      return false;
+    }
+  }
+  return true;
+}
+
+// the order along the string: sort key greater first, then full ID greater first; and the round
+// trip through the storage
+static void check_topology_sort_and_round_trip(void){
+  std::mt19937 generator {5};
+
+  for (unsigned long trial=0; trial<2000; trial++){
+    size_t const nbr_ids = generator() % (max_nbr_sensors + 4);
+    std::vector<uint64_t> const ids = random_ids(generator, nbr_ids);
+
+    Topology topology;
+    topology.set(ids.data(), ids.size());
+
+    // only the first max_nbr_sensors IDs are kept
+    std::vector<uint64_t> expected(ids.begin(), ids.begin() + std::min(nbr_ids, max_nbr_sensors));
+    // the 6 low bits of the first serial number byte, i.e. of the second address byte
+    auto const sort_key = [](uint64_t const id){
+      uint8_t address[8];
+      ds18b20_id_to_address(id, address);
+      return static_cast<uint8_t>(address[1] & 0x3F);
+    };
+    std::sort(expected.begin(), expected.end(), [&sort_key](uint64_t const id_1, uint64_t const id_2){
+      return (sort_key(id_1) != sort_key(id_2)) ? (sort_key(id_1) > sort_key(id_2)) : (id_1 > id_2);
+    });
+
+    expect("topology size", topology.size() == expected.size());
+    for (size_t ind=0; (ind<topology.size()) && (ind<expected.size()); ind++){
+      expect("topology order", topology.id(ind) == expected[ind]);
+      expect("topology sort key", topology.sort_key(ind) == sort_key(expected[ind]));
+    }
+    uint64_t ids_out[max_nbr_sensors];
+    expect("topology ids out", topology.ids(ids_out, max_nbr_sensors) == expected.size());
+    expect("topology ids out order", std::equal(expected.begin(), expected.end(), ids_out));
+
+    SimulatedStorage storage {1024};
+    topology.store(storage, topology_address);
+    size_t const image_length = 6 + 9 * topology.size() + 1;
+    for (size_t ind=0; ind<storage.memory.size(); ind++){
+      if ((ind < topology_address) || (ind >= topology_address + image_length)){
+        expect("nothing written out of the image", storage.memory[ind] == 0xFF);
+      }
+    }
+    Topology loaded;
+    expect("topology load", loaded.load(storage, topology_address));
+    expect("topology round trip", same_topology(loaded, topology));
+  }
+}
+
+// any bit flipped in a stored image, an erased storage, an image with another version, or with more
+// entries than max_nbr_sensors: the load fails, and leaves the topology empty
+static void check_topology_rejection(void){
+  std::mt19937 generator {6};
+  std::vector<uint64_t> const ids = random_ids(generator, 9);
+  Topology topology;
+  topology.set(ids.data(), ids.size());
+
+  SimulatedStorage storage {1024};
+  topology.store(storage, topology_address);
+  size_t const image_length = 6 + 9 * ids.size() + 1;
+
+  for (size_t byte_ind=0; byte_ind<image_length; byte_ind++){
+    for (int bit_ind=0; bit_ind<8; bit_ind++){
+      SimulatedStorage corrupted = storage;
+      corrupted.memory[topology_address + byte_ind] ^= static_cast<uint8_t>(1 << bit_ind);
+      Topology loaded;
+      loaded.set(ids.data(), ids.size());
+      expect("corrupted image rejected", !loaded.load(corrupted, topology_address));
+      expect("empty after a rejected image", loaded.size() == 0);
+    }
+  }
+
+  SimulatedStorage erased {1024};
+  Topology loaded;
+  expect("erased storage rejected", !loaded.load(erased, topology_address));
+
+  // an image of another version, or with another magic, with a valid CRC
+  for (size_t const byte_ind : {0, 3, 4}){
+    SimulatedStorage other_format = storage;
+    other_format.memory[topology_address + byte_ind]++;
+    other_format.memory[topology_address + image_length - 1] = kiss_crc::crc8_dallas(&other_format.memory[topology_address], image_length - 1);
+    expect("other format rejected", !loaded.load(other_format, topology_address));
+  }
+
+  // written by a build with more sensors than this one can hold
+  std::vector<uint64_t> const many_ids = random_ids(generator, max_nbr_sensors + 3);
+  Ds18b20Topology<max_nbr_sensors + 3> larger_topology;
+  larger_topology.set(many_ids.data(), many_ids.size());
+  SimulatedStorage larger_storage {1024};
+  larger_topology.store(larger_storage, topology_address);
+  Ds18b20Topology<max_nbr_sensors + 3> larger_loaded;
+  expect("larger image valid", larger_loaded.load(larger_storage, topology_address) && (larger_loaded.size() == max_nbr_sensors + 3));
+  expect("image with too many entries rejected", !loaded.load(larger_storage, topology_address));
+  expect("empty after too many entries", loaded.size() == 0);
+
+  // and the exact max is fine
+  std::vector<uint64_t> const max_ids = random_ids(generator, max_nbr_sensors);
+  topology.set(max_ids.data(), max_ids.size());
+  topology.store(storage, topology_address);
+  expect("image with max entries", loaded.load(storage, topology_address) && same_topology(loaded, topology));
+}
+
+// the presence check of the cached sensors, on the simulated bus
+static void check_topology_verify(void){
+  SimulatedOneWire bus;
+  ThermistorString thermistor_string {bus, Ds18b20Completion::read_slot};
+  make_string(bus, thermistor_string, 8, 0x7F, 0.9);
+
+  std::vector<uint64_t> ids;
+  for (SimulatedDs18b20 const & sensor : bus.sensors){
+    ids.push_back(address_to_id(sensor.address));
+  }
+  Topology topology;
+  expect("empty topology not verified", !topology.verify(bus));
+  topology.set(ids.data(), ids.size());
+  expect("all the sensors answer", topology.verify(bus));
+
+  // a sensor added to the bus is not detected
+  bus.sensors.push_back(bus.sensors[0]);
+  bus.sensors.back().address[6] ^= 0x01;
+  expect("added sensor not seen", topology.verify(bus));
+  bus.sensors.pop_back();
+
+  bus.sensors[5].present = false;
+  expect("missing sensor", !topology.verify(bus));
+  bus.sensors[5].present = true;
+  bus.sensors[2].bad_crc = true;
+  expect("sensor with a bad crc", !topology.verify(bus));
+  bus.sensors[2].bad_crc = false;
+  bus.sensors[7].zeros = true;
+  expect("sensor stuck low", !topology.verify(bus));
+  bus.sensors[7].zeros = false;
+  expect("all the sensors answer again", topology.verify(bus));
+
+  for (SimulatedDs18b20 & sensor : bus.sensors){
+    sensor.present = false;
+  }
+  expect("no sensors", !topology.verify(bus));
+}
+
+using Calibration = Ds18b20Calibration<max_nbr_sensors>;
+
+// the calibration resolved per ID, whatever the order of the table, and the sensors without an
+// entry left as they are
+static void check_calibration_resolve(void){
+  std::mt19937 generator {8};
+  std::vector<uint64_t> const ids = random_ids(generator, max_nbr_sensors);
+  Ds18b20CalibrationEntry const table[] {
+    {ids[7], 0.25f, 1.0f},
+    {0x2800000000000001ULL, 5.0f, 2.0f},
+    {ids[2], -1.5f, 1.02f},
+  };
+
+  Calibration calibration;
+  expect("number of sensors calibrated", calibration.resolve(ids.data(), ids.size(), table, 3) == 2);
+  expect("calibration size", calibration.size() == max_nbr_sensors);
+
+  int16_t raw[max_nbr_sensors];
+  for (size_t ind=0; ind<max_nbr_sensors; ind++){
+    raw[ind] = 400;
+  }
+  int16_t centi[max_nbr_sensors];
+  calibration.decode_centi(raw, centi);
+  for (size_t ind=0; ind<max_nbr_sensors; ind++){
+    int16_t const expected = (ind == 7) ? 2525 : ((ind == 2) ? 2400 : 2500);
+    expect("calibration of the sensor", centi[ind] == expected);
+  }
+}
+
+// the decode of all the raw readings of the sensors, -55 to 125 deg C, against a double reference,
+// with random gains and offsets, both realistic and large enough to saturate the centi deg C; the
+// invalid readings give NAN and ds18b20_invalid_centi
+static void check_calibration_decode(void){
+  std::mt19937 generator {9};
+  std::uniform_real_distribution<float> realistic_gain(0.95f, 1.05f);
+  std::uniform_real_distribution<float> realistic_offset(-3.0f, 3.0f);
+  std::uniform_real_distribution<float> large_gain(-20.0f, 20.0f);
+  std::uniform_real_distribution<float> large_offset(-300.0f, 300.0f);
+
+  unsigned long nbr_decoded {0};
+  unsigned long nbr_off_by_one {0};
+  unsigned long nbr_saturated {0};
+  double max_celsius_error {0.0};
+
+  for (unsigned long trial=0; trial<50; trial++){
+    std::vector<uint64_t> const ids = random_ids(generator, max_nbr_sensors);
+    Ds18b20CalibrationEntry table[max_nbr_sensors];
+    for (size_t ind=0; ind<max_nbr_sensors; ind++){
+      bool const large = (ind % 4 == 3);
+      table[ind] = {ids[ind], large ? large_offset(generator) : realistic_offset(generator), large ? large_gain(generator) : realistic_gain(generator)};
+    }
+    Calibration calibration;
+    expect("all sensors calibrated", calibration.resolve(ids.data(), ids.size(), table, max_nbr_sensors) == max_nbr_sensors);
+
+    for (int temperature=-55*16; temperature<=125*16; temperature++){
+      int16_t raw[max_nbr_sensors];
+      for (size_t ind=0; ind<max_nbr_sensors; ind++){
+        raw[ind] = static_cast<int16_t>(temperature);
+      }
+      // one invalid reading, at a different sensor each time
+      size_t const invalid_ind = static_cast<size_t>(temperature + 55 * 16) % max_nbr_sensors;
+      raw[invalid_ind] = ds18b20_invalid_raw;
+
+      float celsius[max_nbr_sensors];
+      int16_t centi[max_nbr_sensors];
+      calibration.decode(raw, celsius);
+      calibration.decode_centi(raw, centi);
+
+      for (size_t ind=0; ind<max_nbr_sensors; ind++){
+        if (ind == invalid_ind){
+          expect("invalid reading gives NAN", std::isnan(celsius[ind]));
+          expect("invalid reading gives invalid centi", centi[ind] == ds18b20_invalid_centi);
+          continue;
+        }
+
+        double const reference = static_cast<double>(table[ind].gain) * temperature / 16.0 + table[ind].offset_celsius;
+        double const celsius_error = std::fabs(celsius[ind] - reference);
+        if ((ind % 4 != 3) && (celsius_error > max_celsius_error)){
+          max_celsius_error = celsius_error;
+        }
+        // a multiply add in float: a few float epsilons of the terms
+        double const terms_magnitude = std::fabs(table[ind].gain * temperature / 16.0) + std::fabs(table[ind].offset_celsius);
+        expect("float decode", celsius_error <= 2.5e-7 * terms_magnitude);
+
+        double const reference_centi = std::floor(100.0 * reference + 0.5);
+        if (reference_centi > INT16_MAX){
+          expect("saturated high", centi[ind] == INT16_MAX);
+          nbr_saturated++;
+        }
+        else if (reference_centi < INT16_MIN + 1){
+          expect("saturated low, not invalid", centi[ind] == INT16_MIN + 1);
+          nbr_saturated++;
+        }
+        else{
+          // the Q16 coefficients are within 2^-17 of the exact ones, i.e. within 0.02 centi over the
+          // range: the rounding can only differ from the reference that close to a half centi
+          double const distance_to_half = std::fabs(100.0 * reference - std::floor(100.0 * reference) - 0.5);
+          double const centi_error = std::fabs(centi[ind] - reference_centi);
+          expect("centi within 1 of the reference", centi_error <= 1.0);
+          expect("centi rounded to nearest", (centi_error == 0.0) || (distance_to_half < 0.02));
+          nbr_off_by_one += (centi_error != 0.0) ? 1 : 0;
+        }
+        nbr_decoded++;
+      }
+    }
+  }
+
+  expect("saturation exercised", nbr_saturated > 0);
+  printf("calibration: %lu decoded, %lu centi off by one at a half centi, %lu saturated, max float error %.2g deg C with the realistic calibrations\n",
+         nbr_decoded, nbr_off_by_one, nbr_saturated, max_celsius_error);
+}
+
+int main(){
+  check_masking();
+  check_read_slot_completion();
+  check_timer_completion();
+  check_timeout();
+  check_rejection();
+  check_set_resolution();
+  check_persist();
+  check_resolution_read_back();
+  check_topology_sort_and_round_trip();
+  check_topology_rejection();
+  check_topology_verify();
+  check_calibration_resolve();
+  check_calibration_decode();
+  print_sampling_rates();
+
+  printf("%lu errors\n", nbr_errors);
+  return (nbr_errors == 0) ? 0 : 1;
+}
@@ -3,6 +3,9 @@
 #include "etl.h"
 #include "etl/vector.h"
 #include "etl/algorithm.h"
+#include "ds18b20_string.h"
+#include "ds18b20_topology.h"
+#include "ds18b20_calibration.h"
 
 #define ONE_WIRE_PIN 35  // the data pin; I suggest to put a 100 Ohm between the pin and the sensors; this way, if a cable is cut / shorted, will not burn the pin
 #define ONE_WIRE_POWER 4  // the power pin; use a digital pin to be able to switch power on and off
@@ -12,11 +15,123 @@
 // the maximum number of sensors the sketch can handle
 #define MAX_NBR_OF_SENSORS 12
 
+// set to 1 to cache the topology of the string (the sorted IDs) in a SPI FRAM, see recipe_adafruit_fram
+// for the wiring; the full search of the bus is then only done when the cache is missing or one of
+// the cached sensors does not answer. Set FORCE_TOPOLOGY_SEARCH to 1 once after adding sensors.
+#define TOPOLOGY_CACHE_IN_FRAM 0
+#define FORCE_TOPOLOGY_SEARCH 0
+
+// set to 1 to print the temperatures as integer centi deg C (exact to the resolution of the sensors,
+// and much cheaper to format and log) rather than as floats
+#define LOG_CENTI_DEGREES 0
+
+// set to 1 to start with the slow sampling profile (12 bits, every 10 s) rather than the fast one
+// (10 bits, continuously); the profile can then be switched at any time by sending 'f' (fast) or
+// 's' (slow) on the serial
+#define START_WITH_SLOW_PROFILE 0
+
+#if TOPOLOGY_CACHE_IN_FRAM
+#include <SPI.h>
+#include "Adafruit_FRAM_SPI.h"
+
+#define FRAM_CS_PIN 10
+constexpr uint32_t topology_fram_address {0};
+
+SPIClass fram_spi(0);
+Adafruit_FRAM_SPI fram = Adafruit_FRAM_SPI(FRAM_CS_PIN, &fram_spi);
+
+// the storage interface of Ds18b20Topology on top of the FRAM
+struct FramStorage{
+  void read(uint32_t address, uint8_t * buffer, size_t nbr_bytes){
+    fram.read(address, buffer, nbr_bytes);
+  }
+
+  void write(uint32_t address, uint8_t const * buffer, size_t nbr_bytes){
+    fram.writeEnable(true);
+    fram.write(address, const_cast<uint8_t *>(buffer), nbr_bytes);
+    fram.writeEnable(false);
+  }
+};
+
+FramStorage topology_storage;
+#endif
+
 OneWire ds(ONE_WIRE_PIN);  // on pin 10 (a pullup resistor is necessary; value may depend on the board (!) and the number of sensors)
 
 using Address = byte[8];
 etl::vector<uint64_t, MAX_NBR_OF_SENSORS> vector_of_ids;
 etl::vector<float, MAX_NBR_OF_SENSORS> vector_of_measurements;
+etl::vector<int16_t, MAX_NBR_OF_SENSORS> vector_of_measurements_centi;
+
+// the raw readings of the last conversion, in 1/16 deg C, in sensor order
+int16_t raw_temperatures[MAX_NBR_OF_SENSORS];
+
+// the IDs sorted along the string, with their sort keys
+Ds18b20Topology<MAX_NBR_OF_SENSORS> topology;
+
+// all the sensors convert at once, and are then read without blocking the loop; the sensors are
+// powered through ONE_WIRE_POWER, so the end of the conversion can be polled on the bus
+Ds18b20String<OneWire, MAX_NBR_OF_SENSORS> thermistor_string{ds, Ds18b20Completion::read_slot};
+
+// the calibration of the sensors against a reference thermometer, T = gain * T_sensor + offset, by
+// sensor ID (as printed at boot); the sensors not in the table are used as they are
+constexpr Ds18b20CalibrationEntry calibration_table[] {
+  // {ID, offset [deg C], gain}
+  {0x0000000000000000, 0.0f, 1.0f},  // placeholder, matches no sensor
+};
+
+// the calibration table, resolved in sensor order
+Ds18b20Calibration<MAX_NBR_OF_SENSORS> calibration;
+
+// the sampling profiles: the resolution sets the conversion time, and so the max sampling rate of
+// the whole string (10 bits: 0.25 deg C, about 5 Hz; 12 bits: 0.0625 deg C, about 1.3 Hz); a period
+// of 0 measures continuously, i.e. starts a new conversion as soon as the previous one is read
+struct SamplingProfile{
+  Ds18b20Resolution resolution;
+  unsigned long measurement_period_ms;
+};
+
+constexpr SamplingProfile fast_profile {Ds18b20Resolution::bits_10, 0};
+constexpr SamplingProfile slow_profile {Ds18b20Resolution::bits_12, 10000};
+#if START_WITH_SLOW_PROFILE
+constexpr SamplingProfile const & start_profile {slow_profile};
+#else
+constexpr SamplingProfile const & start_profile {fast_profile};
+#endif
+SamplingProfile crrt_profile {start_profile};
+unsigned long millis_last_measurement {0};
+
+// the profile asked for on the serial, applied once the string is idle; nullptr if none
+SamplingProfile const * requested_profile {nullptr};
+
+// switch profile; the resolution is only written to the scratchpads, i.e. set again at each boot,
+// to spare the EEPROM of the sensors
+bool apply_profile(SamplingProfile const & profile){
+  if (!thermistor_string.set_resolution(millis(), profile.resolution)){
+    Serial.println(F("ERROR: could not set the resolution"));
+    return false;
+  }
+  crrt_profile = profile;
+  Serial.print(F("conversion time [ms]: ")); Serial.print(thermistor_string.conversion_time());
+  Serial.print(F(" | measurement period [ms]: ")); Serial.println(crrt_profile.measurement_period_ms);
+  return true;
+}
+
+// 'f': fast profile, 's': slow profile; the other characters are ignored
+void read_profile_command(void){
+  while (Serial.available() > 0){
+    switch (Serial.read()){
+      case 'f':
+        requested_profile = &fast_profile;
+        break;
+      case 's':
+        requested_profile = &slow_profile;
+        break;
+      default:
+        break;
+    }
+  }
+}
 
 void address_to_uint64_t(Address & addr_in, uint64_t & uint64_result){
   uint64_result = 0;
@@ -62,16 +177,6 @@ void uint64_t_to_6bits_int_id(uint64_t const & uint64_in, uint8_t & uint8_6bits_
   uint8_6bits_id = byte_result;
 }
 
-// function to order thermistors by 6 lower bits
-// need to be equivalent to >, NOT to >=, see C++ standard https://en.cppreference.com/w/cpp/utility/functional/greater
-bool greater_6bits_id(uint64_t const & id_1, uint64_t const & id_2){
-      uint8_t id6_1;
-    uint8_t id6_2;
-    uint64_t_to_6bits_int_id(id_1, id6_1);
-    uint64_t_to_6bits_int_id(id_2, id6_2);
-    return id6_1 > id6_2;
-}
-
 void look_for_sensors(etl::ivector<uint64_t> & vec_in){
   Address crrt_addr;
   uint64_t crrt_id;
@@ -112,7 +217,7 @@ void look_for_sensors(etl::ivector<uint64_t> & vec_in){
       }
     }
 
-    if (OneWire::crc8(crrt_addr, 7) != crrt_addr[7]) {
+    if (kiss_crc::crc8_dallas(crrt_addr, 7) != crrt_addr[7]) {
       Serial.println("WARNING: CRC is not valid!");
       continue;
     }
@@ -141,92 +246,87 @@ void look_for_sensors(etl::ivector<uint64_t> & vec_in){
   // we sort greater first; i.e., the sensors with greater IDs are sorted first;
   // i.e., if the thermistor string have greater IDs higher up, then the sensors are sorted from higher up to lower down
   // etl::sort(vec_in.begin(), vec_in.end(), std::greater<uint64_t>());  // sort using full id
-  etl::sort(vector_of_ids.begin(), vector_of_ids.end(), greater_6bits_id);  // sort using only the 6 bits reduced id
+  // sort using only the 6 bits reduced id: the keys are computed once, then a keyed sort
+  topology.set(vec_in.data(), vec_in.size());
+  topology.ids(vec_in.data(), vec_in.size());
+
+  print_topology();
 
+  return;
+}
+
+
+void print_topology(void){
   Serial.println(F("sorted list of IDs; note that ordering by 6 LSBs is not identical to ordering by true ID"));
 
-  for (auto const & crrt_elem : vec_in){
-    uint8_t reduced_6bits_id;
-    uint64_t_to_6bits_int_id(crrt_elem, reduced_6bits_id);
-    print_uint64(crrt_elem); Serial.print(F(" reduced 6 bits ID (bin): ")); Serial.println(reduced_6bits_id);
+  for (size_t ind=0; ind<topology.size(); ind++){
+    print_uint64(topology.id(ind)); Serial.print(F(" reduced 6 bits ID (bin): ")); Serial.println(topology.sort_key(ind));
   }
-
-  return;
 }
 
+// fill vector_of_ids, from the cache if it is there and all its sensors answer, else with a full
+// search of the bus (and then update the cache)
+void setup_topology(void){
+#if TOPOLOGY_CACHE_IN_FRAM
+  if (!fram.begin(2)){
+    Serial.println(F("ERROR: no FRAM found, search the bus"));
+    look_for_sensors(vector_of_ids);
+    return;
+  }
 
-void measure_all_sensors(etl::ivector<uint64_t> const & vec_sensors_IDs, etl::ivector<float> & vector_of_measurements){
-  Address crrt_address;
-  vector_of_measurements.clear();
-  byte present = 0;
-  byte data[12];
-  float celsius;
-  byte crc;
-
-  // ask each sensor to start new measurement
-  Serial.println(F("ask to start conversion..."));
-  for (auto & crrt_id : vec_sensors_IDs){
-    uint64_t_to_address(crrt_id, crrt_address);
-    print_address(crrt_address); Serial.println();
-
-    ds.reset();
-    ds.select(crrt_address);
-    ds.write(0x44, 1);        // start conversion, with parasite power on at the end
-    delay(10);
+  if (!FORCE_TOPOLOGY_SEARCH && topology.load(topology_storage, topology_fram_address) && topology.verify(ds)){
+    Serial.println(F("topology cache valid, all the sensors answer"));
+    vector_of_ids.resize(topology.size());
+    topology.ids(vector_of_ids.data(), vector_of_ids.size());
+    print_topology();
+    return;
   }
 
-  // wait for the conversion to take place
-  // in theory 750ms is enough, but take no chance
-  Serial.println(F("wait for conversions to take place"));
-  delay(1000);
+  Serial.println(F("topology cache missing or outdated, search the bus"));
+  look_for_sensors(vector_of_ids);
+  topology.store(topology_storage, topology_fram_address);
+#else
+  look_for_sensors(vector_of_ids);
+#endif
+}
 
-  // collect the output of each sensor
-  Serial.println(F("collect results..."));
-  for (auto & crrt_id : vec_sensors_IDs){
-    uint64_t_to_address(crrt_id, crrt_address);
-    print_address(crrt_address); Serial.println();
-
-    present = ds.reset();
-    ds.select(crrt_address);    
-    ds.write(0xBE);         // Read Scratchpad
-
-    Serial.print("  Data = ");
-    Serial.print(present, HEX);
-    Serial.print(" ");
-    for ( int i = 0; i < 9; i++) {           // we need 9 bytes
-      data[i] = ds.read();
-      Serial.print(data[i], HEX);
-      Serial.print(" ");
-    }
-    Serial.print(" CRC=");
-    crc = OneWire::crc8(data, 8);
-    Serial.print(crc, HEX);
-    if (crc != data[8]){
-      Serial.println(F(" ERROR: non matching CRC"));
-    }
-    else{
-      Serial.println(F(" CRC OK"));
-    }
+// fill vector_of_measurements (and vector_of_measurements_centi) from the last conversion, in the
+// order of the IDs, decoding and calibrating all the sensors in one pass; the sensors with an
+// invalid scratchpad get a NAN (ds18b20_invalid_centi)
+void collect_measurements(void){
+  size_t const nbr_sensors = thermistor_string.raw_temperatures(raw_temperatures);
 
-    // Convert the data to actual temperature
-    // because the result is a 16 bit signed integer, it should
-    // be stored to an "int16_t" type, which is always 16 bits
-    // even when compiled on a 32 bit processor.
-    int16_t raw = (data[1] << 8) | data[0];
-    byte cfg = (data[4] & 0x60);
-    // at lower res, the low bits are undefined, so let's zero them
-    if (cfg == 0x00) {raw = raw & ~7; Serial.println(F("  WARNING: 9 bit res"));}  // 9 bit resolution, 93.75 ms
-    else if (cfg == 0x20) {raw = raw & ~3; Serial.println(F("  WARNING: 10 bit res"));} // 10 bit res, 187.5 ms
-    else if (cfg == 0x40) {raw = raw & ~1; Serial.println(F("  WARNING: 11 bit res"));} // 11 bit res, 375 ms
-    else if (cfg == 0x60) {Serial.println(F("  OK: 12 bits resolution"));}
-    else {Serial.println(F("  ERROR: unknown resolution config!"));}
-
-    celsius = (float)raw / 16.0;
-    Serial.print("  Temperature = ");
-    Serial.print(celsius);
-    Serial.print(" Celsius");
-    Serial.println();
+  vector_of_measurements.resize(nbr_sensors);
+  calibration.decode(raw_temperatures, vector_of_measurements.data());
+
+#if LOG_CENTI_DEGREES
+  vector_of_measurements_centi.resize(nbr_sensors);
+  calibration.decode_centi(raw_temperatures, vector_of_measurements_centi.data());
+#endif
+}
+
+void print_measurements(void){
+#if LOG_CENTI_DEGREES
+  Serial.print(F("temperatures [centi deg C]:"));
+  for (auto const & crrt_measurement : vector_of_measurements_centi){
+    Serial.print(' ');
+    Serial.print(crrt_measurement);
   }
+#else
+  Serial.print(F("temperatures [deg C]:"));
+  for (auto const & crrt_measurement : vector_of_measurements){
+    Serial.print(' ');
+    Serial.print(crrt_measurement, 4);
+  }
+#endif
+  Serial.println();
+
+  Ds18b20Counters const & counters = thermistor_string.counters();
+  Serial.print(F("conversions: ")); Serial.print(counters.conversions);
+  Serial.print(F(", scratchpads read: ")); Serial.print(counters.scratchpads_read);
+  Serial.print(F(", CRC errors: ")); Serial.print(counters.crc_errors);
+  Serial.print(F(", presence errors: ")); Serial.print(counters.presence_errors);
+  Serial.print(F(", timeouts: ")); Serial.println(counters.timeouts);
 }
 
 void setup(void) {
@@ -247,13 +347,39 @@ void setup(void) {
   delay(500);
 
   Serial.println(F("look for sensors..."));
-  look_for_sensors(vector_of_ids);
+  setup_topology();
+  thermistor_string.set_sensors(vector_of_ids.data(), vector_of_ids.size());
+  size_t const nbr_calibrated = calibration.resolve(vector_of_ids.data(), vector_of_ids.size(), calibration_table, sizeof(calibration_table) / sizeof(calibration_table[0]));
+  Serial.print(F("calibrated sensors: ")); Serial.print(nbr_calibrated); Serial.print(F(" of ")); Serial.println(vector_of_ids.size());
+  apply_profile(start_profile);
+  Serial.println(F("send 'f' for the fast profile, 's' for the slow one"));
   Serial.println();
+
+  millis_last_measurement = millis() - crrt_profile.measurement_period_ms;
 }
 
 
 void loop(void) {
-  Serial.println(F("measure all sensors..."));
-  measure_all_sensors(vector_of_ids, vector_of_measurements);
-  Serial.println();
+  unsigned long const crrt_millis = millis();
+
+  // the resolution can only be written between conversions
+  read_profile_command();
+  if ((requested_profile != nullptr) && !thermistor_string.busy()){
+    apply_profile(*requested_profile);
+    requested_profile = nullptr;
+  }
+
+  if (!thermistor_string.busy() && (crrt_millis - millis_last_measurement >= crrt_profile.measurement_period_ms)){
+    if (thermistor_string.start_conversion(crrt_millis)){
+      millis_last_measurement = crrt_millis;
+    }
+  }
+
+  // never waits: at most one short bus transaction per call
+  if (thermistor_string.poll(crrt_millis)){
+    collect_measurements();
+    print_measurements();
+  }
+
+  // the rest of the work of the loop can go here
 }
@@ -0,0 +1,93 @@
+// check on a computer that the fused Z-Y-X rotation of kiss_clang_3d (euler_zyx_rotate and
+// euler_zyx_rotate_k, used by the recipe) gives the same as applying roll, then pitch, then yaw step
+// by step, on a grid of angles covering all the quadrants. Returns non zero on a mismatch:
+//
+//   g++ -O2 -std=c++11 -I../../../libraries/kiss_clang_3d/src fused_rotation_check.cpp ../../../libraries/kiss_clang_3d/src/kiss_clang_3d.cpp -o fused_rotation_check
+//   ./fused_rotation_check
+
+#include <cstdio>
+#include <cmath>
+
+#include "kiss_clang_3d.h"
+
+static constexpr float max_error_allowed {1.0e-4f};
+
+// the step by step reference rotations
+void apply_yaw(float &vx, float &vy, float &vz, float const &yaw_rad){
+  float vvx = vx;
+  float vvy = vy;
+  float vvz = vz;
+
+  float cy = cos(yaw_rad);
+  float sy = sin(yaw_rad);
+
+  vx =  cy * vvx - sy * vvy;
+  vy =  sy * vvx + cy * vvy;
+  vz = vvz;
+}
+
+void apply_pitch(float &vx, float &vy, float &vz, float const &pitch_rad){
+  float vvx = vx;
+  float vvy = vy;
+  float vvz = vz;
+
+  float cp = cos(pitch_rad);
+  float sp = sin(pitch_rad);
+
+  vx =  cp * vvx + sp * vvz;
+  vy =  vvy;
+  vz = -sp * vvx + cp * vvz;
+}
+
+void apply_roll(float & vx, float & vy, float & vz, float const &roll_rad){
+  float vvx = vx;
+  float vvy = vy;
+  float vvz = vz;
+
+  float cr = cos(roll_rad);
+  float sr = sin(roll_rad);
+
+  vx = vvx;
+  vy = cr * vvy - sr * vvz;
+  vz = sr * vvy + cr * vvz;
+}
+
+int main(){
+  float max_error {0.0f};
+
+  for (int ind_yaw=-4; ind_yaw<=4; ind_yaw++){
+    for (int ind_pitch=-4; ind_pitch<=4; ind_pitch++){
+      for (int ind_roll=-4; ind_roll<=4; ind_roll++){
+        float yaw = 0.77f * ind_yaw;
+        float pitch = 0.77f * ind_pitch;
+        float roll = 0.77f * ind_roll;
+
+        float vx {0.3f};
+        float vy {-1.2f};
+        float vz {9.81f};
+        vec3 v_in;
+        vec3 v_fused;
+        vec3_setter(&v_in, vx, vy, vz);
+
+        apply_roll(vx, vy, vz, roll);
+        apply_pitch(vx, vy, vz, pitch);
+        apply_yaw(vx, vy, vz, yaw);
+
+        euler_zyx_rotate(yaw, pitch, roll, &v_in, &v_fused);
+        float down = euler_zyx_rotate_k(pitch, roll, &v_in);
+
+        max_error = fmaxf(max_error, fabsf(v_fused.i - vx));
+        max_error = fmaxf(max_error, fabsf(v_fused.j - vy));
+        max_error = fmaxf(max_error, fabsf(v_fused.k - vz));
+        max_error = fmaxf(max_error, fabsf(down - vz));
+      }
+    }
+  }
+
+  printf("fused vs step by step rotation, max error: %.8f\n", max_error);
+  if (max_error >= max_error_allowed){
+    printf("ERROR fused rotation does not agree with step by step rotation\n");
+    return 1;
+  }
+  return 0;
+}
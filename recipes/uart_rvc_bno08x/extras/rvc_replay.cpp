@@ -0,0 +1,163 @@
+// replay a byte stream through the UART-RVC parser on a computer, and print the counters:
+//
+//   g++ -O2 -std=c++11 -I.. rvc_replay.cpp -o rvc_replay
+//   ./rvc_replay                  # synthetic stream with known faults, checks the exact counters
+//   ./rvc_replay capture.bin      # raw bytes captured from the BNO08x UART, only prints the counters
+//
+// the synthetic stream has stray 0xAA bytes before headers, a 0xAAAA inside a payload, corrupt and
+// lost frames, and a truncated frame at the end; it is fed in chunks of varying sizes, as the UART
+// interrupt would, and returns non zero if a frame or a counter is not the expected one.
+
+#include <cstdio>
+#include <vector>
+
+#include "rvc_parser.h"
+
+static constexpr size_t ring_size {512};
+static constexpr size_t max_nbr_frames_per_decode {8};
+
+static void set_checksum(std::vector<uint8_t> & frame){
+  uint8_t checksum {0};
+  for (size_t ind=2; ind<rvc_frame_length-1; ind++){
+    checksum += frame[ind];
+  }
+  frame[rvc_frame_length-1] = checksum;
+}
+
+static std::vector<uint8_t> make_frame(uint8_t const index){
+  int16_t const values[6] {static_cast<int16_t>(100 * index), static_cast<int16_t>(-50 * index), 1234, 10, -20, 1000};
+  std::vector<uint8_t> frame {rvc_header_byte, rvc_header_byte, index};
+  for (int16_t const value : values){
+    frame.push_back(static_cast<uint8_t>(value & 0xFF));
+    frame.push_back(static_cast<uint8_t>(static_cast<uint16_t>(value) >> 8));
+  }
+  frame.insert(frame.end(), {0, 0, 0, 0});
+  set_checksum(frame);
+  return frame;
+}
+
+// feed the stream by chunks, decoding in between; the indexes of the frames decoded are returned
+static std::vector<uint8_t> replay(std::vector<uint8_t> const & stream, RvcParserCounters & counters){
+  static RvcRingBuffer<ring_size> ring;
+  RvcParser<ring_size> parser{ring};
+  RvcFrame frames[max_nbr_frames_per_decode];
+  std::vector<uint8_t> indexes;
+
+  size_t position {0};
+  size_t chunk_size {1};
+  while (position < stream.size()){
+    for (size_t ind=0; (ind<chunk_size) && (position<stream.size()); ind++){
+      ring.push(stream[position++]);
+    }
+    chunk_size = (chunk_size % 37) + 5;
+
+    size_t nbr_frames;
+    while ((nbr_frames = parser.decode(frames, max_nbr_frames_per_decode)) != 0){
+      for (size_t ind=0; ind<nbr_frames; ind++){
+        indexes.push_back(frames[ind].index);
+      }
+    }
+  }
+
+  counters = parser.counters();
+  if (ring.overflow_bytes() != 0){
+    printf("ring buffer overflow: %u bytes\n", ring.overflow_bytes());
+  }
+  return indexes;
+}
+
+static void print_counters(RvcParserCounters const & counters){
+  printf("decoded %u, corrupt %u, dropped %u, bytes skipped %u\n", counters.frames_decoded,
+         counters.frames_corrupt, counters.frames_dropped, counters.bytes_skipped);
+}
+
+static int replay_capture(char const * const path){
+  FILE * const file = fopen(path, "rb");
+  if (file == nullptr){
+    printf("cannot open %s\n", path);
+    return 1;
+  }
+  std::vector<uint8_t> stream;
+  int byte;
+  while ((byte = fgetc(file)) != EOF){
+    stream.push_back(static_cast<uint8_t>(byte));
+  }
+  fclose(file);
+
+  RvcParserCounters counters;
+  replay(stream, counters);
+  printf("%zu bytes: ", stream.size());
+  print_counters(counters);
+  return 0;
+}
+
+static int replay_synthetic(void){
+  std::vector<uint8_t> stream {0x12, 0x34};
+  std::vector<uint8_t> expected_indexes;
+  uint32_t expected_skipped {2};
+
+  for (unsigned crrt_frame=0; crrt_frame<600; crrt_frame++){
+    uint8_t const index = static_cast<uint8_t>(crrt_frame);
+    std::vector<uint8_t> frame = make_frame(index);
+
+    if (crrt_frame % 50 == 7){
+      // lost before reaching the ring buffer
+      continue;
+    }
+    if (crrt_frame % 50 == 21){
+      // a bit flip in the payload: the 19 bytes are skipped, and the frame is missing
+      frame[5] ^= 0x01;
+      expected_skipped += rvc_frame_length;
+    }
+    else{
+      expected_indexes.push_back(index);
+    }
+    if (crrt_frame % 50 == 33){
+      // a stray 0xAA just before the header, seen as a header with a wrong checksum
+      stream.push_back(rvc_header_byte);
+      expected_skipped += 1;
+    }
+    if (crrt_frame % 50 == 40){
+      // a valid 0xAAAA inside the payload
+      frame[9] = rvc_header_byte;
+      frame[10] = rvc_header_byte;
+      set_checksum(frame);
+    }
+    stream.insert(stream.end(), frame.begin(), frame.end());
+  }
+
+  // truncated frame at the end, left in the ring buffer
+  stream.insert(stream.end(), {rvc_header_byte, rvc_header_byte, 0x00, 0x01});
+
+  RvcParserCounters counters;
+  std::vector<uint8_t> const indexes = replay(stream, counters);
+  print_counters(counters);
+
+  uint32_t const nbr_periods {600 / 50};
+  int nbr_errors {0};
+  auto check = [&nbr_errors](char const * const what, uint32_t const value, uint32_t const expected){
+    if (value != expected){
+      printf("ERROR %s: %u, expected %u\n", what, value, expected);
+      nbr_errors++;
+    }
+  };
+
+  check("frames decoded", counters.frames_decoded, static_cast<uint32_t>(expected_indexes.size()));
+  check("frames corrupt", counters.frames_corrupt, nbr_periods);
+  check("frames dropped", counters.frames_dropped, 2 * nbr_periods);
+  check("bytes skipped", counters.bytes_skipped, expected_skipped);
+  if (indexes != expected_indexes){
+    printf("ERROR the indexes of the frames decoded are not the expected ones\n");
+    nbr_errors++;
+  }
+
+  printf("%d errors\n", nbr_errors);
+  return (nbr_errors == 0) ? 0 : 1;
+}
+
+int main(int argc, char ** argv){
+  if (argc > 1){
+    return replay_capture(argv[1]);
+  }
+  return replay_synthetic();
+}
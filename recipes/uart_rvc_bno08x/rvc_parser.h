@@ -0,0 +1,187 @@
+#ifndef RVC_PARSER_H
+#define RVC_PARSER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// a parser for the UART-RVC output of the BNO08x, that does not depend on Arduino, so that it
+// can also be compiled and fed captured byte streams on a computer.
+//
+// in UART-RVC mode the BNO08x sends, at 100 Hz, 19 bytes frames:
+//   0xAA 0xAA | index | yaw | pitch | roll | acc x | acc y | acc z | 3 reserved | checksum
+// index is a uint8 counter incremented at each frame, angles are int16 little endian in 0.01 deg,
+// accelerations are int16 little endian in mg, and the checksum is the sum of the bytes from index
+// to the last reserved byte included, modulo 256.
+//
+// the bytes received are pushed into a single producer (the UART interrupt), single consumer (the
+// loop) lock free ring buffer, and the parser scans for the frames directly in the ring buffer.
+
+constexpr size_t rvc_frame_length {19};
+constexpr uint8_t rvc_header_byte {0xAA};
+
+//--------------------------------------------------------------------------------
+// lock free single producer single consumer ring buffer; N must be a power of 2. The indexes are
+// free running and only masked when accessing the buffer, so that full and empty are not ambiguous;
+// the producer only writes head, the consumer only writes tail.
+template <size_t N>
+class RvcRingBuffer{
+  static_assert((N != 0) && ((N & (N - 1)) == 0), "the ring buffer size must be a power of 2");
+
+  public:
+    // producer side, for example in the UART interrupt; if the buffer is full the byte is lost,
+    // and counted in overflow_bytes
+    bool push(uint8_t const byte){
+      uint32_t const crrt_head = head.load(std::memory_order_relaxed);
+      if (crrt_head - tail.load(std::memory_order_acquire) >= N){
+        nbr_overflow_bytes.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      buffer[crrt_head & mask] = byte;
+      head.store(crrt_head + 1, std::memory_order_release);
+      return true;
+    }
+
+    // consumer side
+    size_t available(void) const{
+      return head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed);
+    }
+
+    // the byte at position offset from the oldest one, without consuming it; offset < available()
+    uint8_t peek(size_t const offset) const{
+      return buffer[(tail.load(std::memory_order_relaxed) + offset) & mask];
+    }
+
+    // drop the nbr_bytes oldest bytes; nbr_bytes <= available()
+    void consume(size_t const nbr_bytes){
+      tail.store(tail.load(std::memory_order_relaxed) + nbr_bytes, std::memory_order_release);
+    }
+
+    uint32_t overflow_bytes(void) const{
+      return nbr_overflow_bytes.load(std::memory_order_relaxed);
+    }
+
+  private:
+    static constexpr uint32_t mask {N - 1};
+
+    uint8_t buffer[N];
+    std::atomic<uint32_t> head {0};
+    std::atomic<uint32_t> tail {0};
+    std::atomic<uint32_t> nbr_overflow_bytes {0};
+};
+
+//--------------------------------------------------------------------------------
+// a decoded frame, with the raw values as sent by the sensor; packed so that arrays of frames
+// are as small as possible, use the functions under to convert to physical units
+struct __attribute__((packed)) RvcFrame{
+  uint8_t index;
+  int16_t yaw;    // 0.01 deg
+  int16_t pitch;  // 0.01 deg
+  int16_t roll;   // 0.01 deg
+  int16_t acc_x;  // mg
+  int16_t acc_y;  // mg
+  int16_t acc_z;  // mg
+};
+
+static_assert(sizeof(RvcFrame) == 13, "RvcFrame should be packed");
+
+inline float rvc_angle_deg(int16_t const raw){
+  return 0.01f * raw;
+}
+
+inline float rvc_acc_ms2(int16_t const raw){
+  return (9.80665f / 1000.0f) * raw;
+}
+
+//--------------------------------------------------------------------------------
+struct RvcParserCounters{
+  uint32_t frames_decoded {0};
+  // frames with a header but a wrong checksum: a header with a wrong checksum may also be a stray
+  // 0xAA before a real header, or a 0xAAAA inside a payload, so that these resync candidates are only
+  // counted as corrupt frames, at most one per missing index, once the next frame is decoded
+  uint32_t frames_corrupt {0};
+  // frames missing from the index sequence, whatever the reason (corrupt, bytes lost before reaching
+  // the ring buffer, or ring buffer overflow); the index is a uint8, so gaps of 256 frames or more
+  // (2.56 s at 100 Hz) are only counted modulo 256
+  uint32_t frames_dropped {0};
+  // bytes skipped while looking for a frame header, including the first byte of each resync candidate
+  uint32_t bytes_skipped {0};
+};
+
+template <size_t N>
+class RvcParser{
+  public:
+    explicit RvcParser(RvcRingBuffer<N> & ring): ring(ring) {}
+
+    // decode up to max_nbr_frames frames from the ring buffer into frames_out, and return the
+    // number of frames decoded; the bytes of an incomplete frame are left in the ring buffer
+    size_t decode(RvcFrame * const frames_out, size_t const max_nbr_frames){
+      size_t nbr_frames {0};
+
+      while ((nbr_frames < max_nbr_frames) && (ring.available() >= rvc_frame_length)){
+        if ((ring.peek(0) != rvc_header_byte) || (ring.peek(1) != rvc_header_byte)){
+          ring.consume(1);
+          crrt_counters.bytes_skipped++;
+          continue;
+        }
+
+        uint8_t checksum {0};
+        for (size_t ind=2; ind<rvc_frame_length-1; ind++){
+          checksum += ring.peek(ind);
+        }
+
+        // a wrong checksum may also be a 0xAAAA inside the payload, so only skip the first header
+        // byte and look for a header again
+        if (checksum != ring.peek(rvc_frame_length-1)){
+          ring.consume(1);
+          crrt_counters.bytes_skipped++;
+          if (nbr_resync_candidates < UINT8_MAX){
+            nbr_resync_candidates++;
+          }
+          continue;
+        }
+
+        RvcFrame & frame = frames_out[nbr_frames];
+        frame.index = ring.peek(2);
+        frame.yaw = peek_int16(3);
+        frame.pitch = peek_int16(5);
+        frame.roll = peek_int16(7);
+        frame.acc_x = peek_int16(9);
+        frame.acc_y = peek_int16(11);
+        frame.acc_z = peek_int16(13);
+        ring.consume(rvc_frame_length);
+
+        if (has_last_index){
+          uint8_t const nbr_missing = static_cast<uint8_t>(frame.index - last_index - 1);
+          crrt_counters.frames_dropped += nbr_missing;
+          crrt_counters.frames_corrupt += (nbr_resync_candidates < nbr_missing) ? nbr_resync_candidates : nbr_missing;
+        }
+        nbr_resync_candidates = 0;
+        last_index = frame.index;
+        has_last_index = true;
+
+        crrt_counters.frames_decoded++;
+        nbr_frames++;
+      }
+
+      return nbr_frames;
+    }
+
+    RvcParserCounters const & counters(void) const{
+      return crrt_counters;
+    }
+
+  private:
+    int16_t peek_int16(size_t const offset) const{
+      return static_cast<int16_t>(static_cast<uint16_t>(ring.peek(offset)) | (static_cast<uint16_t>(ring.peek(offset + 1)) << 8));
+    }
+
+    RvcRingBuffer<N> & ring;
+    RvcParserCounters crrt_counters {};
+    uint8_t last_index {0};
+    bool has_last_index {false};
+    // headers with a wrong checksum since the last frame decoded
+    uint8_t nbr_resync_candidates {0};
+};
+
+#endif
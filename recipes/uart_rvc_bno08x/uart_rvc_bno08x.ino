@@ -1,53 +1,40 @@
-/* Test sketch for Adafruit BNO08x sensor in UART-RVC mode */
+/* Test sketch for Adafruit BNO08x sensor in UART-RVC mode, with our own frame parser */
 
 #include "Arduino.h"
-#include "Adafruit_BNO08x_RVC.h"
-
-// our communications and object for receiving these
-Adafruit_BNO08x_RVC rvc = Adafruit_BNO08x_RVC();
-BNO08x_RVC_Data heading;
+#include <kiss_clang_3d.h>
+#include "rvc_parser.h"
 
 // our current bno serial
 Uart serial_bno_vcr{1, 9, 8};
 
-// a few helper functions for doing rotations
-void apply_yaw(float &vx, float &vy, float &vz, float const &yaw_rad){
-  float vvx = vx;
-  float vvy = vy;
-  float vvz = vz;
-
-  float cy = cos(yaw_rad);
-  float sy = sin(yaw_rad);
-
-  vx =  cy * vvx - sy * vvy;
-  vy =  sy * vvx + cy * vvy;
-  vz = vvz;
-}
-
-void apply_pitch(float &vx, float &vy, float &vz, float const &pitch_rad){
-  float vvx = vx;
-  float vvy = vy;
-  float vvz = vz;
-
-  float cp = cos(pitch_rad);
-  float sp = sin(pitch_rad);
-
-  vx =  cp * vvx + sp * vvz;
-  vy =  vvy;
-  vz = -sp * vvx + cp * vvz;
-}
-
-void apply_roll(float & vx, float & vy, float & vz, float const &roll_rad){
-  float vvx = vx;
-  float vvy = vy;
-  float vvz = vz;
-
-  float cr = cos(roll_rad);
-  float sr = sin(roll_rad);
-
-  vx = vvx;
-  vy = cr * vvy - sr * vvz;
-  vz = sr * vvy + cr * vvz;
+// the bytes received go into a ring buffer, in which the parser looks for the frames; 512 bytes
+// is about 250 ms of data at 100 Hz, and up to 8 frames are decoded per call
+RvcRingBuffer<512> rvc_ring;
+RvcParser<512> rvc_parser{rvc_ring};
+constexpr size_t max_nbr_frames_per_decode {8};
+RvcFrame rvc_frames[max_nbr_frames_per_decode];
+
+// the last frame, in physical units (deg and m/s2)
+struct{
+  float yaw;
+  float pitch;
+  float roll;
+  float x_accel;
+  float y_accel;
+  float z_accel;
+} heading;
+
+// print the parser counters at this interval
+constexpr unsigned long counters_print_interval_ms {10000};
+unsigned long timestamp_counters_print;
+
+// move the bytes received by the UART into the ring buffer; the Apollo3 core owns the UART
+// interrupt and buffers the bytes there, so this is called from the loop, but RvcRingBuffer::push
+// is interrupt safe and could be called directly from a UART interrupt
+void pump_uart_into_ring(void){
+  while (serial_bno_vcr.available()){
+    rvc_ring.push(static_cast<uint8_t>(serial_bno_vcr.read()));
+  }
 }
 
 // our yaw, pitch, roll, accx, accy, accz variables
@@ -58,6 +45,17 @@ float accx;
 float accy;
 float accz;
 
+// the orientation of the sensor; the rotation matrix is built once per frame, on the first
+// vector transformed, and then each vector costs 9 multiply adds
+orientation sensor_orientation;
+vec3 acc_imu;
+vec3 acc_init;
+float acc_down;
+
+// rotate the full acceleration vector into the initial frame of reference and print it; if not,
+// only the down component is computed, which does not need the yaw
+constexpr bool print_acc_init {false};
+
 // a few constants
 float twopi = 6.283185307179586;
 
@@ -75,21 +73,49 @@ void setup() {
   while (!serial_bno_vcr)
     delay(10);
 
-  if (!rvc.begin(&serial_bno_vcr)) { // connect to the sensor over hardware serial
-    Serial.println("Could not find BNO08x!");
-    while (1)
-      delay(10);
+  // wait for the first valid frame, to check that the sensor is there
+  while (true){
+    pump_uart_into_ring();
+    if (rvc_parser.decode(rvc_frames, 1) == 1){
+      break;
+    }
+    delay(1);
   }
 
   Serial.println("BNO08x found!");
+
+  orientation_init(&sensor_orientation);
+  timestamp_counters_print = millis();
 }
 
 void loop() {
+  pump_uart_into_ring();
 
-  while (!rvc.read(&heading)) {
-    ;
+  size_t nbr_frames = rvc_parser.decode(rvc_frames, max_nbr_frames_per_decode);
+  for (size_t ind=0; ind<nbr_frames; ind++){
+    process_frame(rvc_frames[ind]);
   }
 
+  if (millis() - timestamp_counters_print >= counters_print_interval_ms){
+    timestamp_counters_print += counters_print_interval_ms;
+
+    RvcParserCounters const & counters = rvc_parser.counters();
+    Serial.print(F("RVC frames decoded: ")); Serial.print(counters.frames_decoded);
+    Serial.print(F(" | corrupt: ")); Serial.print(counters.frames_corrupt);
+    Serial.print(F(" | dropped: ")); Serial.print(counters.frames_dropped);
+    Serial.print(F(" | bytes skipped: ")); Serial.print(counters.bytes_skipped);
+    Serial.print(F(" | ring overflow bytes: ")); Serial.println(rvc_ring.overflow_bytes());
+  }
+}
+
+void process_frame(RvcFrame const & frame){
+  heading.yaw = rvc_angle_deg(frame.yaw);
+  heading.pitch = rvc_angle_deg(frame.pitch);
+  heading.roll = rvc_angle_deg(frame.roll);
+  heading.x_accel = rvc_acc_ms2(frame.acc_x);
+  heading.y_accel = rvc_acc_ms2(frame.acc_y);
+  heading.z_accel = rvc_acc_ms2(frame.acc_z);
+
   // in raw coords
   /*
   Serial.print(F("Y: "));
@@ -139,23 +165,30 @@ void loop() {
   // question: in which order?
   
   
-  apply_roll(accx, accy, accz, roll_rad);
-  apply_pitch(accx, accy, accz, pitch_rad); 
-  apply_yaw(accx, accy, accz, yaw_rad);
+  // roll, then pitch, then yaw
+  vec3_setter(&acc_imu, accx, accy, accz);
+
+  if (print_acc_init){
+    orientation_set_euler_zyx(&sensor_orientation, yaw_rad, pitch_rad, roll_rad);
+    orientation_rotate(&sensor_orientation, &acc_imu, &acc_init);
+    acc_down = acc_init.k;
+
+    // in the initial frame of reference
+    Serial.print(F("Yaw: "));
+    Serial.print(yaw_rad * 360.0f / twopi);
+    Serial.print(F(" Pitch: "));
+    Serial.print(pitch_rad * 360.0f / twopi);
+    Serial.print(F(" Roll: "));
+    Serial.print(roll_rad * 360.0f / twopi);
+    Serial.print(F(" || acc x init: "));
+    Serial.print(acc_init.i, 2);
+    Serial.print(F(" | acc y init: "));
+    Serial.print(acc_init.j, 2);
+  }
+  else{
+    acc_down = euler_zyx_rotate_k(pitch_rad, roll_rad, &acc_imu);
+  }
 
- /*
-  // in the initial frame of reference
-  Serial.print(F("Yaw: "));
-  Serial.print(yaw_rad * 360.0f / twopi);
-  Serial.print(F(" Pitch: "));
-  Serial.print(pitch_rad * 360.0f / twopi);
-  Serial.print(F(" Roll: "));
-  Serial.print(roll_rad * 360.0f / twopi);
-  Serial.print(F(" || acc x init: "));
-  Serial.print(accx, 2);
-  Serial.print(F(" | acc y init: "));
-  Serial.print(accy, 2);
-  */
   Serial.print(F(" | acc down: "));
-  Serial.println(accz, 2);
+  Serial.println(acc_down, 2);
 }